@@ -0,0 +1,131 @@
+#include "mcc/misc/Channel.h"
+#include "mcc/misc/RingChannel.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using mcc::misc::Channel;
+using mcc::misc::RingChannel;
+
+static const std::size_t messagesPerProducer = 100000;
+
+// one consumer thread drains everything the producers send, the benchmark
+// measures wall time from the first send to the last recv
+template <typename C>
+static void runProducers(C* channel, int producers)
+{
+    std::thread consumer([channel, producers]() {
+        std::size_t total = messagesPerProducer * producers;
+        for (std::size_t i = 0; i < total; i++) {
+            channel->recv();
+        }
+    });
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([channel]() {
+            for (std::size_t i = 0; i < messagesPerProducer; i++) {
+                channel->send(i);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    consumer.join();
+}
+
+static void mutexChannel(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        Channel<std::uint64_t> channel;
+        runProducers(&channel, state.range_x());
+    }
+    state.SetItemsProcessed(state.iterations() * messagesPerProducer * state.range_x());
+}
+
+// producers send batches of 16 with sendBatch, the consumer drains with recvAllFor
+static void mutexChannelBatch(benchmark::State& state)
+{
+    int producers = state.range_x();
+    while (state.KeepRunning()) {
+        Channel<std::uint64_t> channel;
+        std::thread consumer([&channel, producers]() {
+            std::vector<std::uint64_t> batch;
+            batch.reserve(256);
+            std::size_t total = messagesPerProducer * producers;
+            std::size_t count = 0;
+            while (count < total) {
+                batch.clear();
+                count += channel.recvAllFor(&batch, 256, std::chrono::milliseconds(100));
+            }
+        });
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&channel]() {
+                std::vector<std::uint64_t> batch;
+                for (std::size_t i = 0; i < messagesPerProducer; i++) {
+                    batch.push_back(i);
+                    if (batch.size() == 16) {
+                        channel.sendBatch(std::move(batch));
+                    }
+                }
+                channel.sendBatch(std::move(batch));
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        consumer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * messagesPerProducer * producers);
+}
+
+static void ringChannel(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        RingChannel<std::uint64_t> channel(4096);
+        runProducers(&channel, state.range_x());
+    }
+    state.SetItemsProcessed(state.iterations() * messagesPerProducer * state.range_x());
+}
+
+static void ringChannelBatch(benchmark::State& state)
+{
+    int producers = state.range_x();
+    while (state.KeepRunning()) {
+        RingChannel<std::uint64_t> channel(4096);
+        std::thread consumer([&channel, producers]() {
+            std::vector<std::uint64_t> batch;
+            batch.reserve(256);
+            std::size_t total = messagesPerProducer * producers;
+            std::size_t count = 0;
+            while (count < total) {
+                batch.clear();
+                count += channel.recvAllFor(&batch, 256, std::chrono::milliseconds(100));
+            }
+        });
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++) {
+            threads.emplace_back([&channel]() {
+                for (std::size_t i = 0; i < messagesPerProducer; i++) {
+                    channel.send(i);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        consumer.join();
+    }
+    state.SetItemsProcessed(state.iterations() * messagesPerProducer * producers);
+}
+
+BENCHMARK(mutexChannel)->Arg(1)->Arg(4)->Arg(16)->UseRealTime();
+BENCHMARK(mutexChannelBatch)->Arg(1)->Arg(4)->Arg(16)->UseRealTime();
+BENCHMARK(ringChannel)->Arg(1)->Arg(4)->Arg(16)->UseRealTime();
+BENCHMARK(ringChannelBatch)->Arg(1)->Arg(4)->Arg(16)->UseRealTime();
+
+BENCHMARK_MAIN();
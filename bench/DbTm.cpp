@@ -0,0 +1,113 @@
+#include "mcc/core/db/DbHandle.h"
+#include "mcc/core/db/queries/TmParamList.h"
+
+#include <benchmark/benchmark.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QTemporaryFile>
+
+#include <string>
+
+using namespace mcc::messages;
+using mcc::misc::NetVariant;
+using mcc::core::db::DbHandle;
+
+static const int frameSize = 40;
+static const char* traits[] = {"navigation", "power", "engine", "payload"};
+
+// the part of the mcc schema the telemetry insert touches
+static const char* schema =
+    "CREATE TABLE device (id integer PRIMARY KEY NOT NULL, name text UNIQUE NOT NULL, firmware_id integer);\n"
+    "CREATE TABLE trait (id integer PRIMARY KEY NOT NULL, firmware_id integer, unique_name text NOT NULL, UNIQUE(firmware_id, unique_name));\n"
+    "CREATE TABLE trait_field (id integer PRIMARY KEY NOT NULL, trait_id integer NOT NULL, name text NOT NULL);\n"
+    "CREATE TABLE mcc_tm (id integer PRIMARY KEY NOT NULL, device_id integer NOT NULL, param_id integer NOT NULL, time text NOT NULL, value text NOT NULL);\n";
+
+static DbHandle* db;
+
+static void fillFirmware()
+{
+    QSqlQuery query = db->getQueryHandle();
+    query.exec("insert into device (name, firmware_id) values ('uav', 1)");
+    for (int t = 0; t < 4; t++) {
+        query.exec(QString("insert into trait (id, firmware_id, unique_name) values (%1, 1, '%2')").arg(t + 1).arg(traits[t]));
+        for (int i = t; i < frameSize; i += 4)
+            query.exec(QString("insert into trait_field (trait_id, name) values (%1, 'status%2')").arg(t + 1).arg(i));
+    }
+}
+
+static TmParams makeFrame()
+{
+    TmParams params;
+    for (int i = 0; i < frameSize; i++)
+        params.emplace_back(traits[i % 4], "status" + std::to_string(i), NetVariant(i * 0.25));
+    return params;
+}
+
+// the insert used before ids were cached: two subqueries and a separate statement per value
+static void legacyInsert(benchmark::State& state)
+{
+    QSqlQuery query = db->getQueryHandle();
+    query.prepare("insert into mcc_tm (time, value, device_id, param_id) "
+                  "values (:time, :value, (select id from device where name = :device), "
+                  "(select trait_field.id from trait, trait_field "
+                  "where trait.firmware_id = (select firmware_id from device where name = :device) "
+                  "and trait.unique_name = :trait and trait_field.trait_id = trait.id and trait_field.name = :name))");
+    TmParams params = makeFrame();
+    db->transaction();
+    while (state.KeepRunning()) {
+        TmParamList list("uav", params);
+        for (const auto& p : list.params()) {
+            query.bindValue(":device", QString::fromStdString(list.device()));
+            query.bindValue(":trait", QString::fromStdString(p.trait()));
+            query.bindValue(":name", QString::fromStdString(p.status()));
+            query.bindValue(":value", p.value().toQVariant());
+            query.bindValue(":time", QString::fromStdString(mcc::misc::formatTimestamp(list.time())));
+            mcc::core::db::execInsert(query, false);
+        }
+    }
+    db->commit();
+    state.SetItemsProcessed(state.iterations() * params.size());
+}
+BENCHMARK(legacyInsert);
+
+static void cachedBatchInsert(benchmark::State& state)
+{
+    mcc::core::db::queries::TmParamList query(db);
+    TmParamsPtr params = std::make_shared<const TmParams>(makeFrame());
+    db->transaction();
+    while (state.KeepRunning()) {
+        query.execute(std::unique_ptr<TmParamList>(new TmParamList("uav", params)));
+    }
+    query.flush();
+    db->commit();
+    state.SetItemsProcessed(state.iterations() * params->size());
+}
+BENCHMARK(cachedBatchInsert);
+
+int main(int argc, const char** argv)
+{
+    int qtArgc = 1;
+    char* qtArgv[] = {const_cast<char*>(argv[0]), nullptr};
+    QCoreApplication app(qtArgc, qtArgv);
+
+    QTemporaryFile schemaFile;
+    schemaFile.open();
+    schemaFile.write(schema);
+    schemaFile.close();
+    QString path = QDir::temp().filePath("mcc-dbtm-bench.sqlite");
+
+    DbHandle handle;
+    if (!handle.create(path, schemaFile.fileName()))
+        return 1;
+    handle.speedupSqlite();
+    db = &handle;
+    fillFirmware();
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+
+    handle.stop();
+    QFile::remove(path);
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "mcc/misc/NetVariant.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using mcc::misc::NetVariant;
+
+static std::vector<NetVariant> makeValues(int kind)
+{
+    std::vector<NetVariant> values;
+    for (int i = 0; i < 1024; i++) {
+        switch (kind) {
+        case 0:
+            values.emplace_back(std::int64_t(i));
+            break;
+        case 1:
+            values.emplace_back(i * 0.5);
+            break;
+        case 2:
+            values.emplace_back("status" + std::to_string(i));
+            break;
+        default:
+            values.emplace_back(std::string(64, 'a') + std::to_string(i));
+            break;
+        }
+    }
+    return values;
+}
+
+static const char* kindName(int kind)
+{
+    const char* names[] = {"int", "double", "small string", "long string"};
+    return names[kind];
+}
+
+static void copyValues(benchmark::State& state)
+{
+    std::vector<NetVariant> values = makeValues(state.range_x());
+    std::vector<NetVariant> dest(values.size());
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < values.size(); i++) {
+            dest[i] = values[i];
+        }
+        benchmark::DoNotOptimize(dest.data());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+    state.SetLabel(kindName(state.range_x()));
+}
+
+static void moveValues(benchmark::State& state)
+{
+    std::vector<NetVariant> values = makeValues(state.range_x());
+    std::vector<NetVariant> dest(values.size());
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < values.size(); i++) {
+            dest[i] = std::move(values[i]);
+        }
+        values.swap(dest);
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+    state.SetLabel(kindName(state.range_x()));
+}
+
+static void toDouble(benchmark::State& state)
+{
+    std::vector<NetVariant> values;
+    for (int i = 0; i < 1024; i++) {
+        switch (i % 4) {
+        case 0: values.emplace_back(std::int64_t(-i)); break;
+        case 1: values.emplace_back(std::uint64_t(i)); break;
+        case 2: values.emplace_back(float(i)); break;
+        case 3: values.emplace_back(double(i)); break;
+        }
+    }
+    while (state.KeepRunning()) {
+        double sum = 0;
+        for (const NetVariant& value : values) {
+            sum += value.toDouble();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+static void toUint(benchmark::State& state)
+{
+    std::vector<NetVariant> values;
+    for (int i = 0; i < 1024; i++) {
+        switch (i % 3) {
+        case 0: values.emplace_back(bool(i & 8)); break;
+        case 1: values.emplace_back(std::int64_t(i)); break;
+        case 2: values.emplace_back(std::uint64_t(i)); break;
+        }
+    }
+    while (state.KeepRunning()) {
+        std::uint64_t sum = 0;
+        for (const NetVariant& value : values) {
+            sum += value.toUint();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+BENCHMARK(copyValues)->DenseRange(0, 3);
+BENCHMARK(moveValues)->DenseRange(0, 3);
+BENCHMARK(toDouble);
+BENCHMARK(toUint);
+
+BENCHMARK_MAIN();
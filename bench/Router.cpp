@@ -0,0 +1,81 @@
+#include "mcc/messages/LocalRouter.h"
+#include "mcc/messages/MessageSender.h"
+#include "mcc/messages/Device.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <thread>
+
+using namespace mcc::messages;
+
+static MessagePtr makePing()
+{
+    return MessagePtr(new DeviceActionLog("kind", "name", "ping"));
+}
+
+// "echo" returns every message back to "ping", the benchmark measures the round trip.
+// Senders are created by makeSender, the forwarder (if any) is started by the caller.
+template <typename F>
+static void pingPong(benchmark::State& state, LocalRouter* router, F makeSender)
+{
+    auto pingIn = router->recv("ping");
+    auto echoIn = router->recv("echo");
+    MessageSender ping = makeSender("ping");
+    MessageSender echo = makeSender("echo");
+
+    std::thread echoThread([&]() {
+        while (true) {
+            auto message = echoIn->recv();
+            if (message.isNone()) {
+                return;
+            }
+            echo->sendTo("ping", message.take());
+        }
+    });
+
+    while (state.KeepRunning()) {
+        ping->sendTo("echo", makePing());
+        pingIn->recv();
+    }
+    echoIn->close();
+    echoThread.join();
+    state.SetItemsProcessed(state.iterations());
+}
+
+// sender -> destination queue
+static void oneHop(benchmark::State& state)
+{
+    LocalRouter router;
+    router.add("ping");
+    router.add("echo");
+    pingPong(state, &router, [&router](const std::string& name) { return router.send(name); });
+}
+
+// sender -> router queue -> router thread -> destination queue, as before direct senders
+static void twoHops(benchmark::State& state)
+{
+    LocalRouter router;
+    router.add("ping");
+    router.add("echo");
+    MessageQueue in = std::make_shared<MessageQueue::element_type>();
+    std::thread routerThread([&]() {
+        while (true) {
+            auto message = in->recv();
+            if (message.isNone()) {
+                return;
+            }
+            MessagePtr m = message.take();
+            std::string receiver = m->receiver();
+            router.deliver(receiver, std::move(m));
+        }
+    });
+    pingPong(state, &router, [&in](const std::string& name) { return std::make_shared<MessageSenderX>(name, in); });
+    in->close();
+    routerThread.join();
+}
+
+BENCHMARK(oneHop)->UseRealTime();
+BENCHMARK(twoHops)->UseRealTime();
+
+BENCHMARK_MAIN();
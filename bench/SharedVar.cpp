@@ -0,0 +1,80 @@
+#include "mcc/misc/SharedVar.h"
+#include "mcc/misc/SnapshotVar.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+using namespace mcc::misc;
+
+static const std::uint64_t valuesPerIteration = 100000;
+
+// telemetry-like state, large enough that copying it is not free
+struct State {
+    State()
+    {
+        for (double& value : values) {
+            value = 0;
+        }
+    }
+
+    double values[16];
+};
+
+// writer publishes valuesPerIteration states while a reader polls as fast as it can,
+// reads are not counted, only the writer progress is measured
+static void sharedVar(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        SharedVarPtr<State> var = makeSharedVar<State>();
+        // SharedVar hands every value over, so a negative value reliably stops the reader
+        std::thread reader([var]() {
+            SharedVarReader<State> reader(var);
+            while (true) {
+                SharedVarReaderLock<State> lock = reader.lock();
+                if (lock->values[0] < 0) {
+                    return;
+                }
+            }
+        });
+        SharedVarWriter<State> writer(var);
+        for (std::uint64_t i = 0; i < valuesPerIteration; i++) {
+            SharedVarWriterLock<State> lock = writer.lock();
+            lock->values[0] = i;
+        }
+        {
+            SharedVarWriterLock<State> lock = writer.lock();
+            lock->values[0] = -1;
+        }
+        reader.join();
+    }
+    state.SetItemsProcessed(state.iterations() * valuesPerIteration);
+}
+
+static void snapshotVar(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        SnapshotVarPtr<State> var = makeSnapshotVar<State>();
+        std::atomic<bool> isDone(false);
+        std::thread reader([var, &isDone]() {
+            while (!isDone) {
+                benchmark::DoNotOptimize(var->read().values[0]);
+            }
+        });
+        for (std::uint64_t i = 0; i < valuesPerIteration; i++) {
+            State& value = var->writeBuffer();
+            value.values[0] = i;
+            var->publish();
+        }
+        isDone = true;
+        reader.join();
+    }
+    state.SetItemsProcessed(state.iterations() * valuesPerIteration);
+}
+
+BENCHMARK(sharedVar)->UseRealTime();
+BENCHMARK(snapshotVar)->UseRealTime();
+
+BENCHMARK_MAIN();
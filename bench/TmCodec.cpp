@@ -0,0 +1,113 @@
+#include "mcc/messages/Tm.h"
+#include "mcc/messages/TmCodec.h"
+#include "mcc/messages/protobuf/Tm.pb.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+using namespace mcc::messages;
+using mcc::misc::NetVariant;
+
+// a typical frame: a few traits, mostly doubles, some integers and a status string
+static TmParams makeFrame(int count)
+{
+    const char* traits[] = {"navigation", "power", "engine", "payload"};
+    TmParams params;
+    for (int i = 0; i < count; i++) {
+        std::string status = "status" + std::to_string(i);
+        switch (i % 8) {
+        case 0:
+            params.emplace_back(traits[i % 4], status, NetVariant(std::int64_t(i)));
+            break;
+        case 1:
+            params.emplace_back(traits[i % 4], status, NetVariant(std::uint64_t(i)));
+            break;
+        case 2:
+            params.emplace_back(traits[i % 4], status, NetVariant("ok"));
+            break;
+        default:
+            params.emplace_back(traits[i % 4], status, NetVariant(i * 0.25));
+        }
+    }
+    return params;
+}
+
+static void encodePerValue(const TmParams& params, mcc::protobuf::TmParamList* list)
+{
+    list->Clear();
+    list->set_device("device");
+    for (const auto& i : params) {
+        auto p = list->add_params();
+        p->set_trait(i.trait());
+        p->set_status(i.status());
+        p->set_value(i.value().serialize());
+    }
+}
+
+static void perValueEncode(benchmark::State& state)
+{
+    TmParams params = makeFrame(state.range_x());
+    mcc::protobuf::TmParamList list;
+    std::string buffer;
+    while (state.KeepRunning()) {
+        encodePerValue(params, &list);
+        buffer.clear();
+        list.AppendToString(&buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * params.size());
+    state.SetLabel(std::to_string(buffer.size()) + " bytes");
+}
+
+static void perValueDecode(benchmark::State& state)
+{
+    TmParams params = makeFrame(state.range_x());
+    mcc::protobuf::TmParamList list;
+    encodePerValue(params, &list);
+    std::string buffer = list.SerializeAsString();
+    while (state.KeepRunning()) {
+        list.ParseFromString(buffer);
+        TmParams decoded;
+        decoded.reserve(list.params().size());
+        for (const auto& i : list.params()) {
+            bmcl::MemReader reader((const uint8_t*)i.value().data(), i.value().size());
+            decoded.emplace_back(i.trait(), i.status(), NetVariant::deserialize(&reader).take());
+        }
+        benchmark::DoNotOptimize(decoded.data());
+    }
+    state.SetItemsProcessed(state.iterations() * params.size());
+}
+
+static void columnEncode(benchmark::State& state)
+{
+    TmParams params = makeFrame(state.range_x());
+    std::string buffer;
+    while (state.KeepRunning()) {
+        buffer.clear();
+        TmCodec::encode(params, &buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * params.size());
+    state.SetLabel(std::to_string(buffer.size()) + " bytes");
+}
+
+static void columnDecode(benchmark::State& state)
+{
+    TmParams params = makeFrame(state.range_x());
+    std::string buffer;
+    TmCodec::encode(params, &buffer);
+    while (state.KeepRunning()) {
+        bmcl::MemReader reader((const uint8_t*)buffer.data(), buffer.size());
+        auto decoded = TmCodec::decode(&reader);
+        benchmark::DoNotOptimize(decoded.unwrap().data());
+    }
+    state.SetItemsProcessed(state.iterations() * params.size());
+}
+
+BENCHMARK(perValueEncode)->Arg(10)->Arg(40)->Arg(200);
+BENCHMARK(columnEncode)->Arg(10)->Arg(40)->Arg(200);
+BENCHMARK(perValueDecode)->Arg(10)->Arg(40)->Arg(200);
+BENCHMARK(columnDecode)->Arg(10)->Arg(40)->Arg(200);
+
+BENCHMARK_MAIN();
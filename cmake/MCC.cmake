@@ -111,6 +111,11 @@ else()
     set(_MCC_COMPILE_FLAGS ${CMAKE_CXX_FLAGS})
 endif()
 
+# message latency histograms and counters (mcc/messages/Trace.h)
+if (MCC_ENABLE_TRACING)
+    set(_MCC_COMPILE_FLAGS "${_MCC_COMPILE_FLAGS} -DMCC_TRACING")
+endif()
+
 if(MINGW)
     set(_MCC_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} -Wl,--as-needed")
 elseif(UNIX)
@@ -16,6 +16,7 @@ namespace mcc {
         static const char* coreTm()         { return "mcc.core.tm"; }
         static const char* coreManager()    { return "mcc.core.manager"; }
         static const char* coreRouter()     { return "mcc.core.router"; }
+        static const char* coreReplay()     { return "mcc.core.replay"; }
         static const char* ui()             { return "mcc.ui"; }
         static const char* model()          { return "mcc.model"; }
         static const char* model1()         { return "mcc.model1"; }
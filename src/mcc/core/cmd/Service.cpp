@@ -16,13 +16,17 @@ namespace mcc {
 namespace core {
 namespace cmd {
 
-Service::Command::Command(const std::string& from, const std::string& registered, const mcc::messages::Cmd& cmd)
+Service::Command::Command(mcc::misc::NameId from, mcc::misc::Timestamp registered, const mcc::messages::Cmd& cmd)
     :_from(from), _registered(registered), _state(mcc::misc::CmdState::Registered)
 {
 }
 
 Service::Service(const mcc::messages::LocalRouterPtr& router) : mcc::messages::ServiceAbstract(mcc::Names::coreCmd(), router)
 {
+    handle<mcc::messages::Cmd>();
+    handle<mcc::messages::CmdCancel>();
+    handle<mcc::messages::CmdState>();
+    handle<mcc::messages::CmdSubscribe_Request>();
 }
 
 Service::~Service()
@@ -40,14 +44,14 @@ void Service::process(std::unique_ptr<mcc::messages::Cmd>&& cmd)
     }
 
     Q_ASSERT(dev->second._cmds.find(cmd->cmdId()) == dev->second._cmds.end());
-    dev->second._cmds.emplace(cmd->cmdId(), Command(cmd->sender(), cmd->time(), *cmd));
+    dev->second._cmds.emplace(cmd->cmdId(), Command(cmd->senderId(), cmd->time(), *cmd));
     if (dev->second._cmds.size() > _CmdsLimit)
     {
         _out->sendTo<mcc::messages::CmdState>(cmd->sender(), *cmd, mcc::messages::CmdState::Value::Failed, "too many commands waiting");
         return;
     }
 
-    if (dev->second._exchanger.empty())
+    if (dev->second._exchanger == mcc::misc::NameTable::emptyId)
     {
         _out->sendTo<mcc::messages::CmdState>(cmd->sender(), *cmd, mcc::messages::CmdState::Value::Failed, "exchanger for device is not set");
         return;
@@ -104,7 +108,7 @@ void Service::process(std::unique_ptr<mcc::messages::CmdSubscribe_Request>&& sub
         _devices[subscription->device()];
         if (_devices.find(subscription->device()) != _devices.end())
         {
-            _devices[subscription->device()]._exchanger = subscription->sender();
+            _devices[subscription->device()]._exchanger = subscription->senderId();
             _out->respond<mcc::messages::CmdSubscribe_Response>(subscription.get());
         }
         else
@@ -114,7 +118,7 @@ void Service::process(std::unique_ptr<mcc::messages::CmdSubscribe_Request>&& sub
     }
     else
     {
-        _devices[subscription->device()]._exchanger.clear();
+        _devices[subscription->device()]._exchanger = mcc::misc::NameTable::emptyId;
     }
 }
 
@@ -28,9 +28,9 @@ private:
 
     struct Command
     {
-        Command(const std::string& from, const std::string& registered, const mcc::messages::Cmd& cmd);
-        std::string         _from;
-        std::string         _registered;
+        Command(mcc::misc::NameId from, mcc::misc::Timestamp registered, const mcc::messages::Cmd& cmd);
+        mcc::misc::NameId   _from;
+        mcc::misc::Timestamp _registered;
         mcc::misc::CmdState _state;
     };
 
@@ -40,7 +40,7 @@ private:
     struct Device
     {
         std::string _name;
-        std::string _exchanger;
+        mcc::misc::NameId _exchanger = mcc::misc::NameTable::emptyId;
         Commands    _cmds;
     };
 
@@ -21,6 +21,11 @@ namespace db {
 class DbHandle
 {
 public:
+    //у каждого потока, работающего с базой, своё соединение со своим именем
+    explicit DbHandle(const QString& connection = "mcc") : _connection(connection)
+    {
+    }
+
     QString version() const
     {
         if (!_db.isOpen())
@@ -31,14 +36,16 @@ public:
         return query.record().field(0).value().toString();
     }
 
+    //WAL: читающие соединения не ждут пишущее, а при synchronous = NORMAL
+    //падение процесса не портит базу, теряются только последние транзакции
     void speedupSqlite()
     {
         QSqlQuery query(_db);
-        query.exec("PRAGMA synchronous = OFF");
         query.exec("PRAGMA page_size = 4096");
+        query.exec("PRAGMA journal_mode = WAL");
+        query.exec("PRAGMA synchronous = NORMAL");
         query.exec("PRAGMA cache_size = 16384");
         query.exec("PRAGMA temp_store = MEMORY");
-        query.exec("PRAGMA journal_mode = MEMORY");
     }
 
     bool create(const QString& path, const QString& schema_path)
@@ -58,7 +65,7 @@ public:
         }
 
         QSqlDatabase db;
-        if (!createDbHandle(path, db))
+        if (!createDbHandle(_connection, path, db))
             return false;
 
         if (!db.open())
@@ -90,13 +97,18 @@ public:
         if (!QFile::exists(path))
             return false;
 
-        if (!createDbHandle(path, _db))
+        if (!createDbHandle(_connection, path, _db))
             return false;
         _db.open();
 
         return true;
     }
 
+    void begin()
+    {
+        _db.transaction();
+    }
+
     void transaction()
     {
         _db.commit();
@@ -130,9 +142,9 @@ public:
     }
 
 private:
-    static bool createDbHandle(const QString& path, QSqlDatabase& db)
+    static bool createDbHandle(const QString& connection, const QString& path, QSqlDatabase& db)
     {
-        db = QSqlDatabase::addDatabase("QSQLITE", "mcc");
+        db = QSqlDatabase::addDatabase("QSQLITE", connection);
 
         db.setHostName(QString());
         db.setUserName(QString());
@@ -199,6 +211,7 @@ private:
     }
 
 private:
+    QString      _connection;
     QString      _path;
     QSqlDatabase _db;
 };
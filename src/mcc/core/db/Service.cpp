@@ -10,16 +10,13 @@
 #include "mcc/core/db/Service.h"
 #include "mcc/core/db/FirmwareLoader.h"
 #include "mcc/Names.h"
+#include "mcc/messages/Cmd.h"
+#include "mcc/messages/MessageSender.h"
 
-#include "mcc/core/db/queries/Cmd.h"
-#include "mcc/core/db/queries/CmdState.h"
-#include "mcc/core/db/queries/TmParamList.h"
-#include "mcc/core/db/queries/DeviceActionLog.h"
 #include "mcc/core/db/queries/DeviceDescription_Request.h"
 #include "mcc/core/db/queries/DeviceList_Request.h"
 #include "mcc/core/db/queries/FirmwareList_Request.h"
 #include "mcc/core/db/queries/ProtocolForDevice_Request.h"
-#include "mcc/core/db/queries/ProtocolForDeviceRegister_Request.h"
 #include "mcc/core/db/queries/ProtocolList_Request.h"
 #include "mcc/core/db/queries/ProtocolDescription_Request.h"
 
@@ -28,18 +25,37 @@ namespace mcc {
 namespace core {
 namespace db {
 
+//за tick() каждый запрос истории читает столько кусков архива, если у запросившего в очереди
+//меньше historyBacklog сообщений; иначе ждёт historyRetry, пока тот разберёт ответы
+static const std::size_t historyChunksPerTick = 16;
+static const std::size_t historyBacklog = 16;
+static const std::chrono::milliseconds historyRetry(10);
+static const std::chrono::milliseconds idleWait(100);
+
 namespace queries
 {
     extern void execute(DbHandle* db, const mcc::messages::MessageSender& sender, std::unique_ptr<mcc::messages::FirmwareDescription_Request>&&);
-    extern void execute(DbHandle* db, const mcc::messages::MessageSender& sender, std::unique_ptr<mcc::messages::FirmwareRegister_Request>&&);
-    extern void execute(DbHandle* db, const mcc::messages::MessageSender& sender, std::unique_ptr<mcc::messages::DeviceUpdate_Request>&&);
-    extern void execute(DbHandle* db, const mcc::messages::MessageSender& sender, std::unique_ptr<mcc::messages::DeviceRegister_Request>&&);
-    extern void execute(DbHandle* db, const mcc::messages::MessageSender& sender, std::unique_ptr<mcc::messages::DeviceUnRegister_Request>&&);
-    extern void execute(DbHandle* db, const mcc::messages::MessageSender& sender, std::unique_ptr<mcc::messages::ProtocolForDeviceRegister_Request>&&);
 }
 
 Service::Service(const mcc::messages::LocalRouterPtr& router) : mcc::messages::ServiceAbstract(mcc::Names::coreDb(), router)
 {
+    handle<mcc::messages::Cmd>();
+    handle<mcc::messages::CmdState>();
+    handle<mcc::messages::DeviceDescription_Request>();
+    handle<mcc::messages::DeviceUpdate_Request>();
+    handle<mcc::messages::DeviceList_Request>();
+    handle<mcc::messages::DeviceRegister_Request>();
+    handle<mcc::messages::DeviceUnRegister_Request>();
+    handle<mcc::messages::DeviceActionLog>();
+    handle<mcc::messages::FirmwareDescription_Request>();
+    handle<mcc::messages::FirmwareList_Request>();
+    handle<mcc::messages::FirmwareRegister_Request>();
+    handle<mcc::messages::ProtocolDescription_Request>();
+    handle<mcc::messages::ProtocolForDevice_Request>();
+    handle<mcc::messages::ProtocolForDeviceRegister_Request>();
+    handle<mcc::messages::ProtocolList_Request>();
+    handle<mcc::messages::TmParamList>();
+    handle<mcc::messages::TmHistory_Request>();
 }
 
 Service::~Service()
@@ -76,49 +92,61 @@ bool Service::pre()
     qDebug() << "sqlite version: "<< _db.version();
     _db.speedupSqlite();
 
-    _cmd = misc::makeUnique<queries::Cmd>(&_db);
-    _cmdstate = misc::makeUnique<queries::CmdState>(&_db);
-    _tmparamlist = misc::makeUnique<queries::TmParamList>(&_db);
-    _actions = misc::makeUnique<queries::DeviceActionLog>(&_db);
+    _writer = misc::makeUnique<Writer>(_out);
+    if (!_writer->start(mccDbPath))
+    {
+        assert(false);
+        _db.stop();
+        return false;
+    }
+
     _devicelist = misc::makeUnique<queries::DeviceList_Request>(&_db, _out);
     _devicedescription = misc::makeUnique<queries::DeviceDescription_Request>(&_db, _out);
     _protocolfordevice = misc::makeUnique<queries::ProtocolForDevice_Request>(&_db, _out);
-    _protocolfordeviceregister = misc::makeUnique<queries::ProtocolForDeviceRegister_Request>(&_db, _out);
     _protocollist = misc::makeUnique<queries::ProtocolList_Request>(&_db, _out);
     _protocoldescription = misc::makeUnique<queries::ProtocolDescription_Request>(&_db, _out);
     _firmwarelist = misc::makeUnique<queries::FirmwareList_Request>(&_db, _out);
+
+    QString tmArchivePath = QCoreApplication::applicationDirPath() + "/mcc.tm";
+    if (!_archive.open(tmArchivePath.toStdString()))
+        qDebug() << "failed to open tm archive" << tmArchivePath << ", writing tm to sqlite";
+
+    _archiveSealed = std::chrono::steady_clock::now();
+    wakeupAfter_(std::chrono::seconds(10));
     return ServiceAbstract::pre();
 }
 
 void Service::post()
 {
-    _db.commit();
+    _history.clear();
+    _archive.close();
+    if (_writer)
+        _writer->stop();
     _db.stop();
     return ServiceAbstract::post();
 }
 
 void Service::tick()
 {
-    auto m = _in->tryRecvFor(std::chrono::milliseconds(100));
-    if (m.isOk())
-        chooseProcessor(m.take());
+    ServiceAbstract::tick();
+    readHistory_();
 
-    static std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-    if (std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count() >= 10)
+    if (std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - _archiveSealed).count() >= 10)
     {
-        _db.transaction();
-        start = std::chrono::steady_clock::now();
+        _archive.sealExpired(mcc::misc::currentTimestamp());
+        _archiveSealed = std::chrono::steady_clock::now();
+        wakeupAfter_(std::chrono::seconds(10));
     }
 }
 
 void Service::process(std::unique_ptr<mcc::messages::Cmd>&& message)
 {
-    _cmd->execute(std::move(message));
+    _writer->post(std::move(message));
 }
 
 void Service::process(std::unique_ptr<mcc::messages::CmdState>&& message)
 {
-    _cmdstate->execute(std::move(message));
+    _writer->post(std::move(message));
 }
 
 void Service::process(std::unique_ptr<mcc::messages::DeviceDescription_Request>&& request)
@@ -128,22 +156,80 @@ void Service::process(std::unique_ptr<mcc::messages::DeviceDescription_Request>&
 
 void Service::process(std::unique_ptr<mcc::messages::DeviceUpdate_Request>&& request)
 {
-    queries::execute(&_db, _out, std::move(request));
+    _writer->post(std::move(request));
 }
 
 void Service::process(std::unique_ptr<mcc::messages::TmParamList>&& message)
 {
-    _tmparamlist->execute(std::move(message));
+    if (_archive.isOpen())
+        _archive.append(message->device(), message->params(), message->sampleTime());
+    else
+        _writer->post(std::move(message));
+}
+
+//История читается из архива в потоке сервиса: запись в архив идёт здесь же, между частями ответа.
+//Весь ответ не собирается сразу, чтобы длинный запрос не останавливал запись телеметрии
+void Service::process(std::unique_ptr<mcc::messages::TmHistory_Request>&& request)
+{
+    if (!_archive.isOpen())
+    {
+        _out->respond<mcc::messages::TmHistory_Response>(request.get(), "tm archive is not available");
+        return;
+    }
+    HistoryJob job;
+    job.cursor = misc::makeUnique<TmHistoryCursor>(&_archive, *request);
+    job.request = std::move(request);
+    _history.push_back(std::move(job));
+}
+
+void Service::readHistory_()
+{
+    bool isReading = false;
+    for (std::size_t i = _history.size(); i > 0; i--)
+    {
+        HistoryJob job = std::move(_history.front());
+        _history.pop_front();
+        if (_router->queueSize(job.request->senderId()) >= historyBacklog)
+        {
+            _history.push_back(std::move(job));
+            continue;
+        }
+        isReading = true;
+        const mcc::messages::TmHistory_Request* request = job.request.get();
+        bool hasMore = job.cursor->step(historyChunksPerTick, [this, request](const mcc::messages::TmParamName& param,
+                                        mcc::messages::TmHistoryPoints&& points, std::uint32_t part, bool isLast)
+        {
+            _out->respond<mcc::messages::TmHistory_Response>(request, param, std::move(points), part, isLast);
+        });
+        if (hasMore)
+            _history.push_back(std::move(job));
+    }
+
+    if (_history.empty())
+    {
+        _recvTimeout = idleWait;
+        return;
+    }
+    if (isReading)
+    {
+        _recvTimeout = std::chrono::microseconds(0);
+        wakeup_();
+    }
+    else
+    {
+        _recvTimeout = historyRetry;
+        wakeupAfter_(historyRetry);
+    }
 }
 
 void Service::process(std::unique_ptr<mcc::messages::DeviceUnRegister_Request>&& request)
 {
-    queries::execute(&_db, _out, std::move(request));
+    _writer->post(std::move(request));
 }
 
 void Service::process(std::unique_ptr<mcc::messages::DeviceActionLog>&& message)
 {
-    _actions->execute(std::move(message));
+    _writer->post(std::move(message));
 }
 
 void Service::process(std::unique_ptr<mcc::messages::FirmwareList_Request>&& message)
@@ -158,7 +244,7 @@ void Service::process(std::unique_ptr<mcc::messages::FirmwareDescription_Request
 
 void Service::process(std::unique_ptr<mcc::messages::FirmwareRegister_Request>&& request)
 {
-    queries::execute(&_db, _out, std::move(request));
+    _writer->post(std::move(request));
 }
 
 void Service::process(std::unique_ptr<mcc::messages::ProtocolList_Request>&& message)
@@ -178,12 +264,12 @@ void Service::process(std::unique_ptr<mcc::messages::ProtocolForDevice_Request>&
 
 void Service::process(std::unique_ptr<mcc::messages::ProtocolForDeviceRegister_Request>&& message)
 {
-    _protocolfordeviceregister->execute(std::move(message));
+    _writer->post(std::move(message));
 }
 
 void Service::process(std::unique_ptr<mcc::messages::DeviceRegister_Request>&& request)
 {
-    queries::execute(&_db, _out, std::move(request));
+    _writer->post(std::move(request));
 }
 
 void Service::process(std::unique_ptr<mcc::messages::DeviceList_Request>&& message)
@@ -3,22 +3,21 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <deque>
 #include "mcc/messages/ServiceAbstract.h"
 #include "mcc/core/db/DbHandle.h"
+#include "mcc/core/db/TmArchive.h"
+#include "mcc/core/db/TmHistory.h"
+#include "mcc/core/db/Writer.h"
 
 #include "mcc/core/decode/Sqlite3RegistryProvider.h"
 
 namespace mcc { namespace core { namespace db { namespace queries
 {
-    class Cmd;
-    class CmdState;
-    class TmParamList;
-    class DeviceActionLog;
     class DeviceDescription_Request;
     class DeviceList_Request;
     class FirmwareList_Request;
     class ProtocolForDevice_Request;
-    class ProtocolForDeviceRegister_Request;
     class ProtocolList_Request;
     class ProtocolDescription_Request;
 }}}}
@@ -56,23 +55,33 @@ private:
     void process(std::unique_ptr<mcc::messages::ProtocolForDeviceRegister_Request>&&) override;
     void process(std::unique_ptr<mcc::messages::ProtocolList_Request>&&) override;
     void process(std::unique_ptr<mcc::messages::TmParamList>&&) override;
+    void process(std::unique_ptr<mcc::messages::TmHistory_Request>&&) override;
+    void readHistory_();
+
+    struct HistoryJob
+    {
+        std::unique_ptr<mcc::messages::TmHistory_Request> request;
+        std::unique_ptr<TmHistoryCursor> cursor;
+    };
 
-    std::unique_ptr<queries::Cmd> _cmd;
-    std::unique_ptr<queries::CmdState> _cmdstate;
-    std::unique_ptr<queries::TmParamList> _tmparamlist;
-    std::unique_ptr<queries::DeviceActionLog> _actions;
     std::unique_ptr<queries::DeviceDescription_Request> _devicedescription;
     std::unique_ptr<queries::DeviceList_Request> _devicelist;
     std::unique_ptr<queries::ProtocolForDevice_Request> _protocolfordevice;
-    std::unique_ptr<queries::ProtocolForDeviceRegister_Request> _protocolfordeviceregister;
     std::unique_ptr<queries::ProtocolList_Request> _protocollist;
     std::unique_ptr<queries::ProtocolDescription_Request> _protocoldescription;
     std::unique_ptr<queries::FirmwareList_Request> _firmwarelist;
 
     const std::string _dbSchema = ":/db/Schema.sql";
     const std::string _dirTraits = ":/db/traits/";
+    //соединение для запросов чтения, всё изменяющее базу уходит в _writer
     mcc::core::db::DbHandle _db;
+    std::unique_ptr<Writer> _writer;
+    //телеметрия пишется в архив, в mcc_tm - только если архив не открылся
+    TmArchive _archive;
     std::unique_ptr<mcc::decode::Registry> _registry;
+    std::chrono::steady_clock::time_point _archiveSealed;
+    //запросы истории, которые ещё отвечаются; по очереди, понемногу за tick()
+    std::deque<HistoryJob> _history;
 };
 }
 }
@@ -0,0 +1,495 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "bmcl/MemReader.h"
+#include "bmcl/MemWriter.h"
+#include "mcc/misc/Crc.h"
+#include "mcc/core/db/TmArchive.h"
+
+
+namespace mcc {
+namespace core {
+namespace db {
+
+using mcc::misc::NetVariantType;
+using mcc::misc::Timestamp;
+
+static const char signature[8] = {'M', 'C', 'C', 'T', 'M', 'A', 0, 1};
+static const std::size_t recordHeaderSize = 1 + 4 + 4;
+static const std::size_t chunkHeaderSize = 4 + 1 + 4 + 8 + 8;
+
+#ifdef _WIN32
+static int openNative(const std::string& path) { return _open(path.c_str(), _O_RDWR | _O_BINARY); }
+static bool truncateNative(int fd, std::uint64_t size) { return _chsize_s(fd, size) == 0; }
+static bool syncNative(int fd) { return _commit(fd) == 0; }
+static void closeNative(int fd) { _close(fd); }
+#else
+static int openNative(const std::string& path) { return ::open(path.c_str(), O_RDWR); }
+static bool truncateNative(int fd, std::uint64_t size) { return ftruncate(fd, (off_t)size) == 0; }
+static bool syncNative(int fd) { return fsync(fd) == 0; }
+static void closeNative(int fd) { ::close(fd); }
+#endif
+
+TmArchive::TmArchive() : _fd(-1), _isSynced(true), _isAtEnd(false), _end(0)
+{
+}
+
+TmArchive::~TmArchive()
+{
+    close();
+}
+
+bool TmArchive::open(const std::string& path, const Options& options)
+{
+    close();
+    _options = options;
+    _path = path;
+
+    if (options.isReadOnly)
+        _file.open(path, std::ios::in | std::ios::binary);
+    else
+        _file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!_file.is_open() && !options.isReadOnly)
+    {
+        //нет файла - создаём
+        std::ofstream create(path, std::ios::out | std::ios::binary);
+        if (!create.write(signature, sizeof(signature)))
+            return false;
+        create.close();
+        _file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    }
+    if (!_file.is_open())
+        return false;
+
+    if (!options.isReadOnly)
+        _fd = openNative(path);
+    if ((!options.isReadOnly && _fd < 0) || !load_())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TmArchive::close()
+{
+    if (!_file.is_open())
+        return;
+    flush();
+    _file.close();
+    if (_fd >= 0)
+        closeNative(_fd);
+    _fd = -1;
+    _isSynced = true;
+    _series.clear();
+    _index.clear();
+    _end = 0;
+    _isAtEnd = false;
+}
+
+std::size_t TmArchive::chunkCount() const
+{
+    std::size_t count = 0;
+    for (const auto& i : _series)
+        count += i->chunks.size();
+    return count;
+}
+
+bool TmArchive::load_()
+{
+    _file.seekg(0, std::ios::end);
+    std::uint64_t size = (std::uint64_t)_file.tellg();
+    _file.seekg(0);
+
+    char header[sizeof(signature)];
+    if (size < sizeof(signature) || !_file.read(header, sizeof(header)) || std::memcmp(header, signature, sizeof(signature)) != 0)
+        return false;
+
+    std::uint64_t offset = sizeof(signature);
+    std::vector<std::uint8_t> payload;
+    while (offset + recordHeaderSize <= size)
+    {
+        std::uint8_t recordHeader[recordHeaderSize];
+        _file.seekg(offset);
+        if (!_file.read((char*)recordHeader, recordHeaderSize))
+            break;
+        bmcl::MemReader reader(recordHeader, recordHeaderSize);
+        RecordKind kind = (RecordKind)reader.readUint8();
+        std::uint32_t payloadSize = reader.readUint32Le();
+        std::uint32_t crc = reader.readUint32Le();
+        std::uint64_t next = offset + recordHeaderSize + payloadSize;
+        if (next > size)
+            break;
+
+        payload.resize(payloadSize);
+        if (!_file.read((char*)payload.data(), payloadSize))
+            break;
+        if (mcc::misc::crc32(payload.data(), payload.size()) != crc)
+            break;
+        if (!parse_(kind, payload, payloadSize, offset + recordHeaderSize))
+            break;
+        offset = next;
+    }
+
+    //всё после последней целой записи отбрасываем, иначе после короткой новой записи в файле
+    //останется хвост старой, и при следующем открытии он может сойти за целую запись
+    _file.clear();
+    _end = offset;
+    _isAtEnd = false;
+    if (_fd >= 0 && offset < size)
+    {
+        if (!truncateNative(_fd, offset) || !syncNative(_fd))
+            return false;
+    }
+    return true;
+}
+
+bool TmArchive::parse_(RecordKind kind, const std::vector<std::uint8_t>& payload, std::uint32_t size, std::uint64_t offset)
+{
+    bmcl::MemReader reader(payload.data(), payload.size());
+    if (kind == RecordKind::Series)
+    {
+        if (reader.readableSize() < 4)
+            return false;
+        std::uint32_t id = reader.readUint32Le();
+        std::string names[3];
+        for (auto& name : names)
+        {
+            if (reader.readableSize() < 2)
+                return false;
+            std::size_t size = reader.readUint16Le();
+            if (reader.readableSize() < size)
+                return false;
+            name.assign((const char*)reader.current(), size);
+            reader.skip(size);
+        }
+        if (id != _series.size())
+            return false;
+        series_(names[0], names[1], names[2], false);
+        return true;
+    }
+
+    if (kind != RecordKind::Chunk || reader.readableSize() < chunkHeaderSize)
+        return false;
+    std::uint32_t id = reader.readUint32Le();
+    if (id >= _series.size())
+        return false;
+    ChunkRef chunk;
+    chunk.type = (NetVariantType)reader.readUint8();
+    chunk.count = reader.readUint32Le();
+    chunk.from = reader.readInt64Le();
+    chunk.to = reader.readInt64Le();
+    chunk.offset = offset + chunkHeaderSize;
+    chunk.size = size - (std::uint32_t)chunkHeaderSize;
+    if (chunk.type > NetVariantType::String || chunk.type == NetVariantType::QString)
+        return false;
+    addChunk_(_series[id].get(), chunk);
+    return true;
+}
+
+void TmArchive::addChunk_(Series* series, const ChunkRef& chunk)
+{
+    if (!series->chunks.empty() && series->chunks.back().to > chunk.from)
+        series->isOrdered = false;
+    series->chunks.push_back(chunk);
+}
+
+void TmArchive::writeRecord_(RecordKind kind, const std::vector<std::uint8_t>& payload)
+{
+    std::uint8_t header[recordHeaderSize];
+    bmcl::MemWriter writer(header, recordHeaderSize);
+    writer.writeUint8((std::uint8_t)kind);
+    writer.writeUint32Le((std::uint32_t)payload.size());
+    writer.writeUint32Le(mcc::misc::crc32(payload.data(), payload.size()));
+
+    if (!_isAtEnd)
+    {
+        _file.seekp(_end);
+        _isAtEnd = true;
+    }
+    _file.write((const char*)header, recordHeaderSize);
+    _file.write((const char*)payload.data(), payload.size());
+    _end += recordHeaderSize + payload.size();
+}
+
+std::uint32_t TmArchive::series_(const std::string& device, const std::string& trait, const std::string& status, bool isNew)
+{
+    auto& statuses = _index[device][trait];
+    auto i = statuses.find(status);
+    if (i != statuses.end())
+        return i->second;
+
+    std::uint32_t id = (std::uint32_t)_series.size();
+    std::unique_ptr<Series> series(new Series);
+    series->device = device;
+    series->trait = trait;
+    series->status = status;
+    series->isOrdered = true;
+    _series.push_back(std::move(series));
+    statuses.emplace(status, id);
+
+    if (isNew)
+    {
+        _payload.resize(4 + 2 * 3 + device.size() + trait.size() + status.size());
+        bmcl::MemWriter writer(_payload.data(), _payload.size());
+        writer.writeUint32Le(id);
+        for (const std::string* name : {&device, &trait, &status})
+        {
+            writer.writeUint16Le((std::uint16_t)name->size());
+            writer.write(name->data(), name->size());
+        }
+        writeRecord_(RecordKind::Series, _payload);
+    }
+    return id;
+}
+
+void TmArchive::seal_(std::uint32_t id)
+{
+    Series* series = _series[id].get();
+    TmChunkWriter& open = series->open;
+    if (open.isEmpty())
+        return;
+
+    const auto& data = open.data();
+    _payload.resize(chunkHeaderSize + data.size());
+    bmcl::MemWriter writer(_payload.data(), _payload.size());
+    writer.writeUint32Le(id);
+    writer.writeUint8((std::uint8_t)open.type());
+    writer.writeUint32Le(open.count());
+    writer.writeInt64Le(open.minTime());
+    writer.writeInt64Le(open.maxTime());
+    writer.write(data.data(), data.size());
+
+    ChunkRef chunk;
+    chunk.from = open.minTime();
+    chunk.to = open.maxTime();
+    chunk.offset = _end + recordHeaderSize + chunkHeaderSize;
+    chunk.size = (std::uint32_t)data.size();
+    chunk.count = open.count();
+    chunk.type = open.type();
+    writeRecord_(RecordKind::Chunk, _payload);
+    addChunk_(series, chunk);
+    open.reset(open.type());
+    _isSynced = false;
+}
+
+void TmArchive::sync_()
+{
+    if (_isSynced)
+        return;
+    _file.flush();
+    if (_fd >= 0)
+        syncNative(_fd);
+    _isSynced = true;
+}
+
+void TmArchive::append(const std::string& device, const mcc::messages::TmParams& params, Timestamp time)
+{
+    if (!isOpen() || _options.isReadOnly)
+        return;
+    for (const auto& i : params)
+    {
+        std::uint32_t id = series_(device, i.trait(), i.status(), true);
+        TmChunkWriter& open = _series[id]->open;
+        NetVariantType type = TmChunkWriter::storedType(i.value().type());
+        if (!open.isEmpty() && open.type() != type)
+            seal_(id);
+        if (open.isEmpty())
+            open.reset(type);
+        open.append(time, i.value());
+        if (open.count() >= _options.chunkPoints)
+            seal_(id);
+    }
+    sync_();
+}
+
+void TmArchive::sealExpired(Timestamp now)
+{
+    if (!isOpen())
+        return;
+    for (std::uint32_t id = 0; id < _series.size(); id++)
+    {
+        const TmChunkWriter& open = _series[id]->open;
+        if (!open.isEmpty() && now - open.minTime() >= _options.chunkAge)
+            seal_(id);
+    }
+    sync_();
+}
+
+void TmArchive::flush()
+{
+    if (!isOpen())
+        return;
+    for (std::uint32_t id = 0; id < _series.size(); id++)
+        seal_(id);
+    sync_();
+}
+
+const TmArchive::Series* TmArchive::find_(const std::string& device, const std::string& trait, const std::string& status) const
+{
+    auto d = _index.find(device);
+    if (d == _index.end())
+        return nullptr;
+    auto t = d->second.find(trait);
+    if (t == d->second.end())
+        return nullptr;
+    auto s = t->second.find(status);
+    if (s == t->second.end())
+        return nullptr;
+    return _series[s->second].get();
+}
+
+void TmArchive::decode_(TmChunkReader* reader, Timestamp from, Timestamp to, const Visitor& visitor)
+{
+    Timestamp time;
+    mcc::misc::NetVariant value;
+    while (reader->next(&time, &value))
+    {
+        if (time >= from && time <= to)
+            visitor(time, value);
+    }
+}
+
+void TmArchive::readChunk_(const ChunkRef& chunk, Timestamp from, Timestamp to, const Visitor& visitor) const
+{
+    _readBuffer.resize(chunk.size);
+    _file.flush();
+    _file.seekg(chunk.offset);
+    _isAtEnd = false;
+    if (!_file.read((char*)_readBuffer.data(), chunk.size))
+    {
+        _file.clear();
+        return;
+    }
+    TmChunkReader reader(chunk.type, _readBuffer.data(), _readBuffer.size(), chunk.count);
+    decode_(&reader, from, to, visitor);
+}
+
+void TmArchive::query(const std::string& device, const std::string& trait, const std::string& status,
+                      Timestamp from, Timestamp to, std::vector<Point>* out) const
+{
+    scan(device, trait, status, from, to, [out](Timestamp time, const mcc::misc::NetVariant& value)
+    {
+        Point point = {time, value};
+        out->push_back(std::move(point));
+    });
+}
+
+void TmArchive::scan(const std::string& device, const std::string& trait, const std::string& status,
+                     Timestamp from, Timestamp to, const Visitor& visitor) const
+{
+    Cursor cursor;
+    scanSome(device, trait, status, from, to, std::numeric_limits<std::size_t>::max(), &cursor, visitor);
+}
+
+std::size_t TmArchive::scanSome(const std::string& device, const std::string& trait, const std::string& status,
+                                Timestamp from, Timestamp to, std::size_t maxChunks, Cursor* cursor, const Visitor& visitor) const
+{
+    const Series* series = find_(device, trait, status);
+    if (!series || from > to)
+    {
+        cursor->isDone = true;
+        return 0;
+    }
+
+    const auto& chunks = series->chunks;
+    if (!cursor->isStarted)
+    {
+        cursor->isStarted = true;
+        if (series->isOrdered)
+            cursor->chunk = std::lower_bound(chunks.begin(), chunks.end(), from, [](const ChunkRef& chunk, Timestamp time) { return chunk.to < time; }) - chunks.begin();
+    }
+    //куски только дописываются в конец, так что номер куска остаётся верным между вызовами
+    std::size_t count = 0;
+    for (; cursor->chunk < chunks.size(); cursor->chunk++)
+    {
+        const ChunkRef& chunk = chunks[cursor->chunk];
+        if (series->isOrdered && chunk.from > to)
+        {
+            cursor->chunk = chunks.size();
+            break;
+        }
+        if (chunk.to < from || chunk.from > to)
+            continue;
+        if (count == maxChunks)
+            return count;
+        readChunk_(chunk, from, to, visitor);
+        count++;
+    }
+
+    const TmChunkWriter& open = series->open;
+    if (!open.isEmpty() && open.maxTime() >= from && open.minTime() <= to)
+    {
+        TmChunkReader reader(open.type(), open.data().data(), open.data().size(), open.count());
+        decode_(&reader, from, to, visitor);
+    }
+    cursor->isDone = true;
+    return count;
+}
+
+mcc::messages::TmParamNames TmArchive::params(const std::string& device) const
+{
+    mcc::messages::TmParamNames names;
+    auto d = _index.find(device);
+    if (d == _index.end())
+        return names;
+    for (const auto& trait : d->second)
+    {
+        for (const auto& status : trait.second)
+            names.emplace_back(trait.first, status.first);
+    }
+    std::sort(names.begin(), names.end(), [](const mcc::messages::TmParamName& left, const mcc::messages::TmParamName& right)
+    {
+        return left.trait < right.trait || (left.trait == right.trait && left.status < right.status);
+    });
+    return names;
+}
+
+std::vector<std::string> TmArchive::devices() const
+{
+    std::vector<std::string> names;
+    names.reserve(_index.size());
+    for (const auto& i : _index)
+        names.push_back(i.first);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+bool TmArchive::timeRange(const std::string& device, Timestamp* from, Timestamp* to) const
+{
+    bool isFound = false;
+    auto extend = [&](Timestamp min, Timestamp max)
+    {
+        if (!isFound || min < *from)
+            *from = min;
+        if (!isFound || max > *to)
+            *to = max;
+        isFound = true;
+    };
+    for (const auto& series : _series)
+    {
+        if (!device.empty() && series->device != device)
+            continue;
+        for (const auto& chunk : series->chunks)
+            extend(chunk.from, chunk.to);
+        if (!series->open.isEmpty())
+            extend(series->open.minTime(), series->open.maxTime());
+    }
+    return isFound;
+}
+}
+}
+}
@@ -0,0 +1,160 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mcc/misc/TimeUtils.h"
+#include "mcc/messages/Tm.h"
+#include "mcc/core/db/TmChunk.h"
+
+
+namespace mcc {
+namespace core {
+namespace db {
+
+//Архив телеметрии: один файл, в который только дописываются записи.
+//Значения каждого параметра устройства (ряда) копятся в сжатом куске TmChunkWriter и
+//запечатываются в файл по числу точек или по возрасту куска. В памяти держится разреженный
+//индекс: границы времени и смещение каждого запечатанного куска, так что выборка за интервал
+//читает только пересекающиеся с ним куски.
+//
+//Формат файла: 8 байт сигнатуры, затем записи {u8 вид, u32 размер, u32 crc32, данные}:
+//  ряд:  u32 id, имена устройства, признака и статуса (u16 длина + байты)
+//  кусок: u32 id ряда, u8 тип значения, u32 число точек, i64 наименьшее и наибольшее время, биты TmChunkWriter
+//При открытии файл читается до первой неполной или испорченной записи (crc проверяется у всех), остальное
+//обрезается, и запись продолжается с неё. Запечатанные куски сбрасываются на диск (fsync) до выхода из
+//append(), sealExpired() и flush(). Не потокобезопасен.
+class TmArchive
+{
+public:
+    struct Options
+    {
+        Options() : chunkPoints(1024), chunkAge(60ll * 1000 * 1000 * 1000), isReadOnly(false) {}
+        //кусок запечатывается, набрав столько точек
+        std::uint32_t chunkPoints;
+        //или если его первая точка старше этого на момент sealExpired()
+        mcc::misc::Timestamp chunkAge;
+        //только чтение: файл не создаётся и не дописывается, append() ничего не делает.
+        //Так можно читать и архив, в который пишет другой процесс, - видны запечатанные куски
+        bool isReadOnly;
+    };
+
+    struct Point
+    {
+        mcc::misc::Timestamp time;
+        mcc::misc::NetVariant value;
+    };
+
+    typedef std::function<void(mcc::misc::Timestamp time, const mcc::misc::NetVariant& value)> Visitor;
+
+    //где остановилось чтение ряда по частям, см. scanSome()
+    struct Cursor
+    {
+        Cursor() : chunk(0), isStarted(false), isDone(false) {}
+        std::size_t chunk;
+        bool isStarted;
+        bool isDone;
+    };
+
+    TmArchive();
+    ~TmArchive();
+
+    //открывает или создаёт файл и строит индекс по уже записанным кускам
+    bool open(const std::string& path, const Options& options = Options());
+    //запечатывает все куски и закрывает файл
+    void close();
+    bool isOpen() const { return _file.is_open(); }
+
+    void append(const std::string& device, const mcc::messages::TmParams& params, mcc::misc::Timestamp time);
+    //запечатывает куски старше chunkAge
+    void sealExpired(mcc::misc::Timestamp now);
+    //запечатывает все куски
+    void flush();
+
+    //точки ряда с from <= time <= to по возрастанию времени, включая ещё не запечатанные
+    void query(const std::string& device, const std::string& trait, const std::string& status,
+               mcc::misc::Timestamp from, mcc::misc::Timestamp to, std::vector<Point>* out) const;
+    //то же по одной точке, в памяти держится только текущий кусок
+    void scan(const std::string& device, const std::string& trait, const std::string& status,
+              mcc::misc::Timestamp from, mcc::misc::Timestamp to, const Visitor& visitor) const;
+    //то же, но не больше maxChunks запечатанных кусков за вызов, продолжая с cursor; незапечатанный кусок
+    //читается последним, после него cursor->isDone. Между вызовами в архив можно дописывать.
+    //Возвращает число прочитанных кусков
+    std::size_t scanSome(const std::string& device, const std::string& trait, const std::string& status,
+                         mcc::misc::Timestamp from, mcc::misc::Timestamp to, std::size_t maxChunks, Cursor* cursor,
+                         const Visitor& visitor) const;
+    //параметры устройства, по которым есть ряды
+    mcc::messages::TmParamNames params(const std::string& device) const;
+    //устройства, по возрастанию имени
+    std::vector<std::string> devices() const;
+    //наименьшее и наибольшее время точек устройства (всех устройств, если device пустой); false - точек нет
+    bool timeRange(const std::string& device, mcc::misc::Timestamp* from, mcc::misc::Timestamp* to) const;
+
+    std::size_t seriesCount() const { return _series.size(); }
+    std::size_t chunkCount() const;
+    std::uint64_t fileSize() const { return _end; }
+
+private:
+    enum class RecordKind : std::uint8_t { Series = 1, Chunk = 2 };
+
+    struct ChunkRef
+    {
+        mcc::misc::Timestamp from;
+        mcc::misc::Timestamp to;
+        //начало битов куска в файле
+        std::uint64_t offset;
+        std::uint32_t size;
+        std::uint32_t count;
+        mcc::misc::NetVariantType type;
+    };
+
+    struct Series
+    {
+        std::string device;
+        std::string trait;
+        std::string status;
+        std::vector<ChunkRef> chunks;
+        //куски идут по времени без перекрытий, можно искать делением пополам
+        bool isOrdered;
+        TmChunkWriter open;
+    };
+
+    typedef std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::uint32_t>>> Index;
+
+    std::uint32_t series_(const std::string& device, const std::string& trait, const std::string& status, bool isNew);
+    const Series* find_(const std::string& device, const std::string& trait, const std::string& status) const;
+    void addChunk_(Series* series, const ChunkRef& chunk);
+    void seal_(std::uint32_t id);
+    void writeRecord_(RecordKind kind, const std::vector<std::uint8_t>& payload);
+    //сбрасывает записанное на диск, если с прошлого раза что-то запечатано
+    void sync_();
+    bool load_();
+    bool parse_(RecordKind kind, const std::vector<std::uint8_t>& payload, std::uint32_t size, std::uint64_t offset);
+    void readChunk_(const ChunkRef& chunk, mcc::misc::Timestamp from, mcc::misc::Timestamp to, const Visitor& visitor) const;
+    static void decode_(TmChunkReader* reader, mcc::misc::Timestamp from, mcc::misc::Timestamp to, const Visitor& visitor);
+
+    Options _options;
+    std::string _path;
+    mutable std::fstream _file;
+    //тот же файл, для ftruncate и fsync, которых нет у fstream; -1 - только чтение
+    int _fd;
+    bool _isSynced;
+    //позиция записи стоит в конце файла, после чтения её надо вернуть
+    mutable bool _isAtEnd;
+    std::uint64_t _end;
+    std::vector<std::unique_ptr<Series>> _series;
+    Index _index;
+    std::vector<std::uint8_t> _payload;
+    mutable std::vector<std::uint8_t> _readBuffer;
+};
+}
+}
+}
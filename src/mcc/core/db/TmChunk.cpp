@@ -0,0 +1,374 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <cassert>
+
+#include "mcc/core/db/TmChunk.h"
+
+
+namespace mcc {
+namespace core {
+namespace db {
+
+using mcc::misc::NetVariant;
+using mcc::misc::NetVariantType;
+using mcc::misc::Timestamp;
+
+//окно значащих бит ещё не задано
+static const unsigned noWindow = 64;
+static const unsigned maxLeading = 31;
+
+static unsigned leadingZeros(std::uint64_t value)
+{
+    unsigned n = 0;
+    for (unsigned shift = 32; shift > 0; shift /= 2)
+    {
+        if ((value >> (64 - shift)) == 0)
+        {
+            n += shift;
+            value <<= shift;
+        }
+    }
+    return n;
+}
+
+static unsigned trailingZeros(std::uint64_t value)
+{
+    unsigned n = 0;
+    for (unsigned shift = 32; shift > 0; shift /= 2)
+    {
+        if ((value & ((std::uint64_t(1) << shift) - 1)) == 0)
+        {
+            n += shift;
+            value >>= shift;
+        }
+    }
+    return n;
+}
+
+static std::uint64_t zigzag(std::int64_t value)
+{
+    return ((std::uint64_t)value << 1) ^ (std::uint64_t)(value >> 63);
+}
+
+static std::int64_t unzigzag(std::uint64_t value)
+{
+    return (std::int64_t)(value >> 1) ^ -(std::int64_t)(value & 1);
+}
+
+NetVariantType TmChunkWriter::storedType(NetVariantType type)
+{
+    return type == NetVariantType::QString ? NetVariantType::String : type;
+}
+
+TmChunkWriter::TmChunkWriter(NetVariantType type)
+{
+    reset(type);
+}
+
+void TmChunkWriter::reset(NetVariantType type)
+{
+    _type = storedType(type);
+    _data.clear();
+    _bitPos = 0;
+    _count = 0;
+    _min = 0;
+    _max = 0;
+    _last = 0;
+    _delta = 0;
+    _bits = 0;
+    _leading = noWindow;
+    _trailing = 0;
+    _string.clear();
+}
+
+void TmChunkWriter::write(std::uint64_t value, unsigned bits)
+{
+    while (bits > 0)
+    {
+        if (_bitPos == 0)
+            _data.push_back(0);
+        unsigned free = 8 - _bitPos;
+        unsigned n = std::min(free, bits);
+        std::uint8_t part = (std::uint8_t)((value >> (bits - n)) & ((1u << n) - 1));
+        _data.back() |= (std::uint8_t)(part << (free - n));
+        _bitPos = (_bitPos + n) & 7;
+        bits -= n;
+    }
+}
+
+void TmChunkWriter::appendTime(Timestamp time)
+{
+    if (_count == 0)
+    {
+        write((std::uint64_t)time, 64);
+        _min = time;
+        _max = time;
+        _last = time;
+        return;
+    }
+
+    std::int64_t delta = time - _last;
+    std::uint64_t dod = zigzag(delta - _delta);
+    if (dod == 0)
+        write(0, 1);
+    else if (dod < (std::uint64_t(1) << 12))
+    {
+        write(2, 2);
+        write(dod, 12);
+    }
+    else if (dod < (std::uint64_t(1) << 24))
+    {
+        write(6, 3);
+        write(dod, 24);
+    }
+    else if (dod < (std::uint64_t(1) << 32))
+    {
+        write(14, 4);
+        write(dod, 32);
+    }
+    else
+    {
+        write(15, 4);
+        write(dod, 64);
+    }
+    _delta = delta;
+    _last = time;
+    _min = std::min(_min, time);
+    _max = std::max(_max, time);
+}
+
+void TmChunkWriter::appendBits(std::uint64_t bits)
+{
+    if (_count == 0)
+    {
+        write(bits, 64);
+        _bits = bits;
+        return;
+    }
+
+    std::uint64_t x = bits ^ _bits;
+    _bits = bits;
+    if (x == 0)
+    {
+        write(0, 1);
+        return;
+    }
+
+    unsigned leading = std::min(leadingZeros(x), maxLeading);
+    unsigned trailing = trailingZeros(x);
+    if (_leading != noWindow && leading >= _leading && trailing >= _trailing)
+    {
+        //значащие биты помещаются в окно предыдущего значения
+        write(2, 2);
+        write(x >> _trailing, 64 - _leading - _trailing);
+        return;
+    }
+
+    unsigned size = 64 - leading - trailing;
+    write(3, 2);
+    write(leading, 5);
+    write(size - 1, 6);
+    write(x >> trailing, size);
+    _leading = leading;
+    _trailing = trailing;
+}
+
+void TmChunkWriter::appendString(const char* data, std::size_t size)
+{
+    if (_count != 0 && _string.size() == size && std::equal(data, data + size, _string.begin()))
+    {
+        write(0, 1);
+        return;
+    }
+    write(1, 1);
+    write(size, 32);
+    for (std::size_t i = 0; i < size; i++)
+        write((std::uint8_t)data[i], 8);
+    _string.assign(data, size);
+}
+
+void TmChunkWriter::append(Timestamp time, const NetVariant& value)
+{
+    assert(storedType(value.type()) == _type);
+    appendTime(time);
+    switch (_type)
+    {
+    case NetVariantType::None:
+        break;
+    case NetVariantType::String:
+        if (value.isQString())
+        {
+            std::string str = value.asQString().toStdString();
+            appendString(str.data(), str.size());
+        }
+        else
+            appendString(value.stringData(), value.stringSize());
+        break;
+    default:
+        appendBits(value.numericBits());
+    }
+    ++_count;
+}
+
+TmChunkReader::TmChunkReader(NetVariantType type, const std::uint8_t* data, std::size_t size, std::uint32_t count)
+    : _type(type), _data(data), _size(size), _bitPos(0), _count(count), _index(0), _isCorrupted(false)
+    , _last(0), _delta(0), _bits(0), _leading(noWindow), _trailing(0)
+{
+}
+
+bool TmChunkReader::read(unsigned bits, std::uint64_t* value)
+{
+    if (_bitPos + bits > _size * 8)
+        return false;
+    std::uint64_t result = 0;
+    while (bits > 0)
+    {
+        unsigned offset = _bitPos & 7;
+        unsigned n = std::min(8 - offset, bits);
+        std::uint8_t byte = _data[_bitPos / 8];
+        result = (result << n) | ((byte >> (8 - offset - n)) & ((1u << n) - 1));
+        _bitPos += n;
+        bits -= n;
+    }
+    *value = result;
+    return true;
+}
+
+bool TmChunkReader::readTime(Timestamp* time)
+{
+    std::uint64_t value;
+    if (_index == 0)
+    {
+        if (!read(64, &value))
+            return false;
+        _last = (Timestamp)value;
+        *time = _last;
+        return true;
+    }
+
+    //префикс из единиц задаёт размер разности
+    static const unsigned sizes[] = {0, 12, 24, 32, 64};
+    unsigned prefix = 0;
+    while (prefix < 4)
+    {
+        if (!read(1, &value))
+            return false;
+        if (value == 0)
+            break;
+        ++prefix;
+    }
+    std::uint64_t dod = 0;
+    if (sizes[prefix] != 0 && !read(sizes[prefix], &dod))
+        return false;
+    _delta += unzigzag(dod);
+    _last += _delta;
+    *time = _last;
+    return true;
+}
+
+bool TmChunkReader::readBits(std::uint64_t* bits)
+{
+    std::uint64_t value;
+    if (_index == 0)
+    {
+        if (!read(64, &_bits))
+            return false;
+        *bits = _bits;
+        return true;
+    }
+
+    if (!read(1, &value))
+        return false;
+    if (value == 0)
+    {
+        *bits = _bits;
+        return true;
+    }
+    if (!read(1, &value))
+        return false;
+    if (value == 0)
+    {
+        if (_leading == noWindow || !read(64 - _leading - _trailing, &value))
+            return false;
+        _bits ^= value << _trailing;
+        *bits = _bits;
+        return true;
+    }
+
+    std::uint64_t leading;
+    std::uint64_t size;
+    if (!read(5, &leading) || !read(6, &size))
+        return false;
+    size += 1;
+    if (leading + size > 64 || !read((unsigned)size, &value))
+        return false;
+    _leading = (unsigned)leading;
+    _trailing = (unsigned)(64 - leading - size);
+    _bits ^= value << _trailing;
+    *bits = _bits;
+    return true;
+}
+
+bool TmChunkReader::readString()
+{
+    std::uint64_t value;
+    if (!read(1, &value))
+        return false;
+    if (value == 0)
+        return _index != 0;
+    std::uint64_t size;
+    if (!read(32, &size) || _bitPos + size * 8 > _size * 8)
+        return false;
+    _string.resize(size);
+    for (std::size_t i = 0; i < size; i++)
+    {
+        read(8, &value);
+        _string[i] = (char)value;
+    }
+    return true;
+}
+
+bool TmChunkReader::next(Timestamp* time, NetVariant* value)
+{
+    if (_index >= _count || _isCorrupted)
+        return false;
+    if (!readTime(time))
+    {
+        _isCorrupted = true;
+        return false;
+    }
+
+    switch (_type)
+    {
+    case NetVariantType::None:
+        *value = NetVariant();
+        break;
+    case NetVariantType::String:
+        if (!readString())
+        {
+            _isCorrupted = true;
+            return false;
+        }
+        *value = NetVariant(_string);
+        break;
+    case NetVariantType::QString:
+        _isCorrupted = true;
+        return false;
+    default:
+        std::uint64_t bits;
+        if (!readBits(&bits))
+        {
+            _isCorrupted = true;
+            return false;
+        }
+        *value = NetVariant::fromNumericBits(_type, bits);
+    }
+    ++_index;
+    return true;
+}
+}
+}
+}
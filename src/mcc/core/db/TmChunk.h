@@ -0,0 +1,94 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mcc/misc/NetVariant.h"
+#include "mcc/misc/TimeUtils.h"
+
+
+namespace mcc {
+namespace core {
+namespace db {
+
+//Сжатая последовательность (время, значение) одного параметра одного типа, как в Gorilla:
+//время - разность разностей соседних отметок, числа - xor с предыдущим значением
+//(NetVariant::numericBits, так что целые и float сжимаются так же), строки - бит "не изменилась"
+//или длина и байты. Типичный кадр 50 Гц с медленно меняющимися значениями занимает единицы байт на точку
+class TmChunkWriter
+{
+public:
+    //QString хранится как String
+    static mcc::misc::NetVariantType storedType(mcc::misc::NetVariantType type);
+
+    explicit TmChunkWriter(mcc::misc::NetVariantType type = mcc::misc::NetVariantType::None);
+
+    //тип значения должен совпадать с type() с точностью до storedType
+    void append(mcc::misc::Timestamp time, const mcc::misc::NetVariant& value);
+    //очищает с сохранением памяти
+    void reset(mcc::misc::NetVariantType type);
+
+    mcc::misc::NetVariantType type() const { return _type; }
+    std::uint32_t count() const { return _count; }
+    bool isEmpty() const { return _count == 0; }
+    //границы времени точек, время не обязано возрастать
+    mcc::misc::Timestamp minTime() const { return _min; }
+    mcc::misc::Timestamp maxTime() const { return _max; }
+    const std::vector<std::uint8_t>& data() const { return _data; }
+
+private:
+    void write(std::uint64_t value, unsigned bits);
+    void appendTime(mcc::misc::Timestamp time);
+    void appendBits(std::uint64_t bits);
+    void appendString(const char* data, std::size_t size);
+
+    mcc::misc::NetVariantType _type;
+    std::vector<std::uint8_t> _data;
+    unsigned _bitPos;
+    std::uint32_t _count;
+    mcc::misc::Timestamp _min;
+    mcc::misc::Timestamp _max;
+    mcc::misc::Timestamp _last;
+    std::int64_t _delta;
+    std::uint64_t _bits;
+    unsigned _leading;
+    unsigned _trailing;
+    std::string _string;
+};
+
+class TmChunkReader
+{
+public:
+    TmChunkReader(mcc::misc::NetVariantType type, const std::uint8_t* data, std::size_t size, std::uint32_t count);
+
+    //false в конце или на повреждённых данных
+    bool next(mcc::misc::Timestamp* time, mcc::misc::NetVariant* value);
+    bool isCorrupted() const { return _isCorrupted; }
+
+private:
+    bool read(unsigned bits, std::uint64_t* value);
+    bool readTime(mcc::misc::Timestamp* time);
+    bool readBits(std::uint64_t* bits);
+    bool readString();
+
+    mcc::misc::NetVariantType _type;
+    const std::uint8_t* _data;
+    std::size_t _size;
+    std::size_t _bitPos;
+    std::uint32_t _count;
+    std::uint32_t _index;
+    bool _isCorrupted;
+    mcc::misc::Timestamp _last;
+    std::int64_t _delta;
+    std::uint64_t _bits;
+    unsigned _leading;
+    unsigned _trailing;
+    std::string _string;
+};
+}
+}
+}
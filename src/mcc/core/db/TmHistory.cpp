@@ -0,0 +1,132 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+
+#include "mcc/core/db/TmHistory.h"
+
+
+namespace mcc {
+namespace core {
+namespace db {
+
+using mcc::messages::TmHistoryPoint;
+using mcc::messages::TmHistoryPoints;
+using mcc::misc::NetVariant;
+using mcc::misc::Timestamp;
+
+TmHistoryBuilder::TmHistoryBuilder(Timestamp from, Timestamp bucket, std::size_t maxPoints, const Sink& sink)
+    : _from(from), _bucket(std::max<Timestamp>(bucket, 0)), _maxPoints(std::max<std::size_t>(maxPoints, 1)), _sink(sink)
+    , _bucketIndex(0), _count(0), _min(0), _max(0), _sum(0)
+{
+}
+
+void TmHistoryBuilder::push_(TmHistoryPoint&& point)
+{
+    _points.push_back(std::move(point));
+    if (_points.size() < _maxPoints)
+        return;
+    _sink(std::move(_points));
+    _points.clear();
+}
+
+void TmHistoryBuilder::closeBucket_()
+{
+    if (_count == 0)
+        return;
+    Timestamp time = _from + _bucketIndex * _bucket;
+    if (NetVariant::isNumeric(_last.type()))
+        push_(TmHistoryPoint(time, NetVariant(_sum / _count), _min, _max, _count));
+    else
+        push_(TmHistoryPoint(time, _last, 0, 0, _count));
+    _count = 0;
+}
+
+void TmHistoryBuilder::add(Timestamp time, const NetVariant& value)
+{
+    if (_bucket == 0)
+    {
+        push_(TmHistoryPoint(time, value));
+        return;
+    }
+
+    std::int64_t index = (time - _from) / _bucket;
+    if (_count != 0 && (index != _bucketIndex || value.type() != _last.type()))
+        closeBucket_();
+    if (_count == 0)
+        _bucketIndex = index;
+
+    if (NetVariant::isNumeric(value.type()))
+    {
+        double v = value.toDouble();
+        _min = _count == 0 ? v : std::min(_min, v);
+        _max = _count == 0 ? v : std::max(_max, v);
+        _sum = _count == 0 ? v : _sum + v;
+    }
+    _last = value;
+    _count++;
+}
+
+void TmHistoryBuilder::finish()
+{
+    closeBucket_();
+    if (_points.empty())
+        return;
+    _sink(std::move(_points));
+    _points.clear();
+}
+
+TmHistoryCursor::TmHistoryCursor(const TmArchive* archive, const mcc::messages::TmHistory_Request& request)
+    : _archive(archive), _device(request.device()), _params(request.params()), _from(request.from()), _to(request.to())
+    , _bucket(request.bucket()), _maxPoints(request.maxPoints()), _param(0), _part(0), _isDone(false)
+{
+    if (_params.empty())
+        _params = archive->params(_device);
+}
+
+bool TmHistoryCursor::step(std::size_t maxChunks, const Sink& sink)
+{
+    if (_isDone)
+        return false;
+
+    std::size_t budget = std::max<std::size_t>(maxChunks, 1);
+    while (budget > 0 && _param < _params.size())
+    {
+        const mcc::messages::TmParamName& param = _params[_param];
+        if (!_builder)
+        {
+            _builder.reset(new TmHistoryBuilder(_from, _bucket, _maxPoints, [this, &param](TmHistoryPoints&& points)
+            {
+                Part part = {param, std::move(points)};
+                _ready.push_back(std::move(part));
+            }));
+        }
+        TmHistoryBuilder* builder = _builder.get();
+        std::size_t count = _archive->scanSome(_device, param.trait, param.status, _from, _to, budget, &_cursor,
+                                               [builder](Timestamp time, const NetVariant& value) { builder->add(time, value); });
+        //даже ряд без кусков занимает шаг, чтобы запрос по многим пустым рядам тоже шёл частями
+        budget -= std::min(budget, std::max<std::size_t>(count, 1));
+        if (!_cursor.isDone)
+            continue;
+        _builder->finish();
+        _builder.reset();
+        _cursor = TmArchive::Cursor();
+        _param++;
+    }
+    _isDone = _param == _params.size();
+
+    while (_ready.size() > 1 || (_isDone && !_ready.empty()))
+    {
+        Part& part = _ready.front();
+        sink(part.param, std::move(part.points), _part++, _isDone && _ready.size() == 1);
+        _ready.pop_front();
+    }
+    //точек нет - всё равно отвечаем, чтобы запрос завершился
+    if (_isDone && _part == 0)
+        sink(mcc::messages::TmParamName(std::string(), std::string()), TmHistoryPoints(), _part++, true);
+    return !_isDone;
+}
+}
+}
+}
@@ -0,0 +1,96 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+
+#include "mcc/misc/NetVariant.h"
+#include "mcc/misc/TimeUtils.h"
+#include "mcc/messages/Tm.h"
+#include "mcc/core/db/TmArchive.h"
+
+
+namespace mcc {
+namespace core {
+namespace db {
+
+//Режет поток точек одного параметра на части TmHistory_Response не больше maxPoints точек.
+//При bucket != 0 точки корзины [from + k * bucket, from + (k + 1) * bucket) сворачиваются в одну
+//с min/max/средним. Точки ожидаются по возрастанию времени, точка из уже закрытой корзины
+//открывает её заново отдельной точкой
+class TmHistoryBuilder
+{
+public:
+    typedef std::function<void(mcc::messages::TmHistoryPoints&& points)> Sink;
+
+    TmHistoryBuilder(mcc::misc::Timestamp from, mcc::misc::Timestamp bucket, std::size_t maxPoints, const Sink& sink);
+
+    void add(mcc::misc::Timestamp time, const mcc::misc::NetVariant& value);
+    //отдаёт незакрытую корзину и остаток точек
+    void finish();
+
+private:
+    void push_(mcc::messages::TmHistoryPoint&& point);
+    void closeBucket_();
+
+    mcc::misc::Timestamp _from;
+    mcc::misc::Timestamp _bucket;
+    std::size_t _maxPoints;
+    Sink _sink;
+    mcc::messages::TmHistoryPoints _points;
+
+    std::int64_t _bucketIndex;
+    std::uint32_t _count;
+    double _min;
+    double _max;
+    double _sum;
+    mcc::misc::NetVariant _last;
+};
+
+//Ответ на один TmHistory_Request, прочитанный по частям: каждый step() читает из архива не больше
+//maxChunks кусков и отдаёт готовые части. Последняя часть приходит с isLast, даже если точек нет.
+//Архив должен пережить курсор
+class TmHistoryCursor
+{
+public:
+    typedef std::function<void(const mcc::messages::TmParamName& param, mcc::messages::TmHistoryPoints&& points,
+                               std::uint32_t part, bool isLast)> Sink;
+
+    TmHistoryCursor(const TmArchive* archive, const mcc::messages::TmHistory_Request& request);
+    TmHistoryCursor(const TmHistoryCursor&) = delete;
+    TmHistoryCursor& operator=(const TmHistoryCursor&) = delete;
+
+    //false - ответ отправлен целиком
+    bool step(std::size_t maxChunks, const Sink& sink);
+    bool isDone() const { return _isDone; }
+
+private:
+    struct Part
+    {
+        mcc::messages::TmParamName param;
+        mcc::messages::TmHistoryPoints points;
+    };
+
+    const TmArchive* _archive;
+    std::string _device;
+    mcc::messages::TmParamNames _params;
+    mcc::misc::Timestamp _from;
+    mcc::misc::Timestamp _to;
+    mcc::misc::Timestamp _bucket;
+    std::size_t _maxPoints;
+
+    std::size_t _param;
+    TmArchive::Cursor _cursor;
+    std::unique_ptr<TmHistoryBuilder> _builder;
+    //последняя готовая часть придерживается, пока не ясно, будет ли она последней
+    std::deque<Part> _ready;
+    std::uint32_t _part;
+    bool _isDone;
+};
+}
+}
+}
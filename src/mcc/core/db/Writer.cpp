@@ -0,0 +1,223 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+
+#include "mcc/core/db/Writer.h"
+#include "mcc/messages/Device.h"
+#include "mcc/messages/Firmware.h"
+#include "mcc/messages/MessageSender.h"
+
+#include "mcc/core/db/queries/Cmd.h"
+#include "mcc/core/db/queries/CmdState.h"
+#include "mcc/core/db/queries/TmParamList.h"
+#include "mcc/core/db/queries/DeviceActionLog.h"
+#include "mcc/core/db/queries/ProtocolForDeviceRegister_Request.h"
+
+
+namespace mcc {
+namespace core {
+namespace db {
+
+namespace queries
+{
+    extern void execute(DbHandle* db, const mcc::messages::MessageSender& sender, std::unique_ptr<mcc::messages::FirmwareRegister_Request>&&);
+    extern void execute(DbHandle* db, const mcc::messages::MessageSender& sender, std::unique_ptr<mcc::messages::DeviceUpdate_Request>&&);
+    extern void execute(DbHandle* db, const mcc::messages::MessageSender& sender, std::unique_ptr<mcc::messages::DeviceRegister_Request>&&);
+    extern void execute(DbHandle* db, const mcc::messages::MessageSender& sender, std::unique_ptr<mcc::messages::DeviceUnRegister_Request>&&);
+}
+
+static const std::size_t batchSize = 256;
+
+Writer::Writer(const mcc::messages::MessageSender& out, const Options& options)
+    : mcc::messages::MessageProcessor(out)
+    , _options(options)
+    , _out(out)
+    , _isRunning(false)
+    , _commits(0)
+    , _isInTransaction(false)
+    , _pending(0)
+{
+    handle<mcc::messages::Cmd>();
+    handle<mcc::messages::CmdState>();
+    handle<mcc::messages::DeviceActionLog>();
+    handle<mcc::messages::TmParamList>();
+    handle<mcc::messages::DeviceRegister_Request>();
+    handle<mcc::messages::DeviceUnRegister_Request>();
+    handle<mcc::messages::DeviceUpdate_Request>();
+    handle<mcc::messages::FirmwareRegister_Request>();
+    handle<mcc::messages::ProtocolForDeviceRegister_Request>();
+}
+
+Writer::~Writer()
+{
+    stop();
+}
+
+bool Writer::start(const QString& path)
+{
+    stop();
+    _isRunning = true;
+    std::promise<bool> isStarted;
+    auto result = isStarted.get_future();
+    _thread = std::thread(&Writer::run, this, path, &isStarted);
+    if (result.get())
+        return true;
+    _isRunning = false;
+    _thread.join();
+    return false;
+}
+
+void Writer::stop()
+{
+    _isRunning = false;
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void Writer::post(mcc::messages::MessagePtr&& message)
+{
+    _queue.send(std::move(message));
+}
+
+void Writer::run(QString path, std::promise<bool>* isStarted)
+{
+    //соединение и запросы Qt должны создаваться в потоке, который ими пользуется
+    _db.reset(new DbHandle("mcc-write"));
+    if (!_db->start(path))
+    {
+        _db.reset();
+        isStarted->set_value(false);
+        return;
+    }
+    _db->speedupSqlite();
+    _cmd.reset(new queries::Cmd(_db.get()));
+    _cmdstate.reset(new queries::CmdState(_db.get()));
+    _tmparamlist.reset(new queries::TmParamList(_db.get()));
+    _actions.reset(new queries::DeviceActionLog(_db.get()));
+    _protocolfordeviceregister.reset(new queries::ProtocolForDeviceRegister_Request(_db.get(), _out));
+    isStarted->set_value(true);
+
+    //после stop() дописываем всё, что успели прислать
+    while (_isRunning || !_queue.isEmpty())
+    {
+        auto wait = std::chrono::milliseconds(100);
+        if (_isInTransaction)
+        {
+            auto age = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _transactionStart);
+            wait = std::max(std::chrono::milliseconds(0), std::min(wait, _options.commitLatency - age));
+        }
+        _queue.recvAllFor(&_batch, batchSize, wait);
+        for (auto& m : _batch)
+            chooseProcessor(std::move(m));
+        _batch.clear();
+
+        if (_isInTransaction && std::chrono::steady_clock::now() - _transactionStart >= _options.commitLatency)
+            commit_();
+    }
+    commit_();
+
+    _cmd.reset();
+    _cmdstate.reset();
+    _tmparamlist.reset();
+    _actions.reset();
+    _protocolfordeviceregister.reset();
+    _db->stop();
+    _db.reset();
+}
+
+void Writer::begin_()
+{
+    if (_isInTransaction)
+        return;
+    _db->begin();
+    _isInTransaction = true;
+    _transactionStart = std::chrono::steady_clock::now();
+}
+
+void Writer::written_(std::size_t rows)
+{
+    _pending += rows;
+    if (_pending >= _options.commitRows)
+        commit_();
+}
+
+void Writer::commit_()
+{
+    if (!_isInTransaction)
+        return;
+    _tmparamlist->flush();
+    _db->commit();
+    _isInTransaction = false;
+    _pending = 0;
+    ++_commits;
+}
+
+void Writer::process(std::unique_ptr<mcc::messages::Cmd>&& message)
+{
+    begin_();
+    _cmd->execute(std::move(message));
+    written_(1);
+}
+
+void Writer::process(std::unique_ptr<mcc::messages::CmdState>&& message)
+{
+    begin_();
+    _cmdstate->execute(std::move(message));
+    written_(1);
+}
+
+void Writer::process(std::unique_ptr<mcc::messages::DeviceActionLog>&& message)
+{
+    begin_();
+    _actions->execute(std::move(message));
+    written_(1);
+}
+
+void Writer::process(std::unique_ptr<mcc::messages::TmParamList>&& message)
+{
+    begin_();
+    std::size_t rows = message->params().size();
+    _tmparamlist->execute(std::move(message));
+    written_(rows);
+}
+
+//запросы регистрации сами управляют транзакцией: накопленное фиксируется до них,
+//а кэш идентификаторов телеметрии сбрасывается
+void Writer::process(std::unique_ptr<mcc::messages::DeviceRegister_Request>&& request)
+{
+    commit_();
+    _tmparamlist->invalidate();
+    queries::execute(_db.get(), _out, std::move(request));
+}
+
+void Writer::process(std::unique_ptr<mcc::messages::DeviceUnRegister_Request>&& request)
+{
+    commit_();
+    _tmparamlist->invalidate();
+    queries::execute(_db.get(), _out, std::move(request));
+}
+
+void Writer::process(std::unique_ptr<mcc::messages::DeviceUpdate_Request>&& request)
+{
+    commit_();
+    _tmparamlist->invalidate();
+    queries::execute(_db.get(), _out, std::move(request));
+}
+
+void Writer::process(std::unique_ptr<mcc::messages::FirmwareRegister_Request>&& request)
+{
+    commit_();
+    _tmparamlist->invalidate();
+    queries::execute(_db.get(), _out, std::move(request));
+}
+
+void Writer::process(std::unique_ptr<mcc::messages::ProtocolForDeviceRegister_Request>&& request)
+{
+    commit_();
+    _protocolfordeviceregister->execute(std::move(request));
+}
+}
+}
+}
@@ -0,0 +1,96 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <QString>
+
+#include "mcc/misc/Channel.h"
+#include "mcc/messages/Message.h"
+#include "mcc/core/db/DbHandle.h"
+
+
+namespace mcc { namespace core { namespace db { namespace queries
+{
+    class Cmd;
+    class CmdState;
+    class TmParamList;
+    class DeviceActionLog;
+    class ProtocolForDeviceRegister_Request;
+}}}}
+
+
+namespace mcc {
+namespace core {
+namespace db {
+
+//Поток записи в базу со своим соединением: сервис отдаёт сюда все изменяющие базу сообщения
+//и отвечает на запросы чтения из своего соединения, не дожидаясь записи телеметрии.
+//Записи копятся в одной транзакции, которая фиксируется, когда набралось commitRows строк
+//или первой незафиксированной записи исполнилось commitLatency (group commit).
+//Регистрация устройств и прошивок фиксируется сразу, чтобы после ответа её видели читатели.
+class Writer : public mcc::messages::MessageProcessor
+{
+public:
+    struct Options
+    {
+        Options() : commitRows(4096), commitLatency(std::chrono::milliseconds(500)) {}
+        std::size_t commitRows;
+        std::chrono::milliseconds commitLatency;
+    };
+
+    Writer(const mcc::messages::MessageSender& out, const Options& options = Options());
+    ~Writer();
+
+    //открывает базу в потоке записи, false - если не открылась
+    bool start(const QString& path);
+    //записывает и фиксирует всё принятое
+    void stop();
+    void post(mcc::messages::MessagePtr&& message);
+
+    std::size_t commitCount() const { return _commits; }
+
+private:
+    void run(QString path, std::promise<bool>* isStarted);
+    void begin_();
+    void written_(std::size_t rows);
+    void commit_();
+
+    void process(std::unique_ptr<mcc::messages::Cmd>&&) override;
+    void process(std::unique_ptr<mcc::messages::CmdState>&&) override;
+    void process(std::unique_ptr<mcc::messages::DeviceActionLog>&&) override;
+    void process(std::unique_ptr<mcc::messages::TmParamList>&&) override;
+    void process(std::unique_ptr<mcc::messages::DeviceRegister_Request>&&) override;
+    void process(std::unique_ptr<mcc::messages::DeviceUnRegister_Request>&&) override;
+    void process(std::unique_ptr<mcc::messages::DeviceUpdate_Request>&&) override;
+    void process(std::unique_ptr<mcc::messages::FirmwareRegister_Request>&&) override;
+    void process(std::unique_ptr<mcc::messages::ProtocolForDeviceRegister_Request>&&) override;
+
+    Options _options;
+    mcc::messages::MessageSender _out;
+    mcc::misc::Channel<mcc::messages::MessagePtr> _queue;
+    std::atomic<bool> _isRunning;
+    std::atomic<std::size_t> _commits;
+    std::thread _thread;
+
+    //всё ниже используется только из потока записи
+    std::unique_ptr<DbHandle> _db;
+    std::unique_ptr<queries::Cmd> _cmd;
+    std::unique_ptr<queries::CmdState> _cmdstate;
+    std::unique_ptr<queries::TmParamList> _tmparamlist;
+    std::unique_ptr<queries::DeviceActionLog> _actions;
+    std::unique_ptr<queries::ProtocolForDeviceRegister_Request> _protocolfordeviceregister;
+    std::vector<mcc::messages::MessagePtr> _batch;
+    bool _isInTransaction;
+    std::size_t _pending;
+    std::chrono::steady_clock::time_point _transactionStart;
+};
+}
+}
+}
@@ -46,7 +46,7 @@ public:
         _query.bindValue(":trait", QString::fromStdString(cmd->trait()));
         _query.bindValue(":name", QString::fromStdString(cmd->command()));
         _query.bindValue(":params", QString::fromStdString(cmd->paramsAsString(",")));
-        _query.bindValue(":time", QString::fromStdString(cmd->time()));
+        _query.bindValue(":time", QString::fromStdString(mcc::misc::formatTimestamp(cmd->time())));
         _query.bindValue(":collation_id", cmd->cmdId());
         auto id = execInsert(_query);
     }
@@ -29,7 +29,7 @@ public:
         _query.bindValue(":device", QString::fromStdString(state->device()));
         _query.bindValue(":collation_id", state->cmdId());
         _query.bindValue(":state", state->state());
-        _query.bindValue(":time", QString::fromStdString(state->time()));
+        _query.bindValue(":time", QString::fromStdString(mcc::misc::formatTimestamp(state->time())));
         _query.bindValue(":reason", QString::fromStdString(state->reason()));
         auto id = execInsert(_query);
     }
@@ -36,7 +36,7 @@ public:
         }
     void execute(std::unique_ptr<mcc::messages::DeviceActionLog>&& log)
     {
-        _query.bindValue(":time", QString::fromStdString(log->time()));
+        _query.bindValue(":time", QString::fromStdString(mcc::misc::formatTimestamp(log->time())));
         _query.bindValue(":kind", QString::fromStdString(log->kind()));
         _query.bindValue(":name", QString::fromStdString(log->name()));
         _query.bindValue(":action", QString::fromStdString(log->action()));
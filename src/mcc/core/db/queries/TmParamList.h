@@ -3,6 +3,8 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <unordered_map>
+#include <vector>
 #include <QSqlQuery>
 
 #include "mcc/messages/Tm.h"
@@ -15,67 +17,176 @@ namespace core {
 namespace db {
 namespace queries {
 
+//Запись телеметрии в mcc_tm.
+//Идентификаторы устройства и параметров берутся из кэша: параметры прошивки загружаются
+//одним запросом при первом кадре устройства с этой прошивкой. Строки копятся и вставляются
+//пачками по batchRows одним многострочным insert, остаток - в flush()
 class TmParamList
 {
 public:
+    //4 переменные на строку, sqlite по умолчанию допускает не более 999 переменных в запросе
+    static const std::size_t batchRows = 128;
+
     TmParamList(DbHandle* db)
     {
-        _query = db->getQueryHandle();
-        bool r = _query.prepare("insert into mcc_tm ( time       \
-                                            , value     \
-                                            , device_id \
-                                            , param_id  \
-                                            )           \
-                                    values  ( :time     \
-                                            , :value    \
-                                            , (select id from device where name = :device)  \
-                                            ,   (select trait_field.id                      \
-                                                    from trait                              \
-                                                        , trait_field                       \
-                                                    where trait.firmware_id = (select firmware_id from device where name = :device) \
-                                                    and trait.unique_name    =:trait        \
-                                                    and trait_field.trait_id =trait.id      \
-                                                    and trait_field.name     =:name         \
-                                                )       \
-                                            );          \
-                        ");
+        _insertOne = db->getQueryHandle();
+        bool r = _insertOne.prepare(insertText(1));
         assert(r);
-    //     query.prepare("insert into mcc_tm(device_id \
-    //                                     , time      \
-    //                                     , trait     \
-    //                                     , name      \
-    //                                     , value     \
-    //                                     )           \
-    //                             values  ( (select id from device where name = :device)  \
-    //                                     , :time     \
-    //                                     , :trait    \
-    //                                     , :name     \
-    //                                     , :value    \
-    //                                     );          \
-    //                     ");
-        }
+        _insertBatch = db->getQueryHandle();
+        r = _insertBatch.prepare(insertText(batchRows));
+        assert(r);
+        _selectDevice = db->getQueryHandle();
+        r = _selectDevice.prepare("select id, firmware_id from device where name = :device");
+        assert(r);
+        _selectParams = db->getQueryHandle();
+        r = _selectParams.prepare("select trait.unique_name     \
+                                        , trait_field.name      \
+                                        , trait_field.id        \
+                                    from trait                  \
+                                        , trait_field           \
+                                    where trait.firmware_id  = :firmware \
+                                    and trait_field.trait_id = trait.id  \
+                                ");
+        assert(r);
+        (void)r;
+    }
+
     void execute(std::unique_ptr<mcc::messages::TmParamList>&& list)
     {
+        const Device* device = findDevice(list->device());
+        if (!device)
+            return;
 
+        QString time = QString::fromStdString(mcc::misc::formatTimestamp(list->time()));
         for (const auto& p : list->params())
         {
-            _query.bindValue(":device", QString::fromStdString(list->device()));
-            _query.bindValue(":trait", QString::fromStdString(p.trait()));
-            _query.bindValue(":name", QString::fromStdString(p.status()));
-            _query.bindValue(":value", p.value().toQVariant());
-            _query.bindValue(":time", QString::fromStdString(list->time()));
-            auto id = execInsert(_query, false);
-            //if (id.isOk())
-            //    qDebug() << id.take();
-            //printIfErr(execInsert(query));
+            //параметра нет в прошивке устройства - раньше такая вставка падала на not null
+            auto trait = device->params->find(p.trait());
+            if (trait == device->params->end())
+                continue;
+            auto param = trait->second.find(p.status());
+            if (param == trait->second.end())
+                continue;
+
+            _rows.emplace_back();
+            Row& row = _rows.back();
+            row.time = time;
+            row.value = p.value().toQVariant();
+            row.device = device->id;
+            row.param = param->second;
+            if (_rows.size() >= batchRows)
+                insertBatch();
+        }
+    }
+
+    //вставляет накопленные строки, вызывается перед фиксацией транзакции
+    void flush()
+    {
+        for (const Row& row : _rows)
+        {
+            bind(&_insertOne, 0, row);
+            printIfErr(execInsert(_insertOne));
         }
+        _rows.clear();
+    }
+
+    //устройства или прошивки изменились - идентификаторы будут перечитаны
+    void invalidate()
+    {
+        flush();
+        _devices.clear();
+        _firmwares.clear();
     }
+
 private:
-    QSqlQuery _query;
+    typedef std::unordered_map<std::string, std::unordered_map<std::string, qlonglong>> Params;
+
+    struct Device
+    {
+        qlonglong id;
+        //nullptr - устройство не зарегистрировано
+        const Params* params;
+    };
+
+    struct Row
+    {
+        QString time;
+        QVariant value;
+        qlonglong device;
+        qlonglong param;
+    };
+
+    static QString insertText(std::size_t rows)
+    {
+        QString text = "insert into mcc_tm (time, value, device_id, param_id) values (?, ?, ?, ?)";
+        for (std::size_t i = 1; i < rows; i++)
+            text += ", (?, ?, ?, ?)";
+        return text;
+    }
+
+    static void bind(QSqlQuery* query, int index, const Row& row)
+    {
+        query->bindValue(index * 4 + 0, row.time);
+        query->bindValue(index * 4 + 1, row.value);
+        query->bindValue(index * 4 + 2, row.device);
+        query->bindValue(index * 4 + 3, row.param);
+    }
+
+    void insertBatch()
+    {
+        for (std::size_t i = 0; i < _rows.size(); i++)
+            bind(&_insertBatch, (int)i, _rows[i]);
+        printIfErr(execInsert(_insertBatch));
+        _rows.clear();
+    }
+
+    const Device* findDevice(const std::string& name)
+    {
+        auto i = _devices.find(name);
+        if (i == _devices.end())
+        {
+            //неизвестное устройство тоже кэшируется, до invalidate()
+            Device device = {0, nullptr};
+            _selectDevice.bindValue(":device", QString::fromStdString(name));
+            if (execSelect(_selectDevice).isNone() && _selectDevice.next())
+            {
+                device.id = _selectDevice.value(0).toLongLong();
+                device.params = &loadParams(_selectDevice.value(1).toLongLong());
+            }
+            _selectDevice.finish();
+            i = _devices.emplace(name, device).first;
+        }
+        return i->second.params ? &i->second : nullptr;
+    }
+
+    const Params& loadParams(qlonglong firmware)
+    {
+        auto i = _firmwares.find(firmware);
+        if (i != _firmwares.end())
+            return i->second;
+
+        Params& params = _firmwares[firmware];
+        _selectParams.bindValue(":firmware", firmware);
+        if (execSelect(_selectParams).isNone())
+        {
+            while (_selectParams.next())
+                params[_selectParams.value(0).toString().toStdString()][_selectParams.value(1).toString().toStdString()] = _selectParams.value(2).toLongLong();
+        }
+        _selectParams.finish();
+        return params;
+    }
+
+    QSqlQuery _insertOne;
+    QSqlQuery _insertBatch;
+    QSqlQuery _selectDevice;
+    QSqlQuery _selectParams;
+    std::vector<Row> _rows;
+    std::unordered_map<std::string, Device> _devices;
+    std::unordered_map<qlonglong, Params> _firmwares;
 };
 
 
 }
 }
 }
-}
\ No newline at end of file
+}
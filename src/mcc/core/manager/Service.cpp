@@ -2,17 +2,21 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <cstdlib>
+#include <QDebug>
 #include "mcc/Names.h"
 #include "mcc/core/manager/Service.h"
 #include "mcc/core/db/Service.h"
 #include "mcc/core/tm/Service.h"
 #include "mcc/core/router/Service.h"
 #include "mcc/core/cmd/Service.h"
+#include "mcc/core/replay/Service.h"
 #include "mcc/encoder/internal/Service.h"
 #include "mcc/encoder/mavlink/Service.h"
 #include "mcc/encoder/photon/Service.h"
 #include "mcc/modeling/SimpleModel.h"
 #include "mcc/messages/System.h"
+#include "mcc/messages/Trace.h"
 
 
 namespace mcc {
@@ -21,6 +25,16 @@ namespace manager {
 
 Service::Service(const mcc::messages::LocalRouterPtr& router) : mcc::messages::ServiceAbstract(mcc::Names::coreManager(), router)
 {
+    handle<mcc::messages::SystemState_Request>();
+    handle<mcc::messages::SystemComponentState>();
+    handle<mcc::messages::SystemComponentTrace>();
+    handle<mcc::messages::SystemQueueStats>();
+
+    //при сборке с MCC_ENABLE_TRACING таблица задержек всех сервисов процесса
+    //перезаписывается в этот файл при каждом отчёте
+    if (const char* path = std::getenv("MCC_TRACE_FILE"))
+        _traceFile = path;
+
     _needed.insert(mcc::Names::coreDb());
     _needed.insert(mcc::Names::coreCmd());
     _needed.insert(mcc::Names::coreTm());
@@ -31,12 +45,25 @@ Service::~Service()
     finish(true);
 }
 
-std::unique_ptr<mcc::messages::ServiceAbstract> Service::startService(const std::string& name, const mcc::messages::LocalRouterPtr& router)
+template<typename T>
+static std::unique_ptr<mcc::messages::ServiceAbstract> startCoreService(const mcc::messages::LocalRouterPtr& router, mcc::misc::Executor* executor)
+{
+    if (executor)
+        return mcc::misc::Runnable::startInExecutor<T>(executor, router);
+    return mcc::misc::Runnable::startInThread<T>(router);
+}
+
+std::unique_ptr<mcc::messages::ServiceAbstract> Service::startService(const std::string& name, const mcc::messages::LocalRouterPtr& router, mcc::misc::Executor* executor)
 {
-    if (name == mcc::Names::coreRouter())   return mcc::misc::Runnable::startInThread<mcc::core::router::Service>(router);
+    //сервисы ядра только обрабатывают сообщения и могут работать в общем пуле потоков,
+    //кодировщики и модели блокируются на вводе-выводе и получают собственный поток.
+    //db тоже: чтение sqlite и архива и fsync заняли бы поток пула надолго
+    if (name == mcc::Names::coreRouter())   return startCoreService<mcc::core::router::Service>(router, executor);
     if (name == mcc::Names::coreDb())       return mcc::misc::Runnable::startInThread<mcc::core::db::Service>(router);
-    if (name == mcc::Names::coreCmd())      return mcc::misc::Runnable::startInThread<mcc::core::cmd::Service>(router);
-    if (name == mcc::Names::coreTm())       return mcc::misc::Runnable::startInThread<mcc::core::tm::Service>(router);
+    if (name == mcc::Names::coreCmd())      return startCoreService<mcc::core::cmd::Service>(router, executor);
+    if (name == mcc::Names::coreTm())       return startCoreService<mcc::core::tm::Service>(router, executor);
+    //воспроизведение без пауз занимает поток целиком
+    if (name == mcc::Names::coreReplay())   return mcc::misc::Runnable::startInThread<mcc::core::replay::Service>(router);
 
     if (name == mcc::Names::encoderInternal())      return mcc::misc::Runnable::startInThread<mcc::encoder::internal::Service>(router);
     if (name == mcc::Names::encoderMavlink())       return mcc::misc::Runnable::startInThread<mcc::encoder::mavlink::Service>(router);
@@ -61,11 +88,12 @@ bool Service::pre()
 //         _services.push_back(startService(i, _router));
 //     }
 
-    _core.push_back(startService(mcc::Names::coreRouter(), _router));
-    _core.push_back(startService(mcc::Names::coreTm(), _router));
-    _core.push_back(startService(mcc::Names::coreDb(), _router));
-    _core.push_back(startService(mcc::Names::coreCmd(), _router));
+    _core.push_back(startService(mcc::Names::coreRouter(), _router, &_executor));
+    _core.push_back(startService(mcc::Names::coreTm(), _router, &_executor));
+    _core.push_back(startService(mcc::Names::coreDb(), _router, &_executor));
+    _core.push_back(startService(mcc::Names::coreCmd(), _router, &_executor));
 
+    _services.push_back(startService(mcc::Names::coreReplay(), _router));
     _services.push_back(startService(mcc::Names::encoderInternal(), _router));
     _services.push_back(startService(mcc::Names::encoderMavlink(), _router));
     _services.push_back(startService(mcc::Names::encoderPhoton(), _router));
@@ -151,6 +179,28 @@ bool Service::isAllNeededStarted() const
     return true;
 }
 
+void Service::printQueues_(const mcc::messages::StatQueues& queues)
+{
+    //печатаем только очереди, которые заполнены или теряли сообщения с прошлого отчёта
+    for (const auto& i : queues)
+    {
+        auto& last = _queues[i._name];
+        bool isChanged = i._dropped != last._dropped || i._coalesced != last._coalesced || i._overflowed != last._overflowed || i._rejected != last._rejected;
+        if (isChanged || i._size > i._capacity / 2)
+        {
+            qDebug() << "queue" << QString::fromStdString(i._name) << i._size << "/" << i._capacity
+                     << "dropped" << i._dropped << "coalesced" << i._coalesced
+                     << "blocked" << i._blocked << "overflowed" << i._overflowed << "rejected" << i._rejected;
+        }
+        last = i;
+    }
+}
+
+void Service::process(std::unique_ptr<mcc::messages::SystemQueueStats>&& stats)
+{
+    printQueues_(stats->queues());
+}
+
 void Service::process(std::unique_ptr<mcc::messages::SystemComponentState>&& state)
 {
     if (state->isStarted())
@@ -171,6 +221,21 @@ void Service::process(std::unique_ptr<mcc::messages::SystemComponentState>&& sta
     }
 }
 
+void Service::process(std::unique_ptr<mcc::messages::SystemComponentTrace>&& message)
+{
+    const auto& trace = message->trace();
+    qDebug() << "trace" << QString::fromStdString(trace._name)
+             << "wait p50" << trace._wait._p50 / 1000 << "p99" << trace._wait._p99 / 1000 << "max" << trace._wait._max / 1000
+             << "handle p50" << trace._handle._p50 / 1000 << "p99" << trace._handle._p99 / 1000 << "max" << trace._handle._max / 1000 << "us";
+    //таблица общая для всех сервисов процесса, хватает одной записи за период отчётов
+    auto now = mcc::misc::currentTimestamp();
+    if (_traceFile.empty() || now - _traceDumped < mcc::messages::Tracer::reportPeriod)
+        return;
+    _traceDumped = now;
+    if (!mcc::messages::Tracer::dump(_traceFile))
+        qDebug() << "can't write trace to" << QString::fromStdString(_traceFile);
+}
+
 void Service::process(std::unique_ptr<mcc::messages::SystemState_Request>&& request)
 {
     _out->send<mcc::messages::SystemState>(*request, isAllNeededStarted());
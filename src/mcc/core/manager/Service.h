@@ -7,8 +7,11 @@
 #include <memory>
 #include <string>
 #include <set>
+#include <map>
 
+#include "mcc/misc/Executor.h"
 #include "mcc/messages/ServiceAbstract.h"
+#include "mcc/messages/Stats.h"
 
 namespace mcc {
 namespace core {
@@ -19,7 +22,7 @@ class Service : public mcc::messages::ServiceAbstract
 public:
     Service(const mcc::messages::LocalRouterPtr& router);
     virtual ~Service();
-    static std::unique_ptr<mcc::messages::ServiceAbstract> startService(const std::string& name, const mcc::messages::LocalRouterPtr& router);
+    static std::unique_ptr<mcc::messages::ServiceAbstract> startService(const std::string& name, const mcc::messages::LocalRouterPtr& router, mcc::misc::Executor* executor = nullptr);
 
 protected:
     bool pre() override;
@@ -28,14 +31,21 @@ protected:
 private:
     void process(std::unique_ptr<mcc::messages::SystemState_Request>&& message) override;
     void process(std::unique_ptr<mcc::messages::SystemComponentState>&& message) override;
+    void process(std::unique_ptr<mcc::messages::SystemComponentTrace>&& message) override;
+    void process(std::unique_ptr<mcc::messages::SystemQueueStats>&& message) override;
 
 private:
     bool isAllNeededStarted() const;
+    void printQueues_(const mcc::messages::StatQueues& queues);
 
     std::string _routerAddress;
     std::set<std::string> _started;
     std::set<std::string> _needed;
+    std::map<std::string, mcc::messages::StatQueue> _queues;
+    std::string _traceFile;
+    mcc::misc::Timestamp _traceDumped = 0;
 
+    mcc::misc::Executor _executor;
     std::vector<std::unique_ptr<mcc::messages::ServiceAbstract>> _core;
     std::vector<std::unique_ptr<mcc::messages::ServiceAbstract>> _services;
 };
@@ -0,0 +1,100 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+
+#include "mcc/core/replay/ArchiveReader.h"
+
+
+namespace mcc {
+namespace core {
+namespace replay {
+
+using mcc::misc::Timestamp;
+
+const Timestamp ArchiveReader::defaultWindow;
+
+ArchiveReader::ArchiveReader(const mcc::core::db::TmArchive* archive, const std::vector<std::string>& devices, Timestamp from, Timestamp to, Timestamp window)
+    : _archive(archive), _devices(devices), _position(from), _to(to), _window(std::max<Timestamp>(window, 1)), _isDone(true), _current(0)
+{
+    if (_devices.empty())
+        _devices = _archive->devices();
+
+    bool hasPoints = false;
+    Timestamp first = 0;
+    Timestamp last = 0;
+    for (std::size_t i = 0; i < _devices.size(); i++)
+    {
+        Timestamp deviceFirst;
+        Timestamp deviceLast;
+        if (!_archive->timeRange(_devices[i], &deviceFirst, &deviceLast))
+            continue;
+        first = hasPoints ? std::min(first, deviceFirst) : deviceFirst;
+        last = hasPoints ? std::max(last, deviceLast) : deviceLast;
+        hasPoints = true;
+        for (const auto& name : _archive->params(_devices[i]))
+            _series.push_back(Series{i, name});
+    }
+
+    //иначе окна шли бы от from = 0 до первой записанной точки
+    _position = std::max(_position, first);
+    _to = std::min(_to, last);
+    _isDone = !hasPoints || _position > _to;
+}
+
+bool ArchiveReader::next(Frame* frame)
+{
+    while (_current == _frames.size())
+    {
+        if (!load_())
+            return false;
+    }
+    *frame = std::move(_frames[_current++]);
+    return true;
+}
+
+bool ArchiveReader::load_()
+{
+    if (_isDone)
+        return false;
+    _frames.clear();
+    _current = 0;
+
+    Timestamp end = _to - _position < _window ? _to : _position + _window - 1;
+    _points.clear();
+    for (std::size_t i = 0; i < _series.size(); i++)
+    {
+        const Series& series = _series[i];
+        _archive->scan(_devices[series.device], series.name.trait, series.name.status, _position, end,
+                       [this, &series, i](Timestamp time, const mcc::misc::NetVariant& value)
+        {
+            _points.push_back(Point{time, series.device, i, value});
+        });
+    }
+    if (end == _to)
+        _isDone = true;
+    else
+        _position = end + 1;
+
+    //внутри кадра параметры остаются в порядке рядов
+    std::stable_sort(_points.begin(), _points.end(), [](const Point& left, const Point& right)
+    {
+        return left.time < right.time || (left.time == right.time && left.device < right.device);
+    });
+    for (const Point& point : _points)
+    {
+        if (_frames.empty() || _frames.back().time != point.time || _frames.back().device != _devices[point.device])
+        {
+            _frames.emplace_back();
+            _frames.back().time = point.time;
+            _frames.back().device = _devices[point.device];
+        }
+        const auto& name = _series[point.series].name;
+        _frames.back().params.emplace_back(name.trait, name.status, point.value);
+    }
+    return true;
+}
+}
+}
+}
@@ -0,0 +1,71 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mcc/misc/TimeUtils.h"
+#include "mcc/messages/Tm.h"
+#include "mcc/core/db/TmArchive.h"
+
+
+namespace mcc {
+namespace core {
+namespace replay {
+
+struct Frame
+{
+    mcc::misc::Timestamp time;
+    std::string device;
+    mcc::messages::TmParams params;
+};
+
+//Кадры архива телеметрии по возрастанию времени: значения устройства с одним временем
+//собираются в один кадр, как их прислал кодировщик. Архив читается окнами по window
+//времени записи, в памяти держатся только кадры текущего окна
+class ArchiveReader
+{
+public:
+    static const mcc::misc::Timestamp defaultWindow = 1000ll * 1000 * 1000;
+
+    //пустой devices - все устройства архива; from и to сужаются до времени записанных точек
+    ArchiveReader(const mcc::core::db::TmArchive* archive, const std::vector<std::string>& devices,
+                  mcc::misc::Timestamp from, mcc::misc::Timestamp to, mcc::misc::Timestamp window = defaultWindow);
+
+    //false - кадров больше нет
+    bool next(Frame* frame);
+
+private:
+    struct Series
+    {
+        std::size_t device;
+        mcc::messages::TmParamName name;
+    };
+
+    struct Point
+    {
+        mcc::misc::Timestamp time;
+        std::size_t device;
+        std::size_t series;
+        mcc::misc::NetVariant value;
+    };
+
+    bool load_();
+
+    const mcc::core::db::TmArchive* _archive;
+    std::vector<std::string> _devices;
+    std::vector<Series> _series;
+    mcc::misc::Timestamp _position;
+    mcc::misc::Timestamp _to;
+    mcc::misc::Timestamp _window;
+    bool _isDone;
+    std::vector<Point> _points;
+    std::vector<Frame> _frames;
+    std::size_t _current;
+};
+}
+}
+}
@@ -0,0 +1,44 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include "mcc/misc/TimeUtils.h"
+
+
+namespace mcc {
+namespace core {
+namespace replay {
+
+//Переводит время записи во время воспроизведения: промежутки от первого кадра делятся на speed,
+//speed <= 0 - все кадры сразу. Отстающий получатель не сдвигает расписание, опоздавшие кадры
+//отдаются подряд, пока воспроизведение не догонит часы
+class ReplayClock
+{
+public:
+    explicit ReplayClock(double speed = 1) : _speed(speed), _recorded(0), _started(0) {}
+
+    void start(mcc::misc::Timestamp recorded, mcc::misc::Timestamp now)
+    {
+        _recorded = recorded;
+        _started = now;
+    }
+
+    //когда отдавать кадр, записанный в recorded
+    mcc::misc::Timestamp due(mcc::misc::Timestamp recorded) const
+    {
+        if (_speed <= 0)
+            return _started;
+        return _started + (mcc::misc::Timestamp)((recorded - _recorded) / _speed);
+    }
+
+    double speed() const { return _speed; }
+
+private:
+    double _speed;
+    mcc::misc::Timestamp _recorded;
+    mcc::misc::Timestamp _started;
+};
+}
+}
+}
@@ -0,0 +1,123 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+
+#include "mcc/Names.h"
+#include "mcc/misc/TimeUtils.h"
+#include "mcc/messages/Tm.h"
+#include "mcc/messages/MessageSender.h"
+#include "mcc/core/replay/Service.h"
+
+
+namespace mcc {
+namespace core {
+namespace replay {
+
+using mcc::misc::Timestamp;
+
+//кадров за один tick(), чтобы и без пауз между кадрами успевать принять запрос остановки
+static const std::size_t framesPerTick = 256;
+static const Timestamp idleWait = 100ll * 1000 * 1000;
+
+Service::Service(const mcc::messages::LocalRouterPtr& router)
+    : mcc::messages::ServiceAbstract(mcc::Names::coreReplay(), router)
+    , _hasFrame(false)
+    , _frames(0)
+    , _points(0)
+    , _started(0)
+{
+    handle<mcc::messages::TmReplay_Request>();
+}
+
+Service::~Service()
+{
+    finish(true);
+}
+
+void Service::tick()
+{
+    ServiceAbstract::tick();
+    play_();
+    schedule_();
+}
+
+void Service::post()
+{
+    if (_request)
+        finish_("replay service stopped");
+    ServiceAbstract::post();
+}
+
+void Service::schedule_()
+{
+    Timestamp wait = idleWait;
+    if (_hasFrame)
+        wait = std::max<Timestamp>(_clock.due(_frame.time) - mcc::misc::currentTimestamp(), 0);
+    _recvTimeout = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(std::min(wait, idleWait)));
+
+    if (!_hasFrame || !isCooperative_())
+        return;
+    if (wait == 0)
+        wakeup_();
+    else
+        wakeupAfter_(std::chrono::duration_cast<mcc::misc::Executor::Clock::duration>(std::chrono::nanoseconds(wait)));
+}
+
+void Service::play_()
+{
+    Timestamp now = mcc::misc::currentTimestamp();
+    for (std::size_t i = 0; _hasFrame && i < framesPerTick; i++)
+    {
+        if (_clock.due(_frame.time) > now)
+            return;
+        _frames++;
+        _points += _frame.params.size();
+        _out->send<mcc::messages::TmParamList>(_frame.device, std::move(_frame.params), _frame.time);
+        _hasFrame = _reader->next(&_frame);
+    }
+    if (_request && !_hasFrame)
+        finish_(std::string());
+}
+
+void Service::finish_(const std::string& error)
+{
+    _out->respond<mcc::messages::TmReplay_Response>(_request.get(), _frames, _points, mcc::misc::currentTimestamp() - _started, error);
+    _request.reset();
+    _reader.reset();
+    _archive.close();
+    _hasFrame = false;
+}
+
+void Service::process(std::unique_ptr<mcc::messages::TmReplay_Request>&& request)
+{
+    if (_request)
+        finish_("interrupted by another replay request");
+    if (request->path().empty())
+    {
+        _out->respond<mcc::messages::TmReplay_Response>(request.get(), 0, 0, 0);
+        return;
+    }
+
+    mcc::core::db::TmArchive::Options options;
+    options.isReadOnly = true;
+    if (!_archive.open(request->path(), options))
+    {
+        _out->respond<mcc::messages::TmReplay_Response>(request.get(), 0, 0, 0, "cant open tm archive " + request->path());
+        return;
+    }
+
+    _request = std::move(request);
+    _reader.reset(new ArchiveReader(&_archive, _request->devices(), _request->from(), _request->to()));
+    _clock = ReplayClock(_request->speed());
+    _frames = 0;
+    _points = 0;
+    _started = mcc::misc::currentTimestamp();
+    _hasFrame = _reader->next(&_frame);
+    if (_hasFrame)
+        _clock.start(_frame.time, _started);
+}
+}
+}
+}
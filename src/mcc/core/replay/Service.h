@@ -0,0 +1,50 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <memory>
+
+#include "mcc/messages/ServiceAbstract.h"
+#include "mcc/core/db/TmArchive.h"
+#include "mcc/core/replay/ArchiveReader.h"
+#include "mcc/core/replay/ReplayClock.h"
+
+
+namespace mcc {
+namespace core {
+namespace replay {
+
+//Воспроизводит записанный архив телеметрии по TmReplay_Request: кадры уходят в core.tm
+//как от кодировщика, поэтому подписчики и интерфейс видят полёт так же, как вживую.
+//Архив открывается только на чтение, им может быть и архив, который сейчас пишет core.db
+class Service : public mcc::messages::ServiceAbstract
+{
+public:
+    Service(const mcc::messages::LocalRouterPtr& router);
+    virtual ~Service();
+
+protected:
+    void tick() override;
+    void post() override;
+
+private:
+    void process(std::unique_ptr<mcc::messages::TmReplay_Request>&&) override;
+    void play_();
+    void schedule_();
+    void finish_(const std::string& error);
+
+    std::unique_ptr<mcc::messages::TmReplay_Request> _request;
+    mcc::core::db::TmArchive _archive;
+    std::unique_ptr<ArchiveReader> _reader;
+    ReplayClock _clock;
+    Frame _frame;
+    bool _hasFrame;
+    std::uint64_t _frames;
+    std::uint64_t _points;
+    mcc::misc::Timestamp _started;
+};
+}
+}
+}
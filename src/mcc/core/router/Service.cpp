@@ -8,6 +8,7 @@
 
 #include "mcc/Names.h"
 #include "mcc/messages/MessageSender.h"
+#include "mcc/messages/System.h"
 #include "mcc/core/router/Service.h"
 
 
@@ -27,60 +28,131 @@ Service::~Service()
 {
 }
 
-void Service::tick()
+bool Service::pre()
+{
+    if (isCooperative_())
+    {
+        _router->_in->setWaker(waker_());
+        wakeupAfter_(std::chrono::seconds(10));
+    }
+    return ServiceAbstract::pre();
+}
+
+void Service::post()
+{
+    if (isCooperative_())
+        _router->_in->setWaker(nullptr);
+    ServiceAbstract::post();
+}
+
+void Service::reportQueues_()
 {
     if (std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - _start).count() >= 10)
     {
-        for (const auto& queue : _router->_queueByName)
+        //у роутера нет своего отправителя, состояние очередей кладём менеджеру напрямую
+        auto to = _router->_destinations.find(mcc::Names::coreManager());
+        if (to != _router->_destinations.end())
         {
-            if (queue.second->size() > 100)
-                qDebug() << QString::fromStdString(queue.first) << queue.second->size();
+            std::unique_ptr<mcc::messages::Message> stats(new mcc::messages::SystemQueueStats(_router->queueStats()));
+            stats->_sender = mcc::misc::NameTable::intern(name());
+            _router->deliver(to->second.get(), std::move(stats));
         }
         _start = std::chrono::steady_clock::now();
+        wakeupAfter_(std::chrono::seconds(10));
     }
+}
 
-    auto m = _router->_in->tryRecvFor(std::chrono::seconds(1));
-    if (m.isErr())
-        return;
+void Service::tick()
+{
+    reportQueues_();
+
+    std::size_t count;
+    if (isCooperative_())
+        count = _router->_in->recvAll(&_batch, _batchSize);
+    else
+        count = _router->_in->recvAllFor(&_batch, _batchSize, std::chrono::seconds(1));
+
+    routeBatch_();
+
+    if (isCooperative_() && count == _batchSize)
+        wakeup_();
+}
+
+// consecutive messages to the same receiver are forwarded with one sendBatch; the run is
+// flushed before anything else is sent so that the order per receiver is kept
+void Service::routeBatch_()
+{
+    mcc::messages::LocalRouter::Destination* target = nullptr;
+    auto flush = [&]()
+    {
+        if (target && !_pending.empty())
+            _router->deliverBatch(target, &_pending);
+        target = nullptr;
+    };
 
-    routeMessage_(m.take());
+    for (auto& message : _batch)
+    {
+        auto to = _router->destination(message->receiverId());
+        if (!to)
+        {
+            flush();
+            routeMessage_(std::move(message));
+            continue;
+        }
+        if (to != target)
+        {
+            flush();
+            target = to;
+        }
+        _pending.push_back(std::move(message));
+    }
+    flush();
+    _batch.clear();
 }
 
-void Service::sendMulticast(const std::string& from, mcc::messages::MessagePtr&& message)
+void Service::sendMulticast(mcc::misc::NameId from, mcc::messages::MessagePtr&& message)
 {
-    for (const auto& j : _router->_queueByName)
+    //копии делят общее неизменяемое содержимое сообщения, последнему получателю уходит оригинал
+    mcc::messages::LocalRouter::Destination* last = nullptr;
+    for (const auto& j : _router->_destinations)
     {
-        if (j.first == from)
+        if (j.second->id == from)
             continue;
-        auto clone = message->clone();
-        clone->_receiver = j.first;
-        j.second->send(std::move(clone));
+        if (last)
+        {
+            auto clone = message->clone();
+            clone->_receiver = last->id;
+            _router->deliver(last, std::move(clone));
+        }
+        last = j.second.get();
+    }
+    if (last)
+    {
+        message->_receiver = last->id;
+        _router->deliver(last, std::move(message));
     }
 }
 
 void Service::routeMessage_(std::unique_ptr<mcc::messages::Message>&& message)
 {
-    const std::string& receiver = message->receiver();
-    const std::string& sender = message->sender();
-
     if (message->receiver() == mcc::Names::multicast())
     {
-        sendMulticast(sender, std::move(message));
+        sendMulticast(message->senderId(), std::move(message));
         return;
     }
 
-    auto to = _router->_queueByName.find(receiver);
-    if (to == _router->_queueByName.end())
+    auto to = _router->destination(message->receiverId());
+    if (!to)
     {
-        if (sender != name())
+        auto from = _router->destination(message->senderId());
+        if (message->sender() != name() && from)
         {
-            auto& queue = _router->_queueByName[sender];
-            queue->send(std::unique_ptr<mcc::messages::Message>(new mcc::messages::Error(message.get(), "destination unknown: " + receiver)));
+            _router->deliver(from, std::unique_ptr<mcc::messages::Message>(new mcc::messages::Error(message.get(), "destination unknown: " + message->receiver())));
         }
         return;
     }
 
-    to->second->send(std::move(message));
+    _router->deliver(to, std::move(message));
 }
 
 }
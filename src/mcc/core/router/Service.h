@@ -5,6 +5,7 @@
 #pragma once
 #include <map>
 #include <string>
+#include <vector>
 
 #include "mcc/Names.h"
 #include "mcc/Settings.h"
@@ -25,13 +26,18 @@ public:
     virtual ~Service();
 
 protected:
+    bool pre() override;
     void tick() override;
+    void post() override;
 
 private:
+    void routeBatch_();
     void routeMessage_(std::unique_ptr<mcc::messages::Message>&&);
-    void sendMulticast(const std::string& from, mcc::messages::MessagePtr&& message);
+    void sendMulticast(mcc::misc::NameId from, mcc::messages::MessagePtr&& message);
+    void reportQueues_();
 
     std::chrono::steady_clock::time_point _start;
+    std::vector<mcc::messages::MessagePtr> _pending;
 };
 }
 }
@@ -2,7 +2,10 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <algorithm>
+
 #include "mcc/Names.h"
+#include "mcc/misc/TimeUtils.h"
 #include "mcc/messages/Tm.h"
 #include "mcc/messages/MessageSender.h"
 #include "mcc/core/tm/Service.h"
@@ -14,6 +17,9 @@ namespace tm {
 
 Service::Service(const mcc::messages::LocalRouterPtr& router) : mcc::messages::ServiceAbstract(mcc::Names::coreTm(), router)
 {
+    handle<mcc::messages::TmParamSubscribe_Request>();
+    handle<mcc::messages::TmParamList>();
+    handle<mcc::messages::TmSnapshot_Request>();
 }
 
 Service::~Service()
@@ -21,18 +27,96 @@ Service::~Service()
     finish(true);
 }
 
+void Service::tick()
+{
+    ServiceAbstract::tick();
+
+    //значения, придержанные подписками с ограниченной частотой
+    _subscriptions.flush(mcc::misc::currentTimestamp(), &_deliveries);
+    deliver_(nullptr);
+    scheduleFlush_();
+}
+
+void Service::scheduleFlush_()
+{
+    //без пула потоков tick() и так вызывается не реже раза в 100 мс
+    auto next = _subscriptions.nextFlush();
+    if (next == 0 || !isCooperative_())
+        return;
+    auto delay = std::max<mcc::misc::Timestamp>(next - mcc::misc::currentTimestamp(), 0);
+    wakeupAfter_(std::chrono::duration_cast<mcc::misc::Executor::Clock::duration>(std::chrono::nanoseconds(delay)));
+}
+
+void Service::deliver_(const mcc::messages::TmParamList* original)
+{
+    for (const auto& i : _deliveries)
+    {
+        if (original && i.params == original->sharedParams())
+            _out->sendTo(i.subscriber, original->clone());
+        else if (original)
+            _out->sendTo(i.subscriber, original->cloneWith(i.params));
+        else
+            _out->sendTo(i.subscriber, mcc::misc::makeUnique<mcc::messages::TmParamList>(i.device, i.params));
+    }
+}
+
 void Service::process(std::unique_ptr<mcc::messages::TmParamSubscribe_Request>&& request)
 {
-    _paramSubscribers.insert(request->sender());
+    if (request->isOn())
+    {
+        const mcc::misc::Timestamp msec = 1000 * 1000;
+        _subscriptions.add(request->senderId(), request->device(), request->trait(), request->status(), request->periodMs() * msec);
+        _out->respond<mcc::messages::TmParamSubscribe_Response>(request.get());
+        sendCached_(request->senderId(), *request);
+        return;
+    }
+
+    if (_subscriptions.remove(request->senderId(), request->device(), request->trait(), request->status()))
+        _out->respond<mcc::messages::TmParamSubscribe_Response>(request.get());
+    else
+        _out->respond<mcc::messages::TmParamSubscribe_Response>(request.get(), "not subscribed");
 }
 
-void Service::process(std::unique_ptr<mcc::messages::TmParamList>&& message)
+void Service::sendCached_(mcc::misc::NameId subscriber, const mcc::messages::TmParamSubscribe_Request& request)
 {
-    for (const auto& i : _paramSubscribers)
+    //новый подписчик сразу получает последние известные значения, не дожидаясь следующего кадра
+    mcc::messages::TmParamStates states;
+    _cache.snapshot(request.device(), request.trait(), request.status(), &states);
+    auto i = states.begin();
+    while (i != states.end())
     {
-        _out->sendTo(i, message->clone());
+        const std::string& device = i->device();
+        mcc::messages::TmParams params;
+        for (; i != states.end() && i->device() == device; ++i)
+            params.push_back(i->param());
+        _out->sendTo(subscriber, mcc::misc::makeUnique<mcc::messages::TmParamList>(device, std::move(params)));
     }
-    _out->sendTo(mcc::Names::coreDb(), std::move(message));
+}
+
+void Service::process(std::unique_ptr<mcc::messages::TmSnapshot_Request>&& request)
+{
+    mcc::messages::TmParamStates states;
+    if (request->since() == 0)
+        _cache.snapshot(request->device(), request->trait(), request->status(), &states);
+    else
+        _cache.changedSince(request->since(), request->device(), request->trait(), request->status(), &states);
+    _out->respond<mcc::messages::TmSnapshot_Response>(request.get(), std::move(states), _cache.sequence());
+}
+
+void Service::process(std::unique_ptr<mcc::messages::TmParamList>&& message)
+{
+    //кэш - текущее состояние устройств, воспроизведённые из архива значения в нём выдавались бы
+    //снимкам и новым подписчикам за текущие
+    if (!message->isReplay())
+        _cache.update(message->device(), message->params(), message->sampleTime());
+
+    //подписчики на всё устройство получают копию, разделяющую параметры с исходным сообщением,
+    //остальные - только запрошенные параметры, а с ограниченной частотой - только те, чей период истёк
+    _subscriptions.route(message->device(), message->sharedParams(), mcc::misc::currentTimestamp(), &_deliveries);
+    deliver_(message.get());
+    //база данных получает всё без прореживания, кроме воспроизведённого из архива - оно там уже есть
+    if (!message->isReplay())
+        _out->sendTo(mcc::Names::coreDb(), std::move(message));
 }
 
 }
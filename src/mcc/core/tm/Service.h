@@ -3,11 +3,11 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #pragma once
-#include <set>
-#include <string>
-#include <unordered_map>
+#include <vector>
 
 #include "mcc/messages/ServiceAbstract.h"
+#include "mcc/core/tm/StateCache.h"
+#include "mcc/core/tm/Subscriptions.h"
 
 
 namespace mcc {
@@ -20,13 +20,21 @@ public:
     Service(const mcc::messages::LocalRouterPtr& router);
     virtual ~Service();
 
+protected:
+    void tick() override;
+
 private:
     void process(std::unique_ptr<mcc::messages::TmParamSubscribe_Request>&&);
     void process(std::unique_ptr<mcc::messages::TmParamList>&&);
+    void process(std::unique_ptr<mcc::messages::TmSnapshot_Request>&&);
+    void sendCached_(mcc::misc::NameId subscriber, const mcc::messages::TmParamSubscribe_Request& request);
+    void deliver_(const mcc::messages::TmParamList* original);
+    void scheduleFlush_();
 
 private:
-    std::unordered_map<std::string, std::string> _paramToClients;
-    std::set<std::string> _paramSubscribers;
+    Subscriptions _subscriptions;
+    StateCache _cache;
+    std::vector<Subscriptions::Delivery> _deliveries;
 };
 }
 }
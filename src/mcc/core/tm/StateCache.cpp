@@ -0,0 +1,139 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+
+#include "mcc/core/tm/StateCache.h"
+
+
+namespace mcc {
+namespace core {
+namespace tm {
+
+const std::uint32_t StateCache::none;
+
+std::uint32_t StateCache::entry_(Device* device, const std::string& deviceName, const mcc::messages::TmParam& param)
+{
+    auto& statuses = device->traits[param.trait()];
+    auto i = statuses.find(param.status());
+    if (i != statuses.end())
+        return i->second;
+
+    std::uint32_t index = (std::uint32_t)_entries.size();
+    _entries.push_back(Entry{mcc::misc::NetVariant(), 0, 0, 0, none, none});
+    _keys.push_back(Key{deviceName, param.trait(), param.status()});
+    statuses.emplace(param.status(), index);
+    device->entries.push_back(index);
+    return index;
+}
+
+void StateCache::touch_(std::uint32_t index)
+{
+    Entry& e = _entries[index];
+    e.sequence = ++_sequence;
+    if (_newest == index)
+        return;
+
+    //вынимаем из списка, если уже там
+    if (e.older != none)
+        _entries[e.older].newer = e.newer;
+    if (e.newer != none)
+        _entries[e.newer].older = e.older;
+    if (_oldest == index)
+        _oldest = e.newer;
+
+    e.older = _newest;
+    e.newer = none;
+    if (_newest != none)
+        _entries[_newest].newer = index;
+    _newest = index;
+    if (_oldest == none)
+        _oldest = index;
+}
+
+void StateCache::update(const std::string& device, const mcc::messages::TmParams& params, mcc::misc::Timestamp time)
+{
+    Device& d = _devices[device];
+    for (const auto& i : params)
+    {
+        std::uint32_t index = entry_(&d, device, i);
+        Entry& e = _entries[index];
+        //запоздавший кадр не затирает более новое значение
+        if (e.updates != 0 && time < e.time)
+            continue;
+        e.value = i.value();
+        e.time = time;
+        ++e.updates;
+        touch_(index);
+    }
+}
+
+void StateCache::append_(std::uint32_t index, mcc::messages::TmParamStates* out) const
+{
+    const Entry& e = _entries[index];
+    const Key& k = _keys[index];
+    out->emplace_back(k.device, mcc::messages::TmParam(k.trait, k.status, e.value), e.time, e.updates);
+}
+
+bool StateCache::matches_(std::uint32_t index, const std::string& device, const std::string& trait, const std::string& status) const
+{
+    const Key& k = _keys[index];
+    return (device.empty() || k.device == device)
+        && (trait.empty() || k.trait == trait)
+        && (status.empty() || k.status == status);
+}
+
+void StateCache::snapshotDevice_(const Device& device, const std::string& trait, const std::string& status, mcc::messages::TmParamStates* out) const
+{
+    if (trait.empty())
+    {
+        for (auto index : device.entries)
+        {
+            if (status.empty() || _keys[index].status == status)
+                append_(index, out);
+        }
+        return;
+    }
+
+    auto t = device.traits.find(trait);
+    if (t == device.traits.end())
+        return;
+    if (status.empty())
+    {
+        for (const auto& i : t->second)
+            append_(i.second, out);
+        return;
+    }
+    auto s = t->second.find(status);
+    if (s != t->second.end())
+        append_(s->second, out);
+}
+
+void StateCache::snapshot(const std::string& device, const std::string& trait, const std::string& status, mcc::messages::TmParamStates* out) const
+{
+    if (device.empty())
+    {
+        for (const auto& i : _devices)
+            snapshotDevice_(i.second, trait, status, out);
+        return;
+    }
+    auto d = _devices.find(device);
+    if (d != _devices.end())
+        snapshotDevice_(d->second, trait, status, out);
+}
+
+void StateCache::changedSince(Sequence since, const std::string& device, const std::string& trait, const std::string& status, mcc::messages::TmParamStates* out) const
+{
+    //идём от самых свежих, пока не дойдём до уже виденных
+    std::size_t first = out->size();
+    for (std::uint32_t i = _newest; i != none && _entries[i].sequence > since; i = _entries[i].older)
+    {
+        if (matches_(i, device, trait, status))
+            append_(i, out);
+    }
+    std::reverse(out->begin() + first, out->end());
+}
+}
+}
+}
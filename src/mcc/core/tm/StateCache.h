@@ -0,0 +1,81 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mcc/misc/TimeUtils.h"
+#include "mcc/messages/Tm.h"
+
+
+namespace mcc {
+namespace core {
+namespace tm {
+
+//Последние значения телеметрии по (устройство, признак, статус).
+//Значения лежат в одном векторе и связаны в список по порядку изменения, так что
+//снимок k параметров и выборка изменений после since стоят O(k), а не O(всех параметров).
+class StateCache
+{
+public:
+    typedef std::uint64_t Sequence;
+
+    //значения старше уже известных (time меньше) пропускаются
+    void update(const std::string& device, const mcc::messages::TmParams& params, mcc::misc::Timestamp time);
+    //номер последнего изменения, 0 - ничего не было
+    Sequence sequence() const { return _sequence; }
+    std::size_t size() const { return _entries.size(); }
+
+    //текущие значения, пустые device/trait/status - все; значения одного устройства идут подряд
+    void snapshot(const std::string& device, const std::string& trait, const std::string& status, mcc::messages::TmParamStates* out) const;
+    //изменившиеся после since, от старых к новым
+    void changedSince(Sequence since, const std::string& device, const std::string& trait, const std::string& status, mcc::messages::TmParamStates* out) const;
+
+private:
+    static const std::uint32_t none = 0xffffffff;
+
+    struct Entry
+    {
+        mcc::misc::NetVariant value;
+        mcc::misc::Timestamp time;
+        std::uint64_t updates;
+        Sequence sequence;
+        //соседи в списке по порядку изменения
+        std::uint32_t older;
+        std::uint32_t newer;
+    };
+
+    //имена нужны только при выдаче, держим их отдельно от часто меняющихся значений
+    struct Key
+    {
+        std::string device;
+        std::string trait;
+        std::string status;
+    };
+
+    struct Device
+    {
+        std::vector<std::uint32_t> entries;
+        std::unordered_map<std::string, std::unordered_map<std::string, std::uint32_t>> traits;
+    };
+
+    std::uint32_t entry_(Device* device, const std::string& deviceName, const mcc::messages::TmParam& param);
+    void touch_(std::uint32_t index);
+    void append_(std::uint32_t index, mcc::messages::TmParamStates* out) const;
+    bool matches_(std::uint32_t index, const std::string& device, const std::string& trait, const std::string& status) const;
+    void snapshotDevice_(const Device& device, const std::string& trait, const std::string& status, mcc::messages::TmParamStates* out) const;
+
+    std::vector<Entry> _entries;
+    std::vector<Key> _keys;
+    std::unordered_map<std::string, Device> _devices;
+    std::uint32_t _oldest = none;
+    std::uint32_t _newest = none;
+    Sequence _sequence = 0;
+};
+}
+}
+}
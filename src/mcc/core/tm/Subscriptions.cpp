@@ -0,0 +1,283 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+
+#include "mcc/core/tm/Subscriptions.h"
+
+
+namespace mcc {
+namespace core {
+namespace tm {
+
+bool Subscriptions::insert_(Subscribers* subscribers, mcc::misc::NameId subscriber, mcc::misc::Timestamp period)
+{
+    auto i = std::lower_bound(subscribers->begin(), subscribers->end(), subscriber, [](const Subscriber& s, mcc::misc::NameId id) { return s.id < id; });
+    if (i != subscribers->end() && i->id == subscriber)
+    {
+        i->period = period;
+        return false;
+    }
+    subscribers->insert(i, Subscriber{subscriber, period});
+    return true;
+}
+
+bool Subscriptions::erase_(Subscribers* subscribers, mcc::misc::NameId subscriber)
+{
+    auto i = std::lower_bound(subscribers->begin(), subscribers->end(), subscriber, [](const Subscriber& s, mcc::misc::NameId id) { return s.id < id; });
+    if (i == subscribers->end() || i->id != subscriber)
+        return false;
+    subscribers->erase(i);
+    return true;
+}
+
+bool Subscriptions::add(mcc::misc::NameId subscriber, const std::string& device, const std::string& trait, const std::string& status, mcc::misc::Timestamp period)
+{
+    Device& d = _devices[device];
+    if (trait.empty())
+        return insert_(&d.all, subscriber, period);
+
+    Trait& t = d.traits[trait];
+    if (status.empty())
+        return insert_(&t.all, subscriber, period);
+
+    return insert_(&t.statuses[status], subscriber, period);
+}
+
+bool Subscriptions::remove(mcc::misc::NameId subscriber, const std::string& device, const std::string& trait, const std::string& status)
+{
+    //недосланные значения снятой подписки больше не нужны
+    for (auto i = _throttles.lower_bound(std::make_pair(subscriber, std::string())); i != _throttles.end() && i->first.first == subscriber;)
+    {
+        if (!device.empty() && i->first.second != device)
+        {
+            ++i;
+            continue;
+        }
+        if (trait.empty())
+            i->second.clear();
+        else if (status.empty())
+            i->second.erase(trait);
+        else if (i->second.count(trait))
+            i->second[trait].erase(status);
+
+        if (i->second.empty())
+            i = _throttles.erase(i);
+        else
+            ++i;
+    }
+
+    auto d = _devices.find(device);
+    if (d == _devices.end())
+        return false;
+
+    bool isRemoved = false;
+    if (trait.empty())
+    {
+        isRemoved = erase_(&d->second.all, subscriber);
+    }
+    else
+    {
+        auto t = d->second.traits.find(trait);
+        if (t == d->second.traits.end())
+            return false;
+
+        if (status.empty())
+        {
+            isRemoved = erase_(&t->second.all, subscriber);
+        }
+        else
+        {
+            auto s = t->second.statuses.find(status);
+            if (s == t->second.statuses.end())
+                return false;
+            isRemoved = erase_(&s->second, subscriber);
+            if (s->second.empty())
+                t->second.statuses.erase(s);
+        }
+        if (t->second.all.empty() && t->second.statuses.empty())
+            d->second.traits.erase(t);
+    }
+
+    if (d->second.all.empty() && d->second.traits.empty())
+        _devices.erase(d);
+    return isRemoved;
+}
+
+Subscriptions::Pending* Subscriptions::pending_(mcc::misc::NameId subscriber)
+{
+    //подписчиков на одно устройство обычно единицы, линейный поиск дешевле хеширования
+    for (std::size_t i = 0; i < _pendingCount; ++i)
+    {
+        if (_pending[i].subscriber == subscriber)
+            return &_pending[i];
+    }
+    if (_pendingCount == _pending.size())
+        _pending.emplace_back();
+    Pending* p = &_pending[_pendingCount++];
+    p->subscriber = subscriber;
+    p->isWhole = false;
+    p->matches.clear();
+    return p;
+}
+
+void Subscriptions::collect_(const Subscribers& subscribers, std::size_t index, bool skipUnlimited)
+{
+    for (const auto& i : subscribers)
+    {
+        if (skipUnlimited && i.period == 0)
+            continue;
+        Pending* p = pending_(i.id);
+        if (p->isWhole)
+            continue;
+        //параметр мог совпасть и с подпиской на признак, и с подпиской на статус - действует меньший период
+        if (!p->matches.empty() && p->matches.back().index == index)
+            p->matches.back().period = std::min(p->matches.back().period, i.period);
+        else
+            p->matches.push_back(Match{index, i.period});
+    }
+}
+
+void Subscriptions::schedule_(mcc::misc::Timestamp due)
+{
+    if (_nextFlush == 0 || due < _nextFlush)
+        _nextFlush = due;
+}
+
+void Subscriptions::route(const std::string& device, const mcc::messages::TmParamsPtr& params, mcc::misc::Timestamp now, std::vector<Delivery>* out)
+{
+    out->clear();
+    _pendingCount = 0;
+
+    const Device* devices[2] = {nullptr, nullptr};
+    std::size_t deviceCount = 0;
+    auto d = _devices.find(device);
+    if (d != _devices.end())
+        devices[deviceCount++] = &d->second;
+    if (!device.empty())
+    {
+        d = _devices.find(std::string());
+        if (d != _devices.end())
+            devices[deviceCount++] = &d->second;
+    }
+    if (deviceCount == 0)
+        return;
+
+    for (std::size_t i = 0; i < deviceCount; ++i)
+    {
+        for (const auto& subscriber : devices[i]->all)
+        {
+            if (subscriber.period == 0)
+                pending_(subscriber.id)->isWhole = true;
+        }
+    }
+
+    const mcc::messages::TmParams& list = *params;
+    for (std::size_t i = 0; i < list.size(); ++i)
+    {
+        for (std::size_t j = 0; j < deviceCount; ++j)
+        {
+            collect_(devices[j]->all, i, true);
+            auto t = devices[j]->traits.find(list[i].trait());
+            if (t == devices[j]->traits.end())
+                continue;
+            collect_(t->second.all, i, false);
+            auto s = t->second.statuses.find(list[i].status());
+            if (s != t->second.statuses.end())
+                collect_(s->second, i, false);
+        }
+    }
+
+    std::vector<std::size_t>& indices = _indices;
+    for (std::size_t i = 0; i < _pendingCount; ++i)
+    {
+        const Pending& p = _pending[i];
+        if (p.isWhole)
+        {
+            out->push_back(Delivery{p.subscriber, device, params});
+            continue;
+        }
+
+        indices.clear();
+        Slots* slots = nullptr;
+        for (const auto& match : p.matches)
+        {
+            if (match.period == 0)
+            {
+                indices.push_back(match.index);
+                continue;
+            }
+
+            if (!slots)
+                slots = &_throttles[std::make_pair(p.subscriber, device)];
+            const mcc::messages::TmParam& param = list[match.index];
+            Slot& slot = (*slots)[param.trait()][param.status()];
+            slot.period = match.period;
+            //первое значение уходит сразу
+            if (slot.sent == 0 || slot.sent <= now - slot.period)
+            {
+                slot.sent = now;
+                slot.isPending = false;
+                indices.push_back(match.index);
+            }
+            else
+            {
+                slot.value = param.value();
+                slot.isPending = true;
+                schedule_(slot.sent + slot.period);
+            }
+        }
+
+        if (indices.size() == list.size())
+        {
+            out->push_back(Delivery{p.subscriber, device, params});
+            continue;
+        }
+        if (indices.empty())
+            continue;
+
+        auto pruned = std::make_shared<mcc::messages::TmParams>();
+        pruned->reserve(indices.size());
+        for (auto index : indices)
+            pruned->push_back(list[index]);
+        out->push_back(Delivery{p.subscriber, device, std::move(pruned)});
+    }
+}
+
+void Subscriptions::flush(mcc::misc::Timestamp now, std::vector<Delivery>* out)
+{
+    out->clear();
+    if (_nextFlush == 0 || _nextFlush > now)
+        return;
+
+    _nextFlush = 0;
+    for (auto& i : _throttles)
+    {
+        std::shared_ptr<mcc::messages::TmParams> params;
+        for (auto& trait : i.second)
+        {
+            for (auto& status : trait.second)
+            {
+                Slot& slot = status.second;
+                if (!slot.isPending)
+                    continue;
+                if (slot.sent > now - slot.period)
+                {
+                    schedule_(slot.sent + slot.period);
+                    continue;
+                }
+                if (!params)
+                    params = std::make_shared<mcc::messages::TmParams>();
+                params->emplace_back(trait.first, status.first, slot.value);
+                slot.sent = now;
+                slot.isPending = false;
+            }
+        }
+        if (params)
+            out->push_back(Delivery{i.first.first, i.first.second, std::move(params)});
+    }
+}
+}
+}
+}
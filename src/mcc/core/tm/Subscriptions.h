@@ -0,0 +1,110 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mcc/misc/NameTable.h"
+#include "mcc/misc/TimeUtils.h"
+#include "mcc/messages/Tm.h"
+
+
+namespace mcc {
+namespace core {
+namespace tm {
+
+//Индекс подписок на телеметрию: устройство -> признак -> статус -> подписчики.
+//Пустые device, trait или status в подписке означают "все устройства", "все признаки" и т.д.
+//Подписка может ограничивать частоту: параметр уходит подписчику не чаще раза в period,
+//промежуточные значения схлопываются до последнего и досылаются flush() по истечении периода.
+class Subscriptions
+{
+public:
+    struct Delivery
+    {
+        mcc::misc::NameId subscriber;
+        std::string device;
+        //исходный список целиком, если подписчику нужны все параметры без ограничения частоты,
+        //иначе только запрошенные и уже разрешённые к отправке
+        mcc::messages::TmParamsPtr params;
+    };
+
+    //period - минимальный интервал между доставками одного параметра, 0 - каждый кадр;
+    //повторная подписка меняет период и возвращает false
+    bool add(mcc::misc::NameId subscriber, const std::string& device, const std::string& trait, const std::string& status, mcc::misc::Timestamp period = 0);
+    //снимает ровно ту подписку, что была оформлена с теми же device/trait/status; false, если её не было
+    bool remove(mcc::misc::NameId subscriber, const std::string& device, const std::string& trait, const std::string& status);
+    bool empty() const { return _devices.empty(); }
+
+    //раскладывает параметры устройства по подписчикам; подписчики без подходящих параметров не попадают в out
+    void route(const std::string& device, const mcc::messages::TmParamsPtr& params, mcc::misc::Timestamp now, std::vector<Delivery>* out);
+    //досылает последние значения, чей период истёк к now
+    void flush(mcc::misc::Timestamp now, std::vector<Delivery>* out);
+    //когда в следующий раз есть что досылать, 0 - нечего
+    mcc::misc::Timestamp nextFlush() const { return _nextFlush; }
+
+private:
+    struct Subscriber
+    {
+        mcc::misc::NameId id;
+        mcc::misc::Timestamp period;
+    };
+    typedef std::vector<Subscriber> Subscribers; //отсортированы по id
+
+    struct Trait
+    {
+        Subscribers all;
+        std::unordered_map<std::string, Subscribers> statuses;
+    };
+
+    struct Device
+    {
+        Subscribers all;
+        std::unordered_map<std::string, Trait> traits;
+    };
+
+    struct Match
+    {
+        std::size_t index;
+        mcc::misc::Timestamp period;
+    };
+
+    struct Pending
+    {
+        mcc::misc::NameId subscriber;
+        bool isWhole; //подписан на всё устройство без ограничения частоты
+        std::vector<Match> matches;
+    };
+
+    //последнее значение параметра у подписчика с ограниченной частотой
+    struct Slot
+    {
+        mcc::misc::NetVariant value;
+        mcc::misc::Timestamp sent = 0;
+        mcc::misc::Timestamp period = 0;
+        bool isPending = false;
+    };
+    typedef std::unordered_map<std::string, std::unordered_map<std::string, Slot>> Slots; //признак -> статус
+    typedef std::map<std::pair<mcc::misc::NameId, std::string>, Slots> Throttles; //(подписчик, устройство)
+
+    static bool insert_(Subscribers* subscribers, mcc::misc::NameId subscriber, mcc::misc::Timestamp period);
+    static bool erase_(Subscribers* subscribers, mcc::misc::NameId subscriber);
+    Pending* pending_(mcc::misc::NameId subscriber);
+    void collect_(const Subscribers& subscribers, std::size_t index, bool skipUnlimited);
+    void schedule_(mcc::misc::Timestamp due);
+
+    std::unordered_map<std::string, Device> _devices;
+    Throttles _throttles;
+    mcc::misc::Timestamp _nextFlush = 0;
+    //переиспользуется между вызовами route(), чтобы не выделять память на каждый кадр
+    std::vector<Pending> _pending;
+    std::size_t _pendingCount = 0;
+    std::vector<std::size_t> _indices;
+};
+}
+}
+}
@@ -29,6 +29,23 @@ namespace core {
 Service::Service(const std::string& name, const mcc::messages::LocalRouterPtr& router, const std::string& protocolName, const PacketSearcher& packetSearcher, bool syncExchange, const ChannelOpenerPtr& channelOpener)
     : mcc::messages::ServiceAbstract(name, router), _syncExchange(syncExchange), _protocolName(protocolName), _packetSearcher(packetSearcher), _channelOpener(channelOpener)
 {
+    handle<mcc::messages::SystemComponentState_Request>();
+    handle<mcc::messages::Cmd>();
+    handle<mcc::messages::CmdCancel>();
+    handle<mcc::messages::DeviceActivate_Request>();
+    handle<mcc::messages::DeviceConnect_Request>();
+    handle<mcc::messages::DeviceDisconnect_Request>();
+    handle<mcc::messages::DeviceFileLoad_Request>();
+    handle<mcc::messages::DeviceFileLoadCancel_Request>();
+    handle<mcc::messages::DeviceList_Response>();
+    handle<mcc::messages::DeviceDescription_Response>();
+    handle<mcc::messages::DeviceUnRegistered>();
+    handle<mcc::messages::DeviceUpdate_Response>();
+    handle<mcc::messages::DeviceUpdated>();
+    handle<mcc::messages::Channel_Request>();
+    handle<mcc::messages::FirmwareDescription_Response>();
+    handle<mcc::messages::FirmwareRegister_Response>();
+    handle<mcc::messages::ProtocolForDevice_Response>();
 }
 
 Service::~Service()
@@ -11,6 +11,16 @@ MESSAGE_REQUEREMENT_DEFINITIONS(Channel_Request);
 MESSAGE_REQUEREMENT_DEFINITIONS(Channel_Response);
 MESSAGE_REQUEREMENT_DEFINITIONS(ChannelState_Response);
 
+bool ChannelState_Response::coalesce(const Message& newer)
+{
+    //полное состояние каналов кодировщика, достаточно последнего
+    const ChannelState_Response* state = dynamic_cast<const ChannelState_Response*>(&newer);
+    if (!state || state->senderId() != senderId())
+        return false;
+    _state = state->_state;
+    return true;
+}
+
 }
 }
 
@@ -63,6 +63,7 @@ public:
     virtual ~ChannelState_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
     const StatChannels& state() const { return _state; }
+    bool coalesce(const Message& newer) override;
 private:
     StatChannels _state;
 };
@@ -41,6 +41,85 @@ void Cmd::serialize_(mcc::protobuf::MessageBody* body) const
         *cmd->mutable_params()->Add() = i.serialize();
 }
 
+void CmdCancel::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto cancel = body->mutable__cmdcancel();
+    cancel->set_collationid(_cmdId);
+    cancel->set_device(_device);
+}
+
+std::unique_ptr<Message> CmdCancel::deserialize(const mcc::protobuf::CmdCancel& body)
+{
+    return mcc::misc::makeUnique<CmdCancel>(body.device(), body.collationid());
+}
+
+void CmdState::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto state = body->mutable__cmdstate();
+    state->set_collationid(_cmdId);
+    state->set_device(_device);
+    state->set_state(_state);
+    if (!_reason.empty())
+        state->set_reason(_reason);
+    state->set_timestamp(_time);
+}
+
+std::unique_ptr<Message> CmdState::deserialize(const mcc::protobuf::CmdState& body)
+{
+    auto state = mcc::misc::makeUnique<CmdState>(body.device(), body.collationid(), (CmdState::Value)body.state(), body.reason());
+    state->_time = body.timestamp();
+    return state;
+}
+
+//подписка и отписка - разные сообщения protobuf, но один класс с isOn()
+void CmdSubscribe_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    if (_isOn)
+        body->mutable__cmdsubscribe_request()->set_device(_device);
+    else
+        body->mutable__cmdunsubscribe_request()->set_device(_device);
+}
+
+std::unique_ptr<Message> CmdSubscribe_Request::deserialize(const mcc::protobuf::CmdSubscribe_Request& body)
+{
+    return mcc::misc::makeUnique<CmdSubscribe_Request>(true, body.device());
+}
+
+std::unique_ptr<Message> CmdSubscribe_Request::deserialize(const mcc::protobuf::CmdUnSubscribe_Request& body)
+{
+    return mcc::misc::makeUnique<CmdSubscribe_Request>(false, body.device());
+}
+
+void CmdSubscribe_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    if (_isOn)
+    {
+        auto response = body->mutable__cmdsubscribe_response();
+        response->set_device(_device);
+        if (!_error.empty())
+            response->set_error(_error);
+    }
+    else
+    {
+        auto response = body->mutable__cmdunsubscribe_response();
+        response->set_device(_device);
+        if (!_error.empty())
+            response->set_error(_error);
+    }
+}
+
+std::unique_ptr<Message> CmdSubscribe_Response::deserialize(const mcc::protobuf::CmdSubscribe_Response& body)
+{
+    CmdSubscribe_Request request(true, body.device());
+    return mcc::misc::makeUnique<CmdSubscribe_Response>(&request, body.error());
+}
+
+std::unique_ptr<Message> CmdSubscribe_Response::deserialize(const mcc::protobuf::CmdUnSubscribe_Response& body)
+{
+    CmdSubscribe_Request request(false, body.device());
+    return mcc::misc::makeUnique<CmdSubscribe_Response>(&request, body.error());
+}
+
 std::unique_ptr<Message> Cmd::deserialize(const mcc::protobuf::Cmd& cmd)
 {
     mcc::misc::CmdParams params;
@@ -11,7 +11,7 @@
 #include "mcc/misc/Cmd.h"
 #include "mcc/messages/Message.h"
 
-namespace mcc { namespace protobuf { class Cmd; } }
+namespace mcc { namespace protobuf { class Cmd; class CmdCancel; class CmdState; class CmdSubscribe_Request; class CmdSubscribe_Response; class CmdUnSubscribe_Request; class CmdUnSubscribe_Response; } }
 
 namespace mcc {
 namespace messages {
@@ -61,8 +61,12 @@ public:
     CmdCancel(const std::string& device, CmdId cmdId) : MessageTo(mcc::Names::coreCmd()), _device(device), _cmdId(cmdId){}
     virtual ~CmdCancel(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::CmdCancel& body);
     CmdId              cmdId()  const { return _cmdId; }
     const std::string& device() const { return _device; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     CmdId       _cmdId;
     std::string _device;
@@ -91,11 +95,12 @@ public:
         : CmdState(cmd.device(), cmd.cmdId(), state, reason)
     {
         //нужно проставлять время формирования состояния
-        _time = mcc::misc::currentDateTime();
+        _time = mcc::misc::currentTimestamp();
     }
 
     virtual ~CmdState(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::CmdState& body);
 
     static inline const char* toString(Value state)
     {
@@ -118,13 +123,16 @@ public:
     const std::string& device()  const { return _device; };
     Value              state()   const { return _state; };
     const std::string& reason()  const { return _reason; };
-    const std::string& time()    const { return _time;  }
+    mcc::misc::Timestamp time()  const { return _time;  }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     CmdId       _cmdId;
     Value       _state;
     std::string _device;
     std::string _reason;
-    std::string _time;
+    mcc::misc::Timestamp _time = 0;
 };
 
 class CmdSubscribe_Request : public MessageTo
@@ -133,8 +141,13 @@ public:
     CmdSubscribe_Request(bool isOn, const std::string& device) : MessageTo(mcc::Names::coreCmd()), _isOn(isOn), _device(device) {}
     virtual ~CmdSubscribe_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::CmdSubscribe_Request& body);
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::CmdUnSubscribe_Request& body);
     bool isOn() const { return _isOn; }
     const std::string& device()  const { return _device; };
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     bool _isOn;
     std::string _device;
@@ -147,9 +160,14 @@ public:
         : Response(request), _isOn(request->isOn()), _device(request->device()), _error(error){}
     virtual ~CmdSubscribe_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::CmdSubscribe_Response& body);
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::CmdUnSubscribe_Response& body);
     bool isOn() const { return _isOn; }
     const std::string& device()  const { return _device; };
     const std::string& error()   const { return _error; };
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     bool _isOn;
     std::string _device;
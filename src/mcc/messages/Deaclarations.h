@@ -3,6 +3,8 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <memory.h>
 #include "mcc/misc/Channel.h"
 
@@ -14,10 +16,13 @@ namespace messages{
     class Message;
     class MessageTo;
     class Response;
+    class Error;
     class SystemState;
     class SystemState_Request;
     class SystemComponentState;
     class SystemComponentState_Request;
+    class SystemComponentTrace;
+    class SystemQueueStats;
     class Cmd;
     class CmdCancel;
     class CmdState;
@@ -60,6 +65,12 @@ namespace messages{
     class TmParamSubscribe_Request;
     class TmParamSubscribe_Response;
     class TmParamList;
+    class TmSnapshot_Request;
+    class TmSnapshot_Response;
+    class TmHistory_Request;
+    class TmHistory_Response;
+    class TmReplay_Request;
+    class TmReplay_Response;
     class ProtocolList_Request;
     class ProtocolList_Response;
     class ProtocolDescription_Request;
@@ -69,6 +80,89 @@ namespace messages{
     class ProtocolForDeviceRegister_Request;
     class ProtocolForDeviceRegister_Response;
 
+    //все типы сообщений, по списку строятся MessageType и таблицы обработчиков
+#define MCC_MESSAGE_TYPES(X) \
+    X(Error) \
+    X(SystemState) \
+    X(SystemState_Request) \
+    X(SystemComponentState) \
+    X(SystemComponentState_Request) \
+    X(SystemComponentTrace) \
+    X(SystemQueueStats) \
+    X(Cmd) \
+    X(CmdCancel) \
+    X(CmdState) \
+    X(CmdSubscribe_Request) \
+    X(CmdSubscribe_Response) \
+    X(DeviceActivate_Request) \
+    X(DeviceActivate_Response) \
+    X(DeviceConnect_Request) \
+    X(DeviceConnect_Response) \
+    X(DeviceDisconnect_Request) \
+    X(DeviceDisconnect_Response) \
+    X(DeviceFileLoad_Request) \
+    X(DeviceFileLoad_Response) \
+    X(DeviceFileLoadCancel_Request) \
+    X(DeviceList_Request) \
+    X(DeviceList_Response) \
+    X(DeviceDescription_Request) \
+    X(DeviceDescription_Response) \
+    X(DeviceRegister_Request) \
+    X(DeviceRegister_Response) \
+    X(DeviceRegistered) \
+    X(DeviceUnRegistered) \
+    X(DeviceUpdate_Request) \
+    X(DeviceUpdate_Response) \
+    X(DeviceUpdated) \
+    X(DeviceUnRegister_Request) \
+    X(DeviceUnRegister_Response) \
+    X(DeviceState_Response) \
+    X(DeviceActionLog) \
+    X(FirmwareList_Request) \
+    X(FirmwareList_Response) \
+    X(FirmwareDescription_Request) \
+    X(FirmwareDescription_Response) \
+    X(FirmwareRegister_Request) \
+    X(FirmwareRegister_Response) \
+    X(FirmwareRegistered) \
+    X(Channel_Request) \
+    X(Channel_Response) \
+    X(ChannelState_Response) \
+    X(TmParamSubscribe_Request) \
+    X(TmParamSubscribe_Response) \
+    X(TmParamList) \
+    X(TmSnapshot_Request) \
+    X(TmSnapshot_Response) \
+    X(TmHistory_Request) \
+    X(TmHistory_Response) \
+    X(TmReplay_Request) \
+    X(TmReplay_Response) \
+    X(ProtocolList_Request) \
+    X(ProtocolList_Response) \
+    X(ProtocolDescription_Request) \
+    X(ProtocolDescription_Response) \
+    X(ProtocolForDevice_Request) \
+    X(ProtocolForDevice_Response) \
+    X(ProtocolForDeviceRegister_Request) \
+    X(ProtocolForDeviceRegister_Response)
+
+    enum class MessageType : uint8_t
+    {
+#define MCC_MESSAGE_TYPE_ENUM(TypeName) TypeName,
+        MCC_MESSAGE_TYPES(MCC_MESSAGE_TYPE_ENUM)
+#undef MCC_MESSAGE_TYPE_ENUM
+    };
+
+#define MCC_MESSAGE_TYPE_COUNT(TypeName) +1
+    const std::size_t messageTypeCount = 0 MCC_MESSAGE_TYPES(MCC_MESSAGE_TYPE_COUNT);
+#undef MCC_MESSAGE_TYPE_COUNT
+
+    //тип сообщения известен при компиляции: MessageTypeOf<Cmd>::value == MessageType::Cmd
+    template<class T> struct MessageTypeOf;
+#define MCC_MESSAGE_TYPE_OF(TypeName) template<> struct MessageTypeOf<TypeName> { static const MessageType value = MessageType::TypeName; };
+    MCC_MESSAGE_TYPES(MCC_MESSAGE_TYPE_OF)
+#undef MCC_MESSAGE_TYPE_OF
+
     class MessageProcessor;
     class MessageSenderX;
     typedef std::unique_ptr<Message> MessagePtr;
@@ -3,6 +3,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "mcc/messages/Device.h"
+#include "mcc/messages/protobuf/Message.pb.h"
 
 namespace mcc {
 namespace messages {
@@ -32,6 +33,218 @@ MESSAGE_REQUEREMENT_DEFINITIONS(DeviceDescription_Response);
 MESSAGE_REQUEREMENT_DEFINITIONS(DeviceState_Response);
 MESSAGE_REQUEREMENT_DEFINITIONS(DeviceActionLog);
 
+bool DeviceState_Response::coalesce(const Message& newer)
+{
+    //полное состояние устройств кодировщика, достаточно последнего
+    const DeviceState_Response* state = dynamic_cast<const DeviceState_Response*>(&newer);
+    if (!state || state->senderId() != senderId())
+        return false;
+    _state = state->_state;
+    return true;
 }
+
+void DeviceActivate_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto request = body->mutable__deviceactivate_request();
+    request->set_device(_device);
+    request->set_isactive(_isActive);
+}
+
+std::unique_ptr<Message> DeviceActivate_Request::deserialize(const mcc::protobuf::DeviceActivate_Request& body)
+{
+    return mcc::misc::makeUnique<DeviceActivate_Request>(body.device(), body.isactive());
+}
+
+void DeviceActivate_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto response = body->mutable__deviceactivate_response();
+    response->set_device(_device);
+    response->set_isactive(_isActive);
+    if (!_error.empty())
+        response->set_error(_error);
+}
+
+std::unique_ptr<Message> DeviceActivate_Response::deserialize(const mcc::protobuf::DeviceActivate_Response& body)
+{
+    DeviceActivate_Request request(body.device(), body.isactive());
+    return mcc::misc::makeUnique<DeviceActivate_Response>(&request, body.error());
+}
+
+void DeviceConnect_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto request = body->mutable__deviceconnect_request();
+    request->set_device(_device);
+    request->set_channel(_channel);
+}
+
+std::unique_ptr<Message> DeviceConnect_Request::deserialize(const mcc::protobuf::DeviceConnect_Request& body)
+{
+    return mcc::misc::makeUnique<DeviceConnect_Request>(body.device(), body.channel());
+}
+
+void DeviceConnect_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto response = body->mutable__deviceconnect_response();
+    response->set_device(_device);
+    response->set_channel(_channel);
+    if (!_error.empty())
+        response->set_error(_error);
+}
+
+std::unique_ptr<Message> DeviceConnect_Response::deserialize(const mcc::protobuf::DeviceConnect_Response& body)
+{
+    DeviceConnect_Request request(body.device(), body.channel());
+    return mcc::misc::makeUnique<DeviceConnect_Response>(&request, body.error());
+}
+
+void DeviceDisconnect_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto request = body->mutable__devicedisconnect_request();
+    request->set_device(_device);
+    request->set_channel(_channel);
+}
+
+std::unique_ptr<Message> DeviceDisconnect_Request::deserialize(const mcc::protobuf::DeviceDisconnect_Request& body)
+{
+    return mcc::misc::makeUnique<DeviceDisconnect_Request>(body.device(), body.channel());
+}
+
+void DeviceDisconnect_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto response = body->mutable__devicedisconnect_response();
+    response->set_device(_device);
+    response->set_channel(_channel);
+    if (!_error.empty())
+        response->set_error(_error);
+}
+
+std::unique_ptr<Message> DeviceDisconnect_Response::deserialize(const mcc::protobuf::DeviceDisconnect_Response& body)
+{
+    DeviceDisconnect_Request request(body.device(), body.channel());
+    return mcc::misc::makeUnique<DeviceDisconnect_Response>(&request, body.error());
+}
+
+void DeviceUnRegister_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    body->mutable__deviceunregister_request()->set_device(_device);
+}
+
+std::unique_ptr<Message> DeviceUnRegister_Request::deserialize(const mcc::protobuf::DeviceUnRegister_Request& body)
+{
+    return mcc::misc::makeUnique<DeviceUnRegister_Request>(body.device());
+}
+
+void DeviceUnRegister_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto response = body->mutable__deviceunregister_response();
+    response->set_device(_device);
+    if (!_error.empty())
+        response->set_error(_error);
+}
+
+std::unique_ptr<Message> DeviceUnRegister_Response::deserialize(const mcc::protobuf::DeviceUnRegister_Response& body)
+{
+    DeviceUnRegister_Request request(body.device());
+    return mcc::misc::makeUnique<DeviceUnRegister_Response>(&request, body.error());
+}
+
+void DeviceRegistered::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto registered = body->mutable__device_registered();
+    registered->set_device(_name);
+    registered->set_id(_id);
+    registered->set_info(_info);
 }
 
+std::unique_ptr<Message> DeviceRegistered::deserialize(const mcc::protobuf::Device_Registered& body)
+{
+    return mcc::misc::makeUnique<DeviceRegistered>(body.id(), body.device(), body.info());
+}
+
+void DeviceUnRegistered::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    body->mutable__device_unregistered()->set_device(_device);
+}
+
+std::unique_ptr<Message> DeviceUnRegistered::deserialize(const mcc::protobuf::Device_UnRegistered& body)
+{
+    return mcc::misc::makeUnique<DeviceUnRegistered>(body.device());
+}
+
+void DeviceFileLoad_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto request = body->mutable__devicefileload_request();
+    request->set_device(_device);
+    request->set_file_path(_file_path);
+    request->set_isup(_dir == Up);
+}
+
+std::unique_ptr<Message> DeviceFileLoad_Request::deserialize(const mcc::protobuf::DeviceFileLoad_Request& body)
+{
+    return mcc::misc::makeUnique<DeviceFileLoad_Request>(body.device(), body.file_path(), body.isup() ? Up : Down);
+}
+
+void DeviceFileLoadCancel_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto request = body->mutable__devicefileloadcancel_request();
+    request->set_device(_device);
+    request->set_file_path(_file_path);
+    if (!_reason.empty())
+        request->set_reason(_reason);
+}
+
+std::unique_ptr<Message> DeviceFileLoadCancel_Request::deserialize(const mcc::protobuf::DeviceFileLoadCancel_Request& body)
+{
+    return mcc::misc::makeUnique<DeviceFileLoadCancel_Request>(body.device(), body.file_path(), body.reason());
+}
+
+void DeviceFileLoad_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto response = body->mutable__devicefileload_response();
+    response->set_device(_device);
+    response->set_file_path(_file_path);
+    if (!_error.empty())
+        response->set_error(_error);
+}
+
+std::unique_ptr<Message> DeviceFileLoad_Response::deserialize(const mcc::protobuf::DeviceFileLoad_Response& body)
+{
+    DeviceFileLoadCancel_Request request(body.device(), body.file_path(), std::string());
+    return mcc::misc::makeUnique<DeviceFileLoad_Response>(&request, body.error());
+}
+
+void DeviceList_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    body->mutable__devicelist_request();
+}
+
+std::unique_ptr<Message> DeviceList_Request::deserialize(const mcc::protobuf::DeviceList_Request&)
+{
+    return mcc::misc::makeUnique<DeviceList_Request>();
+}
+
+void DeviceList_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto response = body->mutable__devicelist_response();
+    for (const auto& i : _devices)
+        response->add_devices(i);
+}
+
+std::unique_ptr<Message> DeviceList_Response::deserialize(const mcc::protobuf::DeviceList_Response& body)
+{
+    DeviceList_Request request;
+    return mcc::misc::makeUnique<DeviceList_Response>(&request, std::vector<std::string>(body.devices().begin(), body.devices().end()));
+}
+
+void DeviceDescription_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    body->mutable__devicedescription_request()->set_device(_device);
+}
+
+std::unique_ptr<Message> DeviceDescription_Request::deserialize(const mcc::protobuf::DeviceDescription_Request& body)
+{
+    return mcc::misc::makeUnique<DeviceDescription_Request>(body.device());
+}
+
+}
+}
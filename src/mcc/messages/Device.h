@@ -7,6 +7,8 @@
 #include "mcc/messages/Message.h"
 #include "mcc/messages/Stats.h"
 
+namespace mcc { namespace protobuf { class DeviceActivate_Request; class DeviceActivate_Response; class DeviceConnect_Request; class DeviceConnect_Response; class DeviceDisconnect_Request; class DeviceDisconnect_Response; class DeviceUnRegister_Request; class DeviceUnRegister_Response; class Device_Registered; class Device_UnRegistered; class DeviceFileLoad_Request; class DeviceFileLoadCancel_Request; class DeviceFileLoad_Response; class DeviceList_Request; class DeviceList_Response; class DeviceDescription_Request; } }
+
 
 namespace mcc {
 namespace messages {
@@ -20,8 +22,12 @@ public:
     }
     virtual ~DeviceActivate_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceActivate_Request& body);
     const std::string& device()  const { return _device; }
     bool isActive() const { return _isActive; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     bool _isActive;
     std::string _device;
@@ -36,9 +42,13 @@ public:
     }
     virtual ~DeviceActivate_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceActivate_Response& body);
     const std::string& device()  const { return _device; }
     bool isActive() const { return _isActive; }
     const std::string& error() const { return _error; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     bool _isActive;
     std::string _device;
@@ -54,8 +64,12 @@ public:
     }
     virtual ~DeviceConnect_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceConnect_Request& body);
     const std::string& device()  const { return _device; }
     const std::string& channel()  const { return _channel; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _device;
     std::string _channel;
@@ -70,9 +84,13 @@ public:
     }
     virtual ~DeviceConnect_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceConnect_Response& body);
     const std::string& device()  const { return _device; }
     const std::string& channel()  const { return _channel; }
     const std::string& error() const { return _error; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _device;
     std::string _channel;
@@ -88,8 +106,12 @@ public:
     }
     virtual ~DeviceDisconnect_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceDisconnect_Request& body);
     const std::string& device()  const { return _device; }
     const std::string& channel()  const { return _channel; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _device;
     std::string _channel;
@@ -104,9 +126,13 @@ public:
     }
     virtual ~DeviceDisconnect_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceDisconnect_Response& body);
     const std::string& device()  const { return _device; }
     const std::string& channel()  const { return _channel; }
     const std::string& error() const { return _error; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _device;
     std::string _channel;
@@ -160,7 +186,11 @@ public:
     }
     virtual ~DeviceUnRegister_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceUnRegister_Request& body);
     const std::string& device()  const { return _device; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _device;
 };
@@ -174,8 +204,12 @@ public:
     }
     virtual ~DeviceUnRegister_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceUnRegister_Response& body);
     const std::string& device()  const { return _device; }
     const std::string& error() const { return _error; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _device;
     std::string _error;
@@ -190,9 +224,13 @@ public:
     }
     virtual ~DeviceRegistered(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::Device_Registered& body);
     std::size_t id() const { return _id; }
     const std::string& name()  const { return _name; }
     const std::string& info()  const { return _info; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::size_t _id;
     std::string _name;
@@ -205,7 +243,11 @@ public:
     DeviceUnRegistered(const std::string& device) : MessageTo(mcc::Names::multicast()), _device(device) {}
     virtual ~DeviceUnRegistered(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::Device_UnRegistered& body);
     const std::string& device()  const { return _device; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _device;
 };
@@ -267,9 +309,13 @@ public:
     }
     virtual ~DeviceFileLoad_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceFileLoad_Request& body);
     const std::string& device()  const { return _device; }
     const std::string& file_path()  const { return _file_path; }
     Direction direction()  const { return _dir; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _device;
     std::string _file_path;
@@ -285,9 +331,13 @@ public:
     }
     virtual ~DeviceFileLoadCancel_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceFileLoadCancel_Request& body);
     const std::string& device()  const { return _device; }
     const std::string& file_path()  const { return _file_path; }
     const std::string& reason()  const { return _reason; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _device;
     std::string _file_path;
@@ -307,9 +357,13 @@ public:
     }
     virtual ~DeviceFileLoad_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceFileLoad_Response& body);
     const std::string& device()  const { return _device; }
     const std::string& file_path()  const { return _file_path; }
     const std::string& error()  const { return _error; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _device;
     std::string _file_path;
@@ -322,6 +376,10 @@ public:
     DeviceList_Request() : MessageTo(mcc::Names::coreDb()) {}
     virtual ~DeviceList_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceList_Request& body);
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
 };
 
@@ -332,7 +390,11 @@ public:
     DeviceList_Response(const DeviceList_Request* request, std::vector<std::string>&& devices) : Response(request), _devices(std::move(devices)){}
     virtual ~DeviceList_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceList_Response& body);
     const std::vector<std::string>& devices() const { return _devices; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::vector<std::string> _devices;
 };
@@ -343,7 +405,11 @@ public:
     DeviceDescription_Request(const std::string& device) : MessageTo(mcc::Names::coreDb()), _device(device){}
     virtual ~DeviceDescription_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::DeviceDescription_Request& body);
     const std::string& device() const { return _device; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _device;
 };
@@ -416,6 +482,7 @@ public:
     virtual ~DeviceState_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
     const StatDevices& state() const { return _state; }
+    bool coalesce(const Message& newer) override;
 private:
     StatDevices _state;
 };
@@ -3,6 +3,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "mcc/messages/Firmware.h"
+#include "mcc/messages/protobuf/Message.pb.h"
 
 namespace mcc {
 namespace messages {
@@ -15,6 +16,38 @@ MESSAGE_REQUEREMENT_DEFINITIONS(FirmwareRegister_Request);
 MESSAGE_REQUEREMENT_DEFINITIONS(FirmwareRegister_Response);
 MESSAGE_REQUEREMENT_DEFINITIONS(FirmwareRegistered);
 
+void FirmwareList_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    body->mutable__firmwarelist_request();
 }
+
+std::unique_ptr<Message> FirmwareList_Request::deserialize(const mcc::protobuf::FirmwareList_Request&)
+{
+    return mcc::misc::makeUnique<FirmwareList_Request>();
+}
+
+void FirmwareList_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto response = body->mutable__firmwarelist_response();
+    for (const auto& i : _firmwares)
+        response->add_firmwares(i);
 }
 
+std::unique_ptr<Message> FirmwareList_Response::deserialize(const mcc::protobuf::FirmwareList_Response& body)
+{
+    FirmwareList_Request request;
+    return mcc::misc::makeUnique<FirmwareList_Response>(&request, std::vector<std::string>(body.firmwares().begin(), body.firmwares().end()));
+}
+
+void FirmwareDescription_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    body->mutable__firmwaredescription_request()->set_firmware(_firmware);
+}
+
+std::unique_ptr<Message> FirmwareDescription_Request::deserialize(const mcc::protobuf::FirmwareDescription_Request& body)
+{
+    return mcc::misc::makeUnique<FirmwareDescription_Request>(body.firmware());
+}
+
+}
+}
@@ -7,6 +7,8 @@
 #include "mcc/messages/Message.h"
 #include "mcc/misc/Firmware.h"
 
+namespace mcc { namespace protobuf { class FirmwareList_Request; class FirmwareList_Response; class FirmwareDescription_Request; } }
+
 
 namespace mcc {
 namespace messages {
@@ -17,6 +19,10 @@ public:
     FirmwareList_Request () : MessageTo(mcc::Names::coreDb()){}
     virtual ~FirmwareList_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::FirmwareList_Request& body);
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
 };
 
@@ -33,7 +39,11 @@ public:
     }
     virtual ~FirmwareList_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::FirmwareList_Response& body);
     const std::vector<std::string>& firmwares()  const { return _firmwares; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::vector<std::string> _firmwares;
 };
@@ -44,7 +54,11 @@ public:
     FirmwareDescription_Request(const std::string& firmware) : MessageTo(mcc::Names::coreDb()), _firmware(firmware){}
     virtual ~FirmwareDescription_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::FirmwareDescription_Request& body);
     const std::string& firmware() const { return _firmware; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _firmware;
 };
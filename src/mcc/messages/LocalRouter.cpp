@@ -2,58 +2,341 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <algorithm>
+#include <typeinfo>
 #include "mcc/messages/LocalRouter.h"
 #include "mcc/messages/Message.h"
 #include "mcc/messages/MessageSender.h"
+#include "mcc/messages/Tm.h"
+#include "mcc/messages/Device.h"
+#include "mcc/messages/Channel.h"
+#include "mcc/misc/Executor.h"
+#include "mcc/misc/ShmRing.h"
 
 
 namespace mcc {
 namespace messages {
 
-LocalRouter::LocalRouter() : _isLocked(false), _in(std::make_shared<mcc::messages::MessageQueue::element_type>())
+const std::size_t LocalRouter::defaultCapacity;
+
+LocalRouter::Destination::Destination(mcc::misc::NameId id, std::size_t capacity)
+    : id(id)
+    , queue(std::make_shared<mcc::messages::MessageQueue::element_type>())
+    , capacity(capacity)
+    , dropped(0)
+    , coalesced(0)
+    , blocked(0)
+    , overflowed(0)
+    , rejected(0)
+    , isFiltered(false)
+{
+    for (auto& i : accepts)
+        i = true;
+}
+
+LocalRouter::LocalRouter() : _isLocked(false), _in(std::make_shared<mcc::messages::MessageQueue::element_type>()), _blockTimeout(100)
 {
+    //телеметрия и периодические состояния устаревают, их можно объединять;
+    //остальное (команды, запросы, ответы) терять нельзя
+    for (auto& i : _policyByType)
+        i = QueuePolicy::Block;
+    _policyByType[(std::size_t)MessageType::TmParamList] = QueuePolicy::Coalesce;
+    _policyByType[(std::size_t)MessageType::DeviceState_Response] = QueuePolicy::Coalesce;
+    _policyByType[(std::size_t)MessageType::ChannelState_Response] = QueuePolicy::Coalesce;
+    //но телеметрия идёт в архив через core.tm, который пересылает в core.db всё, что получил:
+    //объединённое в любой из этих очередей значение в архив уже не попадёт
+    _policyByClient[mcc::Names::coreTm()][MessageType::TmParamList] = QueuePolicy::Block;
+    _policyByClient[mcc::Names::coreDb()][MessageType::TmParamList] = QueuePolicy::Block;
 }
 
 std::vector<std::string> LocalRouter::locals() const
 {
     std::vector<std::string> clients;
-    for (const auto i : _queueByName)
+    for (const auto& i : _destinations)
     {
         clients.push_back(i.first);
     }
     return clients;
 }
 
-void LocalRouter::add(const std::string& client)
+void LocalRouter::add(const std::string& client, std::size_t capacity)
+{
+    if (_isLocked)
+    {
+        assert(false);
+        return;
+    }
+    auto i = _destinations.find(client);
+    if (i != _destinations.end())
+        return;
+    auto id = mcc::misc::NameTable::intern(client);
+    Destination* destination = new Destination(id, capacity);
+    updatePolicies(destination, client);
+    _destinations[client] = DestinationPtr(destination);
+    if (_destinationById.size() <= id)
+        _destinationById.resize(id + 1, nullptr);
+    _destinationById[id] = destination;
+}
+
+void LocalRouter::addRemote(const std::string& client, const std::shared_ptr<mcc::misc::ShmRing>& ring)
 {
     if (_isLocked)
     {
         assert(false);
         return;
     }
-    auto i = _queueByName.find(client);
-    if (i == _queueByName.end())
-        _queueByName[client] = std::make_shared<mcc::messages::MessageQueue::element_type>();
+    add(client);
+    _destinations[client]->remote = ring;
 }
 
 mcc::messages::MessageQueue LocalRouter::recv(const std::string& client) const
 {
     lock();
-    const auto i = _queueByName.find(client);
-    if (i == _queueByName.end())
+    const auto i = _destinations.find(client);
+    if (i == _destinations.end())
     {
         assert(false);
         return mcc::messages::MessageQueue();
     }
-    return i->second;
+    return i->second->queue;
 }
 
 mcc::messages::MessageSender LocalRouter::send(const std::string& client) const
 {
     lock();
-    return std::make_shared<mcc::messages::MessageSenderX>(client, _in);
+    return std::make_shared<mcc::messages::MessageSenderX>(client, _in, this);
+}
+
+//после lock() список получателей не меняется, поиск по id без блокировок
+LocalRouter::Destination* LocalRouter::destination(mcc::misc::NameId client) const
+{
+    if (client >= _destinationById.size())
+        return nullptr;
+    return _destinationById[client];
+}
+
+//ставит сообщение прямо в очередь получателя с учётом её ёмкости и политики типа сообщения
+bool LocalRouter::deliver(const std::string& client, MessagePtr&& message) const
+{
+    auto i = _destinations.find(client);
+    if (i == _destinations.end())
+        return false;
+    deliver(i->second.get(), std::move(message));
+    return true;
+}
+
+void LocalRouter::route(MessagePtr&& message) const
+{
+    Destination* to = destination(message->receiverId());
+    if (to)
+        deliver(to, std::move(message));
+    else
+        _in->send(std::move(message));
+}
+
+void LocalRouter::setCapacity(const std::string& client, std::size_t capacity)
+{
+    if (_isLocked)
+    {
+        assert(false);
+        return;
+    }
+    auto i = _destinations.find(client);
+    if (i != _destinations.end())
+        i->second->capacity = capacity;
+}
+
+void LocalRouter::setPolicy(MessageType type, QueuePolicy policy)
+{
+    if (_isLocked)
+    {
+        assert(false);
+        return;
+    }
+    _policyByType[(std::size_t)type] = policy;
+    for (const auto& i : _destinations)
+        updatePolicies(i.second.get(), i.first);
+}
+
+void LocalRouter::setPolicy(const std::string& client, MessageType type, QueuePolicy policy)
+{
+    if (_isLocked)
+    {
+        assert(false);
+        return;
+    }
+    _policyByClient[client][type] = policy;
+    auto i = _destinations.find(client);
+    if (i != _destinations.end())
+        updatePolicies(i->second.get(), client);
+}
+
+void LocalRouter::updatePolicies(Destination* to, const std::string& client)
+{
+    std::copy(std::begin(_policyByType), std::end(_policyByType), std::begin(to->policies));
+    auto i = _policyByClient.find(client);
+    if (i == _policyByClient.end())
+        return;
+    for (const auto& j : i->second)
+        to->policies[(std::size_t)j.first] = j.second;
 }
 
+void LocalRouter::setAccepted(const std::string& client, const std::bitset<messageTypeCount>& types)
+{
+    auto i = _destinations.find(client);
+    if (i == _destinations.end())
+        return;
+    for (std::size_t type = 0; type < messageTypeCount; type++)
+        i->second->accepts[type].store(types.test(type), std::memory_order_relaxed);
+    i->second->isFiltered = !types.all();
+}
+
+QueuePolicy LocalRouter::policy(const std::string& client, MessageType type) const
+{
+    auto i = _destinations.find(client);
+    if (i == _destinations.end())
+        return _policyByType[(std::size_t)type];
+    return i->second->policies[(std::size_t)type];
+}
+
+StatQueues LocalRouter::queueStats() const
+{
+    StatQueues stats;
+    stats.reserve(_destinations.size());
+    for (const auto& i : _destinations)
+    {
+        StatQueue s;
+        s._name = i.first;
+        s._size = i.second->queue->size();
+        s._capacity = i.second->capacity;
+        s._dropped = i.second->dropped;
+        s._coalesced = i.second->coalesced;
+        s._blocked = i.second->blocked;
+        s._overflowed = i.second->overflowed;
+        s._rejected = i.second->rejected;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+std::size_t LocalRouter::queueSize(mcc::misc::NameId client) const
+{
+    Destination* to = destination(client);
+    if (!to || to->remote)
+        return 0;
+    return to->queue->size();
+}
+
+void LocalRouter::deliver(Destination* to, MessagePtr&& message) const
+{
+    if (!to->accepts[(std::size_t)message->message_type()].load(std::memory_order_relaxed))
+    {
+        to->rejected++;
+        return;
+    }
+    if (to->remote)
+    {
+        deliverRemote(to, std::move(message));
+        return;
+    }
+
+    QueuePolicy p = to->policies[(std::size_t)message->message_type()];
+    if (p == QueuePolicy::Block)
+    {
+        if (to->queue->size() >= to->capacity)
+        {
+            to->blocked++;
+            //получатель может работать в том же пуле потоков, поэтому ждём ограниченное время
+            //и превышаем ёмкость, но не теряем сообщение. Задача пула не ждёт совсем: она держит
+            //поток, который может быть нужен получателю, чтобы разобрать очередь
+            if (mcc::misc::Executor::isWorkerThread() || !to->queue->waitForSpace(to->capacity, _blockTimeout))
+                to->overflowed++;
+        }
+        to->queue->send(std::move(message));
+        return;
+    }
+
+    to->queue->update([&](std::deque<MessagePtr>* queue)
+    {
+        if (queue->size() < to->capacity)
+        {
+            queue->push_back(std::move(message));
+            return true;
+        }
+
+        if (p == QueuePolicy::Coalesce)
+        {
+            for (auto& queued : *queue)
+            {
+                if (queued->coalesce(*message))
+                {
+                    to->coalesced++;
+                    return false;
+                }
+            }
+        }
+
+        to->dropped++;
+        for (auto i = queue->begin(); i != queue->end(); ++i)
+        {
+            if (typeid(**i) == typeid(*message))
+            {
+                queue->erase(i);
+                queue->push_back(std::move(message));
+                return true;
+            }
+        }
+        //в очереди нет сообщений этого типа, самое старое - новое
+        return false;
+    });
+}
+
+void LocalRouter::deliverBatch(Destination* to, std::vector<MessagePtr>* messages) const
+{
+    if (to->remote)
+    {
+        for (auto& message : *messages)
+            deliver(to, std::move(message));
+        messages->clear();
+        return;
+    }
+    if (to->isFiltered)
+    {
+        auto end = std::remove_if(messages->begin(), messages->end(), [to](const MessagePtr& message)
+        {
+            return !to->accepts[(std::size_t)message->message_type()].load(std::memory_order_relaxed);
+        });
+        to->rejected += (std::size_t)(messages->end() - end);
+        messages->erase(end, messages->end());
+    }
+    if (to->queue->size() + messages->size() <= to->capacity)
+    {
+        to->queue->sendBatch(std::move(*messages));
+        return;
+    }
+    for (auto& message : *messages)
+        deliver(to, std::move(message));
+    messages->clear();
+}
+
+//очередь удалённого получателя - ring; политики очереди к нему не применяются, при переполнении
+//ждём как для QueuePolicy::Block, но сообщение, не поместившееся за blockTimeout, теряется
+void LocalRouter::deliverRemote(Destination* to, MessagePtr&& message) const
+{
+    if (!Message::isSerializable(message->message_type()))
+    {
+        to->rejected++;
+        return;
+    }
+    static thread_local std::vector<uint8_t> frame;
+    message->serialize(&frame);
+    std::lock_guard<std::mutex> lock(to->remoteMutex);
+    if (to->remote->write(frame.data(), frame.size()))
+        return;
+    to->blocked++;
+    if (!to->remote->writeFor(frame.data(), frame.size(), _blockTimeout))
+        to->dropped++;
+}
 
 }
 }
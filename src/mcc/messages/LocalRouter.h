@@ -3,32 +3,106 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <atomic>
+#include <bitset>
+#include <chrono>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
+#include "mcc/misc/NameTable.h"
 #include "mcc/messages/Deaclarations.h"
+#include "mcc/messages/Stats.h"
 
 
 namespace mcc { namespace core { namespace router { class Service; } } }
+namespace mcc { namespace misc { class ShmRing; } }
 
 namespace mcc {
 namespace messages {
 
+//что делать с сообщением, если очередь получателя заполнена
+enum class QueuePolicy
+{
+    Block,      //ждать освобождения места (не дольше blockTimeout), затем всё равно поставить в очередь
+    DropOldest, //удалить самое старое сообщение того же типа
+    Coalesce,   //объединить с сообщением того же типа в очереди (Message::coalesce), иначе как DropOldest
+};
+
 class LocalRouter
 {
 public:
     friend mcc::core::router::Service;
+    friend mcc::messages::MessageSenderX;
     LocalRouter();
     std::vector<std::string> locals() const;
-    void add(const std::string& client);
+    void add(const std::string& client, std::size_t capacity = defaultCapacity);
+    //client работает в другом процессе: сообщения для него сериализуются в ring, на той стороне
+    //их читает ShmLink; несериализуемые сообщения считаются отброшенными (rejected)
+    void addRemote(const std::string& client, const std::shared_ptr<mcc::misc::ShmRing>& ring);
     inline void lock() const { _isLocked = true; }
     mcc::messages::MessageQueue recv(const std::string& client) const;
+    //отправитель ставит сообщения прямо в очереди получателей и не должен пережить роутер
     mcc::messages::MessageSender send(const std::string& client) const;
 
+    bool deliver(const std::string& client, MessagePtr&& message) const;
+    //сообщение с уже заполненными отправителем и получателем, например, пришедшее из другого
+    //процесса: в очередь получателя или, если он не локальный, через поток роутера
+    void route(MessagePtr&& message) const;
+
+    void setCapacity(const std::string& client, std::size_t capacity);
+    //политика по умолчанию для всех получателей, у которых она не задана отдельно
+    void setPolicy(MessageType type, QueuePolicy policy);
+    //политика только для сообщений, идущих в client; можно вызывать до add()
+    void setPolicy(const std::string& client, MessageType type, QueuePolicy policy);
+    //сообщения других типов отбрасываются до постановки в очередь client; можно вызывать
+    //после lock(), пока идут сообщения
+    void setAccepted(const std::string& client, const std::bitset<messageTypeCount>& types);
+    QueuePolicy policy(const std::string& client, MessageType type) const;
+    StatQueues queueStats() const;
+    //сколько сообщений ждёт в очереди client, чтобы не заваливать медленного получателя;
+    //0 - нет такого локального получателя
+    std::size_t queueSize(mcc::misc::NameId client) const;
+
+    static const std::size_t defaultCapacity = 10000;
+
 private:
+    struct Destination
+    {
+        Destination(mcc::misc::NameId id, std::size_t capacity);
+
+        mcc::misc::NameId id;
+        mcc::messages::MessageQueue queue;
+        std::size_t capacity;
+        std::atomic<std::size_t> dropped;
+        std::atomic<std::size_t> coalesced;
+        std::atomic<std::size_t> blocked;
+        std::atomic<std::size_t> overflowed;
+        std::atomic<std::size_t> rejected;
+        std::atomic<bool> isFiltered;
+        std::atomic<bool> accepts[messageTypeCount];
+        //по MessageType, чтобы deliver() не искал политику по имени
+        QueuePolicy policies[messageTypeCount];
+        std::shared_ptr<mcc::misc::ShmRing> remote;
+        std::mutex remoteMutex; //у ring один писатель, а отправителей много
+    };
+    typedef std::unique_ptr<Destination> DestinationPtr;
+
+    //nullptr - не локальный получатель
+    Destination* destination(mcc::misc::NameId client) const;
+    void deliver(Destination* to, MessagePtr&& message) const;
+    void deliverBatch(Destination* to, std::vector<MessagePtr>* messages) const;
+    void deliverRemote(Destination* to, MessagePtr&& message) const;
+    void updatePolicies(Destination* to, const std::string& client);
+
     mutable bool _isLocked;
     mcc::messages::MessageQueue _in;
-    std::map<std::string, mcc::messages::MessageQueue> _queueByName;
+    std::map<std::string, DestinationPtr> _destinations;
+    std::vector<Destination*> _destinationById;
+    QueuePolicy _policyByType[messageTypeCount];
+    std::map<std::string, std::map<MessageType, QueuePolicy>> _policyByClient;
+    std::chrono::milliseconds _blockTimeout;
 };
 typedef std::shared_ptr<LocalRouter> LocalRouterPtr;
 
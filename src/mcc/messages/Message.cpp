@@ -5,6 +5,10 @@
 #include <QDebug>
 #include "mcc/messages/Message.h"
 #include "mcc/messages/Cmd.h"
+#include "mcc/messages/Device.h"
+#include "mcc/messages/Firmware.h"
+#include "mcc/messages/Protocol.h"
+#include "mcc/messages/System.h"
 #include "mcc/messages/Tm.h"
 #include "mcc/messages/protobuf/Message.pb.h"
 
@@ -12,52 +16,232 @@
 namespace mcc {
 namespace messages {
 
+#define MCC_MESSAGE_TYPE_OF_DEFINITION(TypeName) const MessageType MessageTypeOf<TypeName>::value;
+MCC_MESSAGE_TYPES(MCC_MESSAGE_TYPE_OF_DEFINITION)
+#undef MCC_MESSAGE_TYPE_OF_DEFINITION
+
+//дерево protobuf для разбора и сборки живёт в arena с начальным блоком из памяти потока,
+//поэтому на сообщение нет ни одного выделения памяти под узлы дерева; protobuf без arena
+//(2.x из thirdparty) - переиспользуем объект потока, Clear() сохраняет выделенную память.
+//До 3.14 CreateMessage требует cc_enable_arenas в .proto, а thirdparty protoc 2.x эту опцию
+//не знает, поэтому arena только там, где она включена по умолчанию
+namespace {
+
+#if GOOGLE_PROTOBUF_VERSION >= 3014000
+
+class ProtoScope
+{
+public:
+    ProtoScope() : _arena(options())
+    {
+        _message = google::protobuf::Arena::CreateMessage<mcc::protobuf::Message>(&_arena);
+    }
+    mcc::protobuf::Message* operator->() { return _message; }
+    mcc::protobuf::Message& operator*() { return *_message; }
+
+private:
+    static google::protobuf::ArenaOptions options()
+    {
+        alignas(8) static thread_local char block[16 * 1024];
+        google::protobuf::ArenaOptions options;
+        options.initial_block = block;
+        options.initial_block_size = sizeof(block);
+        return options;
+    }
+
+    google::protobuf::Arena _arena;
+    mcc::protobuf::Message* _message;
+};
+
+#else
+
+class ProtoScope
+{
+public:
+    ProtoScope() : _message(&instance()) {}
+    ~ProtoScope() { _message->Clear(); }
+    mcc::protobuf::Message* operator->() { return _message; }
+    mcc::protobuf::Message& operator*() { return *_message; }
+
+private:
+    static mcc::protobuf::Message& instance()
+    {
+        static thread_local mcc::protobuf::Message message;
+        return message;
+    }
+
+    mcc::protobuf::Message* _message;
+};
+
+#endif
+
+}
+
 MessagePtr Message::deserialize(const void* ptr, std::size_t size)
 {
-    mcc::protobuf::Message msg;
-    if (!msg.ParseFromArray(ptr, size))
+    ProtoScope msg;
+    if (!msg->ParseFromArray(ptr, size))
     {
         return nullptr;
     }
 
     MessagePtr p;
-    switch (msg.body().body_case())
+    const auto& body = msg->body();
+    switch (body.body_case())
     {
-    case mcc::protobuf::MessageBody::kCmd: p = Cmd::deserialize(msg.body()._cmd()); break;
-    case mcc::protobuf::MessageBody::kTmParamList: p = TmParamList::deserialize(msg.body()._tmparamlist()); break;
+    case mcc::protobuf::MessageBody::kError: p = Error::deserialize(body._error()); break;
+    case mcc::protobuf::MessageBody::kSystemState: p = SystemState::deserialize(body._systemstate()); break;
+    case mcc::protobuf::MessageBody::kSystemStateRequest: p = SystemState_Request::deserialize(body._systemstate_request()); break;
+    case mcc::protobuf::MessageBody::kSystemComponentState: p = SystemComponentState::deserialize(body._systemcomponentstate()); break;
+    case mcc::protobuf::MessageBody::kSystemComponentStateRequest: p = SystemComponentState_Request::deserialize(body._systemcomponentstate_request()); break;
+    case mcc::protobuf::MessageBody::kSystemQueueStats: p = SystemQueueStats::deserialize(body._systemqueuestats()); break;
+
+    case mcc::protobuf::MessageBody::kCmd: p = Cmd::deserialize(body._cmd()); break;
+    case mcc::protobuf::MessageBody::kCmdCancel: p = CmdCancel::deserialize(body._cmdcancel()); break;
+    case mcc::protobuf::MessageBody::kCmdState: p = CmdState::deserialize(body._cmdstate()); break;
+    case mcc::protobuf::MessageBody::kCmdSubscribeRequest: p = CmdSubscribe_Request::deserialize(body._cmdsubscribe_request()); break;
+    case mcc::protobuf::MessageBody::kCmdSubscribeResponse: p = CmdSubscribe_Response::deserialize(body._cmdsubscribe_response()); break;
+    case mcc::protobuf::MessageBody::kCmdUnSubscribeRequest: p = CmdSubscribe_Request::deserialize(body._cmdunsubscribe_request()); break;
+    case mcc::protobuf::MessageBody::kCmdUnSubscribeResponse: p = CmdSubscribe_Response::deserialize(body._cmdunsubscribe_response()); break;
+
+    case mcc::protobuf::MessageBody::kDeviceActivateRequest: p = DeviceActivate_Request::deserialize(body._deviceactivate_request()); break;
+    case mcc::protobuf::MessageBody::kDeviceActivateResponse: p = DeviceActivate_Response::deserialize(body._deviceactivate_response()); break;
+    case mcc::protobuf::MessageBody::kDeviceConnectRequest: p = DeviceConnect_Request::deserialize(body._deviceconnect_request()); break;
+    case mcc::protobuf::MessageBody::kDeviceConnectResponse: p = DeviceConnect_Response::deserialize(body._deviceconnect_response()); break;
+    case mcc::protobuf::MessageBody::kDeviceDisconnectRequest: p = DeviceDisconnect_Request::deserialize(body._devicedisconnect_request()); break;
+    case mcc::protobuf::MessageBody::kDeviceDisconnectResponse: p = DeviceDisconnect_Response::deserialize(body._devicedisconnect_response()); break;
+    case mcc::protobuf::MessageBody::kDeviceUnRegisterRequest: p = DeviceUnRegister_Request::deserialize(body._deviceunregister_request()); break;
+    case mcc::protobuf::MessageBody::kDeviceUnRegisterResponse: p = DeviceUnRegister_Response::deserialize(body._deviceunregister_response()); break;
+    case mcc::protobuf::MessageBody::kDeviceRegistered: p = DeviceRegistered::deserialize(body._device_registered()); break;
+    case mcc::protobuf::MessageBody::kDeviceUnRegistered: p = DeviceUnRegistered::deserialize(body._device_unregistered()); break;
+    case mcc::protobuf::MessageBody::kDeviceListRequest: p = DeviceList_Request::deserialize(body._devicelist_request()); break;
+    case mcc::protobuf::MessageBody::kDeviceListResponse: p = DeviceList_Response::deserialize(body._devicelist_response()); break;
+    case mcc::protobuf::MessageBody::kDeviceDescriptionRequest: p = DeviceDescription_Request::deserialize(body._devicedescription_request()); break;
+    case mcc::protobuf::MessageBody::kDeviceFileLoadRequest: p = DeviceFileLoad_Request::deserialize(body._devicefileload_request()); break;
+    case mcc::protobuf::MessageBody::kDeviceFileLoadCancelRequest: p = DeviceFileLoadCancel_Request::deserialize(body._devicefileloadcancel_request()); break;
+    case mcc::protobuf::MessageBody::kDeviceFileLoadResponse: p = DeviceFileLoad_Response::deserialize(body._devicefileload_response()); break;
+
+    case mcc::protobuf::MessageBody::kTmParamList: p = TmParamList::deserialize(body._tmparamlist()); break;
+    case mcc::protobuf::MessageBody::kTmParamSubscribeRequest: p = TmParamSubscribe_Request::deserialize(body._tmparamsubscribe_request()); break;
+    case mcc::protobuf::MessageBody::kTmParamSubscribeResponse: p = TmParamSubscribe_Response::deserialize(body._tmparamsubscribe_response()); break;
+    case mcc::protobuf::MessageBody::kTmParamUnSubscribeRequest: p = TmParamSubscribe_Request::deserialize(body._tmparamunsubscribe_request()); break;
+    case mcc::protobuf::MessageBody::kTmParamUnSubscribeResponse: p = TmParamSubscribe_Response::deserialize(body._tmparamunsubscribe_response()); break;
+    case mcc::protobuf::MessageBody::kTmSnapshotRequest: p = TmSnapshot_Request::deserialize(body._tmsnapshot_request()); break;
+    case mcc::protobuf::MessageBody::kTmSnapshotResponse: p = TmSnapshot_Response::deserialize(body._tmsnapshot_response()); break;
+    case mcc::protobuf::MessageBody::kTmHistoryRequest: p = TmHistory_Request::deserialize(body._tmhistory_request()); break;
+    case mcc::protobuf::MessageBody::kTmHistoryResponse: p = TmHistory_Response::deserialize(body._tmhistory_response()); break;
+    case mcc::protobuf::MessageBody::kTmReplayRequest: p = TmReplay_Request::deserialize(body._tmreplay_request()); break;
+    case mcc::protobuf::MessageBody::kTmReplayResponse: p = TmReplay_Response::deserialize(body._tmreplay_response()); break;
+
+    case mcc::protobuf::MessageBody::kProtocolListRequest: p = ProtocolList_Request::deserialize(body._protocollist_request()); break;
+    case mcc::protobuf::MessageBody::kProtocolListResponse: p = ProtocolList_Response::deserialize(body._protocollist_response()); break;
+    case mcc::protobuf::MessageBody::kProtocolDescriptionRequest: p = ProtocolDescription_Request::deserialize(body._protocoldescription_request()); break;
+
+    case mcc::protobuf::MessageBody::kFirmwareListRequest: p = FirmwareList_Request::deserialize(body._firmwarelist_request()); break;
+    case mcc::protobuf::MessageBody::kFirmwareListResponse: p = FirmwareList_Response::deserialize(body._firmwarelist_response()); break;
+    case mcc::protobuf::MessageBody::kFirmwareDescriptionRequest: p = FirmwareDescription_Request::deserialize(body._firmwaredescription_request()); break;
     default:
         assert(false);
         return nullptr;
     }
+    if (!p)
+        return nullptr;
 
-    p->_id = msg.header().id();
-    p->_receiver = msg.header().receiver();
-    p->_sender = msg.header().sender();
-    p->_time = msg.header().time();
-    if (msg.header().has_requestid())
-        p->_requestId = msg.header().requestid();
+    const auto& header = msg->header();
+    p->_id = header.id();
+    p->_receiver = mcc::misc::NameTable::intern(header.receiver());
+    p->_sender = mcc::misc::NameTable::intern(header.sender());
+    if (header.has_timestamp())
+        p->_time = header.timestamp();
+    else
+        p->_time = mcc::misc::parseTimestamp(header.time());
+    if (header.has_requestid())
+        p->_requestId = header.requestid();
+    else
+        p->_requestId = bmcl::None;
 
     return p;
 }
 
+//должно совпадать с разбором в deserialize
+bool Message::isSerializable(MessageType type)
+{
+    switch (type)
+    {
+    case MessageType::Error:
+    case MessageType::SystemState:
+    case MessageType::SystemState_Request:
+    case MessageType::SystemComponentState:
+    case MessageType::SystemComponentState_Request:
+    case MessageType::SystemQueueStats:
+    case MessageType::Cmd:
+    case MessageType::CmdCancel:
+    case MessageType::CmdState:
+    case MessageType::CmdSubscribe_Request:
+    case MessageType::CmdSubscribe_Response:
+    case MessageType::DeviceActivate_Request:
+    case MessageType::DeviceActivate_Response:
+    case MessageType::DeviceConnect_Request:
+    case MessageType::DeviceConnect_Response:
+    case MessageType::DeviceDisconnect_Request:
+    case MessageType::DeviceDisconnect_Response:
+    case MessageType::DeviceUnRegister_Request:
+    case MessageType::DeviceUnRegister_Response:
+    case MessageType::DeviceRegistered:
+    case MessageType::DeviceUnRegistered:
+    case MessageType::DeviceList_Request:
+    case MessageType::DeviceList_Response:
+    case MessageType::DeviceDescription_Request:
+    case MessageType::DeviceFileLoad_Request:
+    case MessageType::DeviceFileLoadCancel_Request:
+    case MessageType::DeviceFileLoad_Response:
+    case MessageType::TmParamList:
+    case MessageType::TmParamSubscribe_Request:
+    case MessageType::TmParamSubscribe_Response:
+    case MessageType::TmSnapshot_Request:
+    case MessageType::TmSnapshot_Response:
+    case MessageType::TmHistory_Request:
+    case MessageType::TmHistory_Response:
+    case MessageType::TmReplay_Request:
+    case MessageType::TmReplay_Response:
+    case MessageType::ProtocolList_Request:
+    case MessageType::ProtocolList_Response:
+    case MessageType::ProtocolDescription_Request:
+    case MessageType::FirmwareList_Request:
+    case MessageType::FirmwareList_Response:
+    case MessageType::FirmwareDescription_Request:
+        return true;
+    default:
+        return false;
+    }
+}
+
 std::vector<uint8_t> Message::serialize() const
 {
-    mcc::protobuf::Message msg;
-    serialize_(msg.mutable_body());
+    std::vector<uint8_t> buffer;
+    serialize(&buffer);
+    return buffer;
+}
+
+void Message::serialize(std::vector<uint8_t>* buffer) const
+{
+    ProtoScope msg;
+    serialize_(msg->mutable_body());
 
-    auto header = msg.mutable_header();
+    auto header = msg->mutable_header();
     header->set_id(message_id());
     header->set_receiver(receiver());
     header->set_sender(sender());
-    header->set_body(msg.body().body_case());
-    header->set_time(time());
+    header->set_body(msg->body().body_case());
+    header->set_timestamp(time());
+    //у собранных со старой схемой участников time - required: без него они отбрасывают весь кадр.
+    //Писать, пока такие участники не обновлены
+    header->set_time(mcc::misc::formatTimestamp(time()));
     if (requestId().isSome())
         header->set_requestid(*requestId());
 
-    std::vector<uint8_t> buffer;
-    buffer.resize(msg.ByteSize());
-    msg.SerializeToArray(buffer.data(), buffer.size());
-    return buffer;
+    buffer->resize(msg->ByteSize());
+    msg->SerializeWithCachedSizesToArray(buffer->data());
 }
 
 void Message::serialize_(mcc::protobuf::MessageBody* body) const
@@ -69,18 +253,50 @@ void Message::serialize_(mcc::protobuf::MessageBody* body) const
 
 MESSAGE_REQUEREMENT_DEFINITIONS(Error);
 
+void Error::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto error = body->mutable__error();
+    error->set_messageid(requestId().unwrapOr(0));
+    error->set_description(_error);
+}
+
+std::unique_ptr<Message> Error::deserialize(const mcc::protobuf::Error& body)
+{
+    return mcc::misc::makeUnique<Error>(nullptr, body.description());
+}
+
 MessageProcessor::MessageProcessor(const MessageSender& sender) : _sender(sender)
 {
 }
 
 void MessageProcessor::chooseProcessor(MessagePtr&& message, MessageProcessor* processor)
 {
-    message->process(processor, std::move(message));
+    processor->chooseProcessor(std::move(message));
 }
 
 void MessageProcessor::chooseProcessor(MessagePtr&& message)
 {
-    message->process(this, std::move(message));
+    if (!_hasHandlers)
+    {
+        message->process(this, std::move(message));
+        return;
+    }
+    Handler handler = _handlers[(std::size_t)message->message_type()];
+    if (handler)
+        handler(this, std::move(message));
+    else
+        _unhandled++;
+}
+
+std::bitset<messageTypeCount> MessageProcessor::handledTypes() const
+{
+    std::bitset<messageTypeCount> types;
+    for (std::size_t i = 0; i < messageTypeCount; i++)
+    {
+        if (_handlers[i])
+            types.set(i);
+    }
+    return types;
 }
 
 void MessageProcessor::not_implemented_(std::unique_ptr<Message>&& msg)
@@ -93,6 +309,8 @@ void MessageProcessor::process(std::unique_ptr<SystemState>&& msg){ not_implemen
 void MessageProcessor::process(std::unique_ptr<SystemState_Request>&& msg){ not_implemented_(Message::to_base(msg)); }
 void MessageProcessor::process(std::unique_ptr<SystemComponentState>&& msg){ not_implemented_(Message::to_base(msg)); }
 void MessageProcessor::process(std::unique_ptr<SystemComponentState_Request>&& msg){ not_implemented_(Message::to_base(msg)); }
+void MessageProcessor::process(std::unique_ptr<SystemComponentTrace>&& msg){ not_implemented_(Message::to_base(msg)); }
+void MessageProcessor::process(std::unique_ptr<SystemQueueStats>&& msg){ not_implemented_(Message::to_base(msg)); }
 
 void MessageProcessor::process(std::unique_ptr<Cmd>&& msg){ not_implemented_(Message::to_base(msg)); }
 void MessageProcessor::process(std::unique_ptr<CmdCancel>&& msg){ not_implemented_(Message::to_base(msg)); }
@@ -140,6 +358,12 @@ void MessageProcessor::process(std::unique_ptr<ChannelState_Response>&& msg){ no
 void MessageProcessor::process(std::unique_ptr<TmParamSubscribe_Request>&& msg){ not_implemented_(Message::to_base(msg)); }
 void MessageProcessor::process(std::unique_ptr<TmParamSubscribe_Response>&& msg){ not_implemented_(Message::to_base(msg)); }
 void MessageProcessor::process(std::unique_ptr<TmParamList>&& msg){ not_implemented_(Message::to_base(msg)); }
+void MessageProcessor::process(std::unique_ptr<TmSnapshot_Request>&& msg){ not_implemented_(Message::to_base(msg)); }
+void MessageProcessor::process(std::unique_ptr<TmSnapshot_Response>&& msg){ not_implemented_(Message::to_base(msg)); }
+void MessageProcessor::process(std::unique_ptr<TmHistory_Request>&& msg){ not_implemented_(Message::to_base(msg)); }
+void MessageProcessor::process(std::unique_ptr<TmHistory_Response>&& msg){ not_implemented_(Message::to_base(msg)); }
+void MessageProcessor::process(std::unique_ptr<TmReplay_Request>&& msg){ not_implemented_(Message::to_base(msg)); }
+void MessageProcessor::process(std::unique_ptr<TmReplay_Response>&& msg){ not_implemented_(Message::to_base(msg)); }
 
 void MessageProcessor::process(std::unique_ptr<ProtocolList_Request>&& msg){ not_implemented_(Message::to_base(msg)); }
 void MessageProcessor::process(std::unique_ptr<ProtocolList_Response>&& msg){ not_implemented_(Message::to_base(msg)); }
@@ -7,14 +7,17 @@
 #include <memory>
 #include <vector>
 #include <atomic>
+#include <bitset>
 #include "bmcl/Option.h"
 #include "mcc/Names.h"
 #include "mcc/misc/Helpers.h"
+#include "mcc/misc/NameTable.h"
+#include "mcc/misc/TimeUtils.h"
 #include "mcc/messages/Deaclarations.h"
 
 namespace mcc { namespace core { namespace router { class Service; } } }
 
-namespace mcc { namespace protobuf { class MessageBody; } }
+namespace mcc { namespace protobuf { class MessageBody; class Error; } }
 
 namespace mcc {
 namespace messages {
@@ -27,32 +30,46 @@ class Message
 public:
     Message() = default;
     Message(const Message&) = default;
-    Message(const std::string& to) : _receiver(to){}
-    Message(const std::string& to, MessageId requestId) : _receiver(to), _requestId(requestId){}
+    Message(const std::string& to) : _receiver(mcc::misc::NameTable::intern(to)){}
+    Message(mcc::misc::NameId to, MessageId requestId) : _receiver(to), _requestId(requestId){}
     virtual ~Message(){}
-    const std::string& sender() const { return _sender; }
-    const std::string& receiver() const { return _receiver; }
-    const std::string& time() const { return _time; }
+    //отправитель и получатель хранятся как id из NameTable, строки - для логов и сериализации
+    const std::string& sender() const { return mcc::misc::NameTable::name(_sender); }
+    const std::string& receiver() const { return mcc::misc::NameTable::name(_receiver); }
+    mcc::misc::NameId senderId() const { return _sender; }
+    mcc::misc::NameId receiverId() const { return _receiver; }
+    //время отправки, для показа - mcc::misc::formatTimestamp/toDateTime
+    mcc::misc::Timestamp time() const { return _time; }
     MessageId message_id() const { return _id; }
     bmcl::Option<MessageId> requestId() const { return _requestId; }
     static std::unique_ptr<Message> deserialize(const void* ptr, std::size_t size);
+    //только такие сообщения переживают serialize()/deserialize() (например, между процессами)
+    static bool isSerializable(MessageType type);
     template<class T>
     static std::unique_ptr<Message> to_base(T&& msg) { return std::unique_ptr<Message>((Message*)msg.release()); }
 
     virtual const std::string& message_name() const = 0;
+    virtual MessageType message_type() const = 0;
     virtual void process(MessageProcessor* processor, std::unique_ptr<Message>&& message) = 0;
     virtual std::unique_ptr<Message> clone() const = 0;
+    //объединить с более новым сообщением, которое не помещается в очередь получателя;
+    //true - newer можно отбросить
+    virtual bool coalesce(const Message& newer) { (void)newer; return false; }
     std::vector<uint8_t> serialize() const;
+    //в buffer с переиспользованием его ёмкости, для частой отправки
+    void serialize(std::vector<uint8_t>* buffer) const;
 
 protected:
     virtual void serialize_(mcc::protobuf::MessageBody* body) const;
+    //для coalesce(): объединённое сообщение несёт время более нового
+    void setTime_(mcc::misc::Timestamp time) { _time = time; }
 
 private:
 
-    MessageId   _id;
-    std::string _sender;
-    std::string _receiver;
-    std::string _time;
+    MessageId   _id = 0;
+    mcc::misc::NameId _sender = mcc::misc::NameTable::emptyId;
+    mcc::misc::NameId _receiver = mcc::misc::NameTable::emptyId;
+    mcc::misc::Timestamp _time = 0;
     bmcl::Option<MessageId> _requestId;
 };
 typedef std::unique_ptr<Message> MessagePtr;
@@ -67,13 +84,14 @@ public:
 class Response : public Message
 {
 public:
-    Response(const Message* request) : Message(request->sender(), request->message_id()){}
+    Response(const Message* request) : Message(request->senderId(), request->message_id()){}
     virtual ~Response(){}
 };
 
 
 #define MESSAGE_REQUIREMENTS_DECLARATIONS() \
     const std::string& message_name() const override { return _message_name; } \
+    MessageType message_type() const override; \
     void process(MessageProcessor* processor, std::unique_ptr<Message>&& message) override; \
     std::unique_ptr<Message> clone() const override;    \
     static const std::string _message_name;
@@ -81,6 +99,7 @@ public:
 #define MESSAGE_REQUEREMENT_DEFINITIONS(TypeName) \
     void TypeName::process(MessageProcessor* processor, std::unique_ptr<Message>&& message){ processor->process(std::unique_ptr<TypeName>(static_cast<TypeName*>(message.release()))); } \
     std::unique_ptr<Message> TypeName::clone() const { return std::unique_ptr<Message>(new TypeName(*this)); } \
+    MessageType TypeName::message_type() const { return MessageTypeOf<TypeName>::value; } \
     const std::string TypeName::_message_name = #TypeName;
 
 
@@ -90,26 +109,55 @@ public:
     Error(const Message* msg, const std::string& error) :_error(error){ (void)msg;  (void)_error; }
     virtual ~Error(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::Error& body);
     const std::string& error() const { return _error; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _error;
 };
 
+//обработчик может зарегистрировать нужные ему типы через handle<T>(), тогда сообщение
+//находит свой process() по таблице MessageType, а сообщения остальных типов отбрасываются
+//без разбора и считаются в unhandledCount(); без регистрации работает как раньше через
+//Message::process и not_implemented_
 class MessageProcessor
 {
 private:
+    typedef void (*Handler)(MessageProcessor*, MessagePtr&&);
+    template<class T>
+    static void dispatch_(MessageProcessor* processor, MessagePtr&& message)
+    {
+        processor->process(std::unique_ptr<T>(static_cast<T*>(message.release())));
+    }
     void not_implemented_(std::unique_ptr<Message>&&);
     MessageSender _sender;
+    Handler _handlers[messageTypeCount] = {};
+    bool _hasHandlers = false;
+    std::size_t _unhandled = 0;
+protected:
+    template<class T>
+    void handle()
+    {
+        _handlers[(std::size_t)MessageTypeOf<T>::value] = &MessageProcessor::dispatch_<T>;
+        _hasHandlers = true;
+    }
 public :
     MessageProcessor(const MessageSender& sender);
     static void chooseProcessor(MessagePtr&&, MessageProcessor* processor);
     void chooseProcessor(MessagePtr&&);
+    bool hasHandlers() const { return _hasHandlers; }
+    std::bitset<messageTypeCount> handledTypes() const;
+    std::size_t unhandledCount() const { return _unhandled; }
 
     virtual void process(std::unique_ptr<Error>&&);
     virtual void process(std::unique_ptr<SystemState>&&);
     virtual void process(std::unique_ptr<SystemState_Request>&&);
     virtual void process(std::unique_ptr<SystemComponentState>&&);
     virtual void process(std::unique_ptr<SystemComponentState_Request>&&);
+    virtual void process(std::unique_ptr<SystemComponentTrace>&&);
+    virtual void process(std::unique_ptr<SystemQueueStats>&&);
 
     virtual void process(std::unique_ptr<Cmd>&&);
     virtual void process(std::unique_ptr<CmdCancel>&&);
@@ -157,6 +205,12 @@ public :
     virtual void process(std::unique_ptr<TmParamSubscribe_Request>&&);
     virtual void process(std::unique_ptr<TmParamSubscribe_Response>&&);
     virtual void process(std::unique_ptr<TmParamList>&&);
+    virtual void process(std::unique_ptr<TmSnapshot_Request>&&);
+    virtual void process(std::unique_ptr<TmSnapshot_Response>&&);
+    virtual void process(std::unique_ptr<TmHistory_Request>&&);
+    virtual void process(std::unique_ptr<TmHistory_Response>&&);
+    virtual void process(std::unique_ptr<TmReplay_Request>&&);
+    virtual void process(std::unique_ptr<TmReplay_Response>&&);
 
     virtual void process(std::unique_ptr<ProtocolList_Request>&&);
     virtual void process(std::unique_ptr<ProtocolList_Response>&&);
@@ -15,27 +15,50 @@ namespace messages {
 
 std::atomic<MessageId> MessageSenderX::_counter(0);
 
-MessageSenderX::MessageSenderX(const std::string& name, const MessageQueue& queue) :_name(name), _queue(queue)
+MessageSenderX::MessageSenderX(const std::string& name, const MessageQueue& queue) : MessageSenderX(name, queue, nullptr)
 {
 }
 
+MessageSenderX::MessageSenderX(const std::string& name, const MessageQueue& queue, const LocalRouter* router) :_name(mcc::misc::NameTable::intern(name)), _queue(queue), _router(router)
+{
+#ifdef MCC_TRACING
+    _trace = Tracer::service(name);
+#endif
+}
+
 MessageId MessageSenderX::send(MessagePtr&& message)
 {
     message->_sender = _name;
-    if (message->receiver().empty())
+    if (message->receiverId() == mcc::misc::NameTable::emptyId)
     {
         qDebug() << QString::fromStdString(message->message_name()) << QString::fromStdString(message->sender()) << "->" << QString::fromStdString(message->receiver());
     }
-    assert(!message->receiver().empty());
+    assert(message->receiverId() != mcc::misc::NameTable::emptyId);
 
     auto id = _counter.fetch_add(1);
     message->_id = id;
-    message->_time = mcc::misc::currentDateTime();
+    message->_time = mcc::misc::currentTimestamp();
+#ifdef MCC_TRACING
+    _trace->sent(message->message_type());
+#endif
+
+    auto destination = _router ? _router->destination(message->receiverId()) : nullptr;
+    if (destination)
+    {
+        _router->deliver(destination, std::move(message));
+        return id;
+    }
     _queue->send(std::move(message));
     return id;
 }
 
 MessageId MessageSenderX::sendTo(const std::string& to, MessagePtr&& message)
+{
+    message->_receiver = mcc::misc::NameTable::intern(to);
+    return send(std::move(message));
+}
+
+MessageId MessageSenderX::sendTo(mcc::misc::NameId to, MessagePtr&& message)
 {
     message->_receiver = to;
     return send(std::move(message));
@@ -8,15 +8,20 @@
 #include "bmcl/Option.h"
 #include "mcc/misc/Helpers.h"
 #include "mcc/messages/Deaclarations.h"
+#include "mcc/messages/LocalRouter.h"
+#include "mcc/messages/Trace.h"
 
 namespace mcc {
 namespace messages {
 
 
+//если задан router, сообщения локальным получателям ставятся прямо в их очереди,
+//через очередь queue (поток роутера) идут только multicast и неизвестные получатели
 class MessageSenderX
 {
 public:
     MessageSenderX(const std::string& name, const MessageQueue& queue);
+    MessageSenderX(const std::string& name, const MessageQueue& queue, const LocalRouter* router);
 
     template<class T>
     MessageId send(std::unique_ptr<T>&& message);
@@ -29,6 +34,9 @@ public:
     template<typename T, typename... A>
     MessageId sendTo(const std::string& to, A&&... args);
     MessageId sendTo(const std::string& to, MessagePtr&& message);
+    template<class T>
+    MessageId sendTo(mcc::misc::NameId to, std::unique_ptr<T>&& message);
+    MessageId sendTo(mcc::misc::NameId to, MessagePtr&& message);
 
     template<class T>
     MessageId respond(std::unique_ptr<T>&& message);
@@ -37,8 +45,10 @@ public:
 
 private:
     static std::atomic<MessageId> _counter;
-    std::string _name;
+    mcc::misc::NameId _name;
     MessageQueue _queue;
+    const LocalRouter* _router;
+    ServiceTracePtr _trace; //только при MCC_TRACING
 };
 
 template<class T>
@@ -65,6 +75,15 @@ MessageId MessageSenderX::sendTo(const std::string& to, std::unique_ptr<T>&& mes
     return sendTo(to, std::move(p));
 }
 
+template<class T>
+MessageId MessageSenderX::sendTo(mcc::misc::NameId to, std::unique_ptr<T>&& message)
+{
+    static_assert(std::is_base_of<Message, T>::value, "only messages can be passed on");
+    MessagePtr p;
+    p.reset(static_cast<Message*>(message.release()));
+    return sendTo(to, std::move(p));
+}
+
 template<typename T, typename... A>
 MessageId MessageSenderX::sendTo(const std::string& to, A&&... args)
 {
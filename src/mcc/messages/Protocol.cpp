@@ -3,6 +3,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "mcc/messages/Protocol.h"
+#include "mcc/messages/protobuf/Message.pb.h"
 
 namespace mcc {
 namespace messages {
@@ -16,6 +17,38 @@ MESSAGE_REQUEREMENT_DEFINITIONS(ProtocolForDevice_Response);
 MESSAGE_REQUEREMENT_DEFINITIONS(ProtocolForDeviceRegister_Request);
 MESSAGE_REQUEREMENT_DEFINITIONS(ProtocolForDeviceRegister_Response);
 
+void ProtocolList_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    body->mutable__protocollist_request();
 }
+
+std::unique_ptr<Message> ProtocolList_Request::deserialize(const mcc::protobuf::ProtocolList_Request&)
+{
+    return mcc::misc::makeUnique<ProtocolList_Request>();
+}
+
+void ProtocolList_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto response = body->mutable__protocollist_response();
+    for (const auto& i : _protocols)
+        response->add_protocols(i);
 }
 
+std::unique_ptr<Message> ProtocolList_Response::deserialize(const mcc::protobuf::ProtocolList_Response& body)
+{
+    ProtocolList_Request request;
+    return mcc::misc::makeUnique<ProtocolList_Response>(&request, std::vector<std::string>(body.protocols().begin(), body.protocols().end()));
+}
+
+void ProtocolDescription_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    body->mutable__protocoldescription_request()->set_protocol(_protocol);
+}
+
+std::unique_ptr<Message> ProtocolDescription_Request::deserialize(const mcc::protobuf::ProtocolDescription_Request& body)
+{
+    return mcc::misc::makeUnique<ProtocolDescription_Request>(body.protocol());
+}
+
+}
+}
@@ -7,6 +7,8 @@
 #include "mcc/messages/Message.h"
 #include "mcc/misc/Protocol.h"
 
+namespace mcc { namespace protobuf { class ProtocolList_Request; class ProtocolList_Response; class ProtocolDescription_Request; } }
+
 
 namespace mcc {
 namespace messages {
@@ -17,6 +19,10 @@ public:
     ProtocolList_Request() : MessageTo(mcc::Names::coreDb()){}
     virtual ~ProtocolList_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::ProtocolList_Request& body);
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
 };
 
@@ -33,7 +39,11 @@ public:
     }
     virtual ~ProtocolList_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::ProtocolList_Response& body);
     const std::vector<std::string>& protocols()  const { return _protocols; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::vector<std::string> _protocols;
 };
@@ -46,7 +56,11 @@ public:
     }
     virtual ~ProtocolDescription_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::ProtocolDescription_Request& body);
     const std::string& protocol() const { return _protocol; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     std::string _protocol;
 };
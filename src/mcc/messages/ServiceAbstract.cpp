@@ -21,6 +21,15 @@ ServiceAbstract::~ServiceAbstract()
 
 bool ServiceAbstract::pre()
 {
+    if (_in && isCooperative_())
+        _in->setWaker(waker_());
+    if (hasHandlers())
+    {
+        //SystemState нужен waitSystemStarted_ даже тем, кто его не обрабатывает
+        auto types = handledTypes();
+        types.set((std::size_t)MessageType::SystemState);
+        _router->setAccepted(name(), types);
+    }
     if (_out)
     {
         _out->send<mcc::messages::SystemComponentState>(true);
@@ -36,14 +45,53 @@ void ServiceAbstract::tick()
         assert(false);
         return;
     }
-    auto m = _in->tryRecvFor(std::chrono::milliseconds(100));
-    if (m.isErr())
+    // one lock and one wakeup per batch instead of per message
+    std::size_t count;
+    if (isCooperative_())
+        count = _in->recvAll(&_batch, _batchSize);
+    else
+        count = _in->recvAllFor(&_batch, _batchSize, _recvTimeout);
+
+    handleBatch_();
+
+    // leave the rest for the next tick so that other tasks get the worker
+    if (isCooperative_() && count == _batchSize)
+        wakeup_();
+}
+
+void ServiceAbstract::handleBatch_()
+{
+#ifdef MCC_TRACING
+    reportTrace_();
+    for (auto& m : _batch)
+    {
+        auto start = mcc::misc::currentTimestamp();
+        _trace->received(m->message_type(), m->time(), start);
+        chooseProcessor(std::move(m));
+        _trace->handled(start, mcc::misc::currentTimestamp());
+    }
+#else
+    for (auto& m : _batch)
+        chooseProcessor(std::move(m));
+#endif
+    _batch.clear();
+}
+
+#ifdef MCC_TRACING
+void ServiceAbstract::reportTrace_()
+{
+    auto now = mcc::misc::currentTimestamp();
+    if (!_trace || !_out || now - _traceReported < Tracer::reportPeriod)
         return;
-    chooseProcessor(m.take());
+    _traceReported = now;
+    _out->send<mcc::messages::SystemComponentTrace>(_trace->stats());
 }
+#endif
 
 void ServiceAbstract::post()
 {
+    if (_in && isCooperative_())
+        _in->setWaker(nullptr);
     if (_out)
         _out->send<mcc::messages::SystemComponentState>(false);
     if (_in)
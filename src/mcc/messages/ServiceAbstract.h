@@ -3,13 +3,16 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <chrono>
 #include <memory>
 #include <string>
+#include <vector>
 #include "mcc/misc/Net.h"
 #include "mcc/misc/Runnable.h"
 #include "mcc/messages/Deaclarations.h"
 #include "mcc/messages/Message.h"
 #include "mcc/messages/LocalRouter.h"
+#include "mcc/messages/Trace.h"
 
 
 namespace mcc {
@@ -25,6 +28,9 @@ public:
         , _in(router->recv(name))
         , _out(router->send(name))
     {
+#ifdef MCC_TRACING
+        _trace = Tracer::service(name);
+#endif
     }
     virtual ~ServiceAbstract();
 
@@ -37,9 +43,21 @@ protected:
     mcc::messages::MessageQueue _in;
     mcc::messages::MessageSender _out;
     mcc::messages::LocalRouterPtr _router;
+    const std::size_t _batchSize = 64;
+    //сколько tick() ждёт сообщений в собственном потоке
+    std::chrono::microseconds _recvTimeout = std::chrono::milliseconds(100);
+    std::vector<mcc::messages::MessagePtr> _batch;
 
 private:
     void run();
+    void handleBatch_();
+
+#ifdef MCC_TRACING
+    void reportTrace_();
+
+    ServiceTracePtr _trace;
+    mcc::misc::Timestamp _traceReported = 0;
+#endif
 };
 }
 }
\ No newline at end of file
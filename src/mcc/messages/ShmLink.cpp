@@ -0,0 +1,61 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <vector>
+#include "mcc/messages/ShmLink.h"
+#include "mcc/messages/Message.h"
+
+
+namespace mcc {
+namespace messages {
+
+ShmLink::ShmLink(const LocalRouterPtr& router, const mcc::misc::ShmRingPtr& in)
+    : _router(router)
+    , _in(in)
+    , _isRunning(true)
+    , _isFailed(false)
+    , _received(0)
+    , _broken(0)
+{
+    _thread = std::thread(&ShmLink::run, this);
+}
+
+ShmLink::~ShmLink()
+{
+    stop();
+}
+
+void ShmLink::stop()
+{
+    _isRunning = false;
+    if (_thread.joinable())
+        _thread.join();
+}
+
+void ShmLink::run()
+{
+    //readFor сам переходит от опроса к коротким паузам, таймаут - только для проверки stop()
+    std::vector<uint8_t> frame;
+    while (_isRunning)
+    {
+        if (!_in->readFor(&frame, std::chrono::milliseconds(100)))
+        {
+            if (!_in->isBroken())
+                continue;
+            _isFailed = true;
+            return;
+        }
+        auto message = Message::deserialize(frame.data(), frame.size());
+        if (!message)
+        {
+            _broken++;
+            continue;
+        }
+        _received++;
+        _router->route(std::move(message));
+    }
+}
+
+}
+}
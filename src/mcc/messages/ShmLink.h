@@ -0,0 +1,46 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include "mcc/messages/LocalRouter.h"
+#include "mcc/misc/ShmRing.h"
+
+namespace mcc {
+namespace messages {
+
+//входящая сторона связи между процессами: читает кадры из ring, в которую пишет
+//LocalRouter другого процесса (addRemote), и раздаёт сообщения через свой router.
+//Для двусторонней связи нужны два ring: в каждом процессе addRemote для чужих сервисов
+//с исходящим ring и ShmLink на входящем.
+class ShmLink
+{
+public:
+    ShmLink(const LocalRouterPtr& router, const mcc::misc::ShmRingPtr& in);
+    ~ShmLink();
+    void stop();
+
+    std::size_t received() const { return _received; }
+    std::size_t broken() const { return _broken; }
+    //другая сторона испортила ring (упала посреди записи): чтение остановлено, нужен новый ring
+    bool isFailed() const { return _isFailed; }
+
+private:
+    void run();
+
+    LocalRouterPtr _router;
+    mcc::misc::ShmRingPtr _in;
+    std::atomic<bool> _isRunning;
+    std::atomic<bool> _isFailed;
+    std::atomic<std::size_t> _received;
+    std::atomic<std::size_t> _broken;
+    std::thread _thread;
+};
+typedef std::unique_ptr<ShmLink> ShmLinkPtr;
+
+}
+}
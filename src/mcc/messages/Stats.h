@@ -3,7 +3,9 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 #include "mcc/misc/TimeUtils.h"
 
@@ -17,17 +19,17 @@ struct Stat
     {
         _packets = 0;
         _bytes = 0;
-        _time = mcc::misc::currentDateTime();
+        _time = mcc::misc::currentTimestamp();
     }
     void add(std::size_t bytes, bool isPacket = true)
     {
         _bytes += bytes;
         if (isPacket) _packets += 1;
-        _time = mcc::misc::currentDateTime();
+        _time = mcc::misc::currentTimestamp();
     }
     std::size_t _packets;
     std::size_t _bytes;
-    std::string _time;
+    mcc::misc::Timestamp _time;
 };
 
 struct StatChannel
@@ -84,6 +86,39 @@ struct StatDevice
 };
 typedef std::vector<StatDevice> StatDevices;
 
+struct StatQueue
+{
+    std::string _name;
+    std::size_t _size = 0;
+    std::size_t _capacity = 0;
+    std::size_t _dropped = 0;
+    std::size_t _coalesced = 0;
+    std::size_t _blocked = 0;
+    std::size_t _overflowed = 0;
+    std::size_t _rejected = 0;
+};
+typedef std::vector<StatQueue> StatQueues;
+
+//задержки в наносекундах
+struct StatLatency
+{
+    std::uint64_t _count = 0;
+    std::int64_t _mean = 0;
+    std::int64_t _p50 = 0;
+    std::int64_t _p99 = 0;
+    std::int64_t _max = 0;
+};
+
+struct StatTrace
+{
+    std::string _name;
+    StatLatency _wait;   //от отправки до выборки из очереди получателя
+    StatLatency _handle; //обработка в process()
+    std::vector<std::pair<std::string, std::uint64_t>> _received; //по типам сообщений, только ненулевые
+    std::vector<std::pair<std::string, std::uint64_t>> _sent;
+};
+typedef std::vector<StatTrace> StatTraces;
+
 }
 }
 
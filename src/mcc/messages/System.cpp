@@ -3,6 +3,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include "mcc/messages/System.h"
+#include "mcc/messages/protobuf/Message.pb.h"
 
 
 namespace mcc {
@@ -12,6 +13,91 @@ MESSAGE_REQUEREMENT_DEFINITIONS(SystemState)
 MESSAGE_REQUEREMENT_DEFINITIONS(SystemState_Request)
 MESSAGE_REQUEREMENT_DEFINITIONS(SystemComponentState)
 MESSAGE_REQUEREMENT_DEFINITIONS(SystemComponentState_Request)
+MESSAGE_REQUEREMENT_DEFINITIONS(SystemComponentTrace)
+MESSAGE_REQUEREMENT_DEFINITIONS(SystemQueueStats)
+
+void SystemState_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    body->mutable__systemstate_request();
+}
+
+std::unique_ptr<Message> SystemState_Request::deserialize(const mcc::protobuf::SystemState_Request&)
+{
+    return mcc::misc::makeUnique<SystemState_Request>();
+}
+
+void SystemState::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto state = body->mutable__systemstate();
+    state->set_isstarted(_isStarted);
+    if (!_reason.empty())
+        state->set_reason(_reason);
+}
+
+std::unique_ptr<Message> SystemState::deserialize(const mcc::protobuf::SystemState& body)
+{
+    return mcc::misc::makeUnique<SystemState>(body.isstarted(), body.reason());
+}
+
+void SystemComponentState_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    body->mutable__systemcomponentstate_request();
+}
+
+std::unique_ptr<Message> SystemComponentState_Request::deserialize(const mcc::protobuf::SystemComponentState_Request&)
+{
+    return mcc::misc::makeUnique<SystemComponentState_Request>();
+}
+
+void SystemComponentState::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto state = body->mutable__systemcomponentstate();
+    state->set_isstarted(_isStarted);
+    if (!_reason.empty())
+        state->set_reason(_reason);
+}
+
+std::unique_ptr<Message> SystemComponentState::deserialize(const mcc::protobuf::SystemComponentState& body)
+{
+    return mcc::misc::makeUnique<SystemComponentState>(body.isstarted(), body.reason());
+}
+
+void SystemQueueStats::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto stats = body->mutable__systemqueuestats();
+    for (const auto& i : _queues)
+    {
+        auto q = stats->add_queues();
+        q->set_name(i._name);
+        q->set_size(i._size);
+        q->set_capacity(i._capacity);
+        q->set_dropped(i._dropped);
+        q->set_coalesced(i._coalesced);
+        q->set_blocked(i._blocked);
+        q->set_overflowed(i._overflowed);
+        q->set_rejected(i._rejected);
+    }
+}
+
+std::unique_ptr<Message> SystemQueueStats::deserialize(const mcc::protobuf::SystemQueueStats& body)
+{
+    StatQueues queues;
+    queues.reserve(body.queues().size());
+    for (const auto& i : body.queues())
+    {
+        StatQueue q;
+        q._name = i.name();
+        q._size = i.size();
+        q._capacity = i.capacity();
+        q._dropped = i.dropped();
+        q._coalesced = i.coalesced();
+        q._blocked = i.blocked();
+        q._overflowed = i.overflowed();
+        q._rejected = i.rejected();
+        queues.push_back(q);
+    }
+    return mcc::misc::makeUnique<SystemQueueStats>(std::move(queues));
+}
 
 }
 }
@@ -7,6 +7,9 @@
 #include <vector>
 #include <atomic>
 #include "mcc/messages/Message.h"
+#include "mcc/messages/Stats.h"
+
+namespace mcc { namespace protobuf { class SystemState_Request; class SystemState; class SystemComponentState_Request; class SystemComponentState; class SystemQueueStats; } }
 
 
 namespace mcc {
@@ -19,6 +22,10 @@ public:
     SystemState_Request() : MessageTo(mcc::Names::coreManager()){}
     virtual ~SystemState_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::SystemState_Request& body);
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
 };
 
@@ -29,8 +36,12 @@ public:
     SystemState(bool isStarted, const std::string& reason = std::string()) : MessageTo(mcc::Names::multicast()), _isStarted(isStarted), _reason(reason){}
     virtual ~SystemState(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::SystemState& body);
     bool isStarted() const { return _isStarted; }
     const std::string& reason() const { return _reason; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     bool _isStarted;
     std::string _reason;
@@ -41,6 +52,10 @@ class SystemComponentState_Request : public Message
 public:
     virtual ~SystemComponentState_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::SystemComponentState_Request& body);
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
 };
 
@@ -50,13 +65,44 @@ public:
     SystemComponentState(bool isStarted, const std::string& reason = std::string()) : MessageTo(mcc::Names::coreManager()), _isStarted(isStarted), _reason(reason){}
     virtual ~SystemComponentState(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::SystemComponentState& body);
     bool isStarted() const { return _isStarted; }
     const std::string& reason() const { return _reason; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     bool _isStarted;
     std::string _reason;
 };
 
+//состояние очередей роутера, отправляется менеджеру периодически и не говорит о запуске сервиса
+class SystemQueueStats : public MessageTo
+{
+public:
+    SystemQueueStats(StatQueues&& queues) : MessageTo(mcc::Names::coreManager()), _queues(std::move(queues)){}
+    virtual ~SystemQueueStats(){}
+    MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::SystemQueueStats& body);
+    const StatQueues& queues() const { return _queues; }
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
+private:
+    StatQueues _queues;
+};
+
+//задержки и счётчики сообщений сервиса, отправляются менеджеру при сборке с MCC_ENABLE_TRACING
+class SystemComponentTrace : public MessageTo
+{
+public:
+    SystemComponentTrace(StatTrace&& trace) : MessageTo(mcc::Names::coreManager()), _trace(std::move(trace)){}
+    virtual ~SystemComponentTrace(){}
+    MESSAGE_REQUIREMENTS_DECLARATIONS();
+    const StatTrace& trace() const { return _trace; }
+private:
+    StatTrace _trace;
+};
 
 }
 }
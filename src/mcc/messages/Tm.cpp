@@ -2,7 +2,9 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <algorithm>
 #include "mcc/messages/Tm.h"
+#include "mcc/messages/TmCodec.h"
 #include "mcc/messages/protobuf/Message.pb.h"
 
 
@@ -12,24 +14,136 @@ namespace messages {
 MESSAGE_REQUEREMENT_DEFINITIONS(TmParamSubscribe_Request);
 MESSAGE_REQUEREMENT_DEFINITIONS(TmParamSubscribe_Response);
 MESSAGE_REQUEREMENT_DEFINITIONS(TmParamList);
+MESSAGE_REQUEREMENT_DEFINITIONS(TmSnapshot_Request);
+MESSAGE_REQUEREMENT_DEFINITIONS(TmSnapshot_Response);
+MESSAGE_REQUEREMENT_DEFINITIONS(TmHistory_Request);
+MESSAGE_REQUEREMENT_DEFINITIONS(TmHistory_Response);
+MESSAGE_REQUEREMENT_DEFINITIONS(TmReplay_Request);
+MESSAGE_REQUEREMENT_DEFINITIONS(TmReplay_Response);
+
+const std::uint32_t TmHistory_Request::defaultMaxPoints;
+
+bool TmParamList::coalesce(const Message& newer)
+{
+    const TmParamList* list = dynamic_cast<const TmParamList*>(&newer);
+    if (!list || list->_device != _device || list->isReplay() != isReplay())
+        return false;
+
+    //параметры могут быть общими с копиями у других получателей, меняем свою копию
+    auto params = std::make_shared<TmParams>(*_params);
+    for (const auto& param : *list->_params)
+    {
+        auto i = std::find_if(params->begin(), params->end(), [&param](const TmParam& p) { return p.trait() == param.trait() && p.status() == param.status(); });
+        if (i == params->end())
+            params->push_back(param);
+        else
+            i->set_value(param.value());
+    }
+    _params = std::move(params);
+    _recorded = list->_recorded;
+    setTime_(list->time());
+    return true;
+}
 
 void TmParamList::serialize_(mcc::protobuf::MessageBody* body) const
 {
     auto tm = body->mutable__tmparamlist();
     tm->set_device(_device);
+    TmCodec::encode(*_params, tm->mutable_packed());
+    //получатели со старой схемой не знают packed и видели бы пустой список. Версия с участником
+    //не согласуется, поэтому пишем и поштучные значения, пока старые получатели не обновлены;
+    //новые читают packed
     auto params = tm->mutable_params();
-    params->Reserve(_params.size());
-    for (const auto& i : _params)
+    params->Reserve(_params->size());
+    for (const auto& i : *_params)
     {
         auto p = params->Add();
         p->set_trait(i.trait());
         p->set_status(i.status());
         p->set_value(i.value().serialize());
     }
+    if (_recorded.isSome())
+        tm->set_recorded(*_recorded);
+}
+
+//подписка и отписка - разные сообщения protobuf с одинаковыми полями, но один класс с isOn()
+template<typename T>
+static void serializeSubscription(T* dst, const std::string& device, const std::string& trait, const std::string& status)
+{
+    dst->set_device(device);
+    if (!trait.empty())
+        dst->set_trait(trait);
+    if (!status.empty())
+        dst->set_status(status);
+}
+
+void TmParamSubscribe_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    if (_isOn)
+    {
+        auto request = body->mutable__tmparamsubscribe_request();
+        serializeSubscription(request, _device, _trait, _status);
+        if (_periodMs != 0)
+            request->set_period_ms(_periodMs);
+    }
+    else
+        serializeSubscription(body->mutable__tmparamunsubscribe_request(), _device, _trait, _status);
+}
+
+std::unique_ptr<Message> TmParamSubscribe_Request::deserialize(const mcc::protobuf::TmParamSubscribe_Request& body)
+{
+    return mcc::misc::makeUnique<TmParamSubscribe_Request>(true, body.device(), body.trait(), body.status(), body.period_ms());
+}
+
+std::unique_ptr<Message> TmParamSubscribe_Request::deserialize(const mcc::protobuf::TmParamUnSubscribe_Request& body)
+{
+    return mcc::misc::makeUnique<TmParamSubscribe_Request>(false, body.device(), body.trait(), body.status());
+}
+
+void TmParamSubscribe_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    if (_isOn)
+    {
+        auto response = body->mutable__tmparamsubscribe_response();
+        serializeSubscription(response, _device, _trait, _status);
+        if (!_error.empty())
+            response->set_error(_error);
+    }
+    else
+    {
+        auto response = body->mutable__tmparamunsubscribe_response();
+        serializeSubscription(response, _device, _trait, _status);
+        if (!_error.empty())
+            response->set_error(_error);
+    }
+}
+
+std::unique_ptr<Message> TmParamSubscribe_Response::deserialize(const mcc::protobuf::TmParamSubscribe_Response& body)
+{
+    TmParamSubscribe_Request request(true, body.device(), body.trait(), body.status());
+    return mcc::misc::makeUnique<TmParamSubscribe_Response>(&request, body.error());
+}
+
+std::unique_ptr<Message> TmParamSubscribe_Response::deserialize(const mcc::protobuf::TmParamUnSubscribe_Response& body)
+{
+    TmParamSubscribe_Request request(false, body.device(), body.trait(), body.status());
+    return mcc::misc::makeUnique<TmParamSubscribe_Response>(&request, body.error());
 }
 
 std::unique_ptr<Message> TmParamList::deserialize(const mcc::protobuf::TmParamList& list)
 {
+    if (list.has_packed())
+    {
+        bmcl::MemReader reader((const std::uint8_t*)list.packed().data(), list.packed().size());
+        auto params = TmCodec::decode(&reader);
+        if (params.isErr())
+            return nullptr;
+        if (list.has_recorded())
+            return mcc::misc::makeUnique<TmParamList>(list.device(), params.take(), list.recorded());
+        return mcc::misc::makeUnique<TmParamList>(list.device(), params.take());
+    }
+
+    //поштучные значения от старых отправителей
     TmParams params;
     params.reserve(list.params().size());
     for (const auto& i : list.params())
@@ -44,6 +158,163 @@ std::unique_ptr<Message> TmParamList::deserialize(const mcc::protobuf::TmParamLi
     return mcc::misc::makeUnique<TmParamList>(list.device(), std::move(params));
 }
 
+void TmSnapshot_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto request = body->mutable__tmsnapshot_request();
+    if (!_device.empty())
+        request->set_device(_device);
+    if (!_trait.empty())
+        request->set_trait(_trait);
+    if (!_status.empty())
+        request->set_status(_status);
+    if (_since != 0)
+        request->set_since(_since);
+}
+
+std::unique_ptr<Message> TmSnapshot_Request::deserialize(const mcc::protobuf::TmSnapshot_Request& body)
+{
+    return mcc::misc::makeUnique<TmSnapshot_Request>(body.device(), body.trait(), body.status(), body.since());
 }
+
+void TmSnapshot_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto response = body->mutable__tmsnapshot_response();
+    response->set_sequence(_sequence);
+    auto states = response->mutable_states();
+    states->Reserve(_states.size());
+    for (const auto& i : _states)
+    {
+        auto s = states->Add();
+        s->set_device(i.device());
+        s->set_trait(i.param().trait());
+        s->set_status(i.param().status());
+        s->set_value(i.param().value().serialize());
+        s->set_timestamp(i.time());
+        s->set_updates(i.updates());
+    }
 }
 
+std::unique_ptr<Message> TmSnapshot_Response::deserialize(const mcc::protobuf::TmSnapshot_Response& body)
+{
+    TmParamStates states;
+    states.reserve(body.states().size());
+    for (const auto& i : body.states())
+    {
+        bmcl::MemReader reader(i.value().data(), i.value().size());
+        auto p = mcc::misc::NetVariant::deserialize(&reader);
+        if (p.isErr())
+            return nullptr;
+        states.emplace_back(i.device(), TmParam(i.trait(), i.status(), p.take()), i.timestamp(), i.updates());
+    }
+    TmSnapshot_Request request;
+    return mcc::misc::makeUnique<TmSnapshot_Response>(&request, std::move(states), body.sequence());
+}
+
+void TmHistory_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto request = body->mutable__tmhistory_request();
+    request->set_device(_device);
+    auto params = request->mutable_params();
+    params->Reserve(_params.size());
+    for (const auto& i : _params)
+    {
+        auto p = params->Add();
+        p->set_trait(i.trait);
+        p->set_status(i.status);
+    }
+    request->set_from_time(_from);
+    request->set_to_time(_to);
+    if (_bucket != 0)
+        request->set_bucket(_bucket);
+    request->set_max_points(_maxPoints);
+}
+
+std::unique_ptr<Message> TmHistory_Request::deserialize(const mcc::protobuf::TmHistory_Request& body)
+{
+    TmParamNames params;
+    params.reserve(body.params().size());
+    for (const auto& i : body.params())
+        params.emplace_back(i.trait(), i.status());
+    std::uint32_t maxPoints = body.has_max_points() ? body.max_points() : defaultMaxPoints;
+    return mcc::misc::makeUnique<TmHistory_Request>(body.device(), params, body.from_time(), body.to_time(), body.bucket(), maxPoints);
+}
+
+void TmHistory_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto response = body->mutable__tmhistory_response();
+    response->set_trait(_param.trait);
+    response->set_status(_param.status);
+    response->set_part(_part);
+    response->set_last(_isLast);
+    if (!_error.empty())
+        response->set_error(_error);
+    auto points = response->mutable_points();
+    points->Reserve(_points.size());
+    for (const auto& i : _points)
+    {
+        auto p = points->Add();
+        p->set_time(i.time);
+        p->set_value(i.value.serialize());
+        if (i.count != 0)
+        {
+            p->set_min(i.min);
+            p->set_max(i.max);
+            p->set_count(i.count);
+        }
+    }
+}
+
+std::unique_ptr<Message> TmHistory_Response::deserialize(const mcc::protobuf::TmHistory_Response& body)
+{
+    TmHistory_Request request(std::string(), TmParamNames(), 0, 0);
+    if (body.has_error())
+        return mcc::misc::makeUnique<TmHistory_Response>(&request, body.error());
+
+    TmHistoryPoints points;
+    points.reserve(body.points().size());
+    for (const auto& i : body.points())
+    {
+        bmcl::MemReader reader(i.value().data(), i.value().size());
+        auto value = mcc::misc::NetVariant::deserialize(&reader);
+        if (value.isErr())
+            return nullptr;
+        points.emplace_back(i.time(), value.take(), i.min(), i.max(), i.count());
+    }
+    return mcc::misc::makeUnique<TmHistory_Response>(&request, TmParamName(body.trait(), body.status()), std::move(points), body.part(), body.last());
+}
+
+void TmReplay_Request::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto request = body->mutable__tmreplay_request();
+    request->set_path(_path);
+    for (const auto& i : _devices)
+        request->add_devices(i);
+    request->set_from_time(_from);
+    request->set_to_time(_to);
+    request->set_speed(_speed);
+}
+
+std::unique_ptr<Message> TmReplay_Request::deserialize(const mcc::protobuf::TmReplay_Request& body)
+{
+    std::vector<std::string> devices(body.devices().begin(), body.devices().end());
+    return mcc::misc::makeUnique<TmReplay_Request>(body.path(), devices, body.from_time(), body.to_time(), body.speed());
+}
+
+void TmReplay_Response::serialize_(mcc::protobuf::MessageBody* body) const
+{
+    auto response = body->mutable__tmreplay_response();
+    response->set_frames(_frames);
+    response->set_points(_points);
+    response->set_duration(_duration);
+    if (!_error.empty())
+        response->set_error(_error);
+}
+
+std::unique_ptr<Message> TmReplay_Response::deserialize(const mcc::protobuf::TmReplay_Response& body)
+{
+    TmReplay_Request request(std::string(), std::vector<std::string>(), 0, 0);
+    return mcc::misc::makeUnique<TmReplay_Response>(&request, body.frames(), body.points(), body.duration(), body.error());
+}
+
+}
+}
@@ -3,13 +3,15 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include "mcc/misc/NetVariant.h"
 #include "mcc/messages/Message.h"
 
 
-namespace mcc { namespace protobuf { class TmParamList; } }
+namespace mcc { namespace protobuf { class TmParamList; class TmParamSubscribe_Request; class TmParamSubscribe_Response; class TmParamUnSubscribe_Request; class TmParamUnSubscribe_Response; class TmSnapshot_Request; class TmSnapshot_Response; class TmHistory_Request; class TmHistory_Response; class TmReplay_Request; class TmReplay_Response; } }
 
 namespace mcc {
 namespace messages {
@@ -18,22 +20,30 @@ namespace messages {
 class TmParamSubscribe_Request : public MessageTo
 {
 public:
-    TmParamSubscribe_Request(bool isOn, const std::string& device, const std::string& trait = std::string(), const std::string& status = std::string())
-        : MessageTo(mcc::Names::coreTm()), _isOn(isOn), _device(device), _trait(trait), _status(status)
+    TmParamSubscribe_Request(bool isOn, const std::string& device, const std::string& trait = std::string(), const std::string& status = std::string(), std::uint32_t periodMs = 0)
+        : MessageTo(mcc::Names::coreTm()), _isOn(isOn), _device(device), _trait(trait), _status(status), _periodMs(periodMs)
     {
     }
     virtual ~TmParamSubscribe_Request(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::TmParamSubscribe_Request& body);
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::TmParamUnSubscribe_Request& body);
     bool isOn() const { return _isOn; }
     const std::string& device() const { return _device; }
     const std::string& trait() const { return _trait; }
     const std::string& status() const { return _status; }
+    //не чаще одного значения параметра за periodMs, промежуточные схлопываются до последнего; 0 - каждое
+    std::uint32_t periodMs() const { return _periodMs; }
+
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
 
 private:
     bool _isOn;
     std::string _device;
     std::string _trait;
     std::string _status;
+    std::uint32_t _periodMs;
 };
 
 class TmParamSubscribe_Response : public Response
@@ -45,12 +55,17 @@ public:
     }
     virtual ~TmParamSubscribe_Response(){}
     MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::TmParamSubscribe_Response& body);
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::TmParamUnSubscribe_Response& body);
     bool isOn() const { return _isOn; }
     const std::string& device() { return _device; }
     const std::string& trait()  { return _trait; }
     const std::string& status() { return _status; }
     const std::string& error() { return _error; }
 
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
 private:
     bool _isOn;
     std::string _device;
@@ -78,16 +93,28 @@ private:
     mcc::misc::NetVariant _value;
 };
 typedef std::vector<TmParam> TmParams;
+typedef std::shared_ptr<const TmParams> TmParamsPtr;
 
+//параметры неизменяемы и общие для всех копий сообщения: clone() при рассылке
+//подписчикам копирует только заголовок и указатель
 class TmParamList: public MessageTo
 {
 public:
     TmParamList(const std::string& device, const TmParams& params = TmParams())
-        : MessageTo(mcc::Names::coreTm()), _device(device), _params(params)
+        : MessageTo(mcc::Names::coreTm()), _device(device), _params(std::make_shared<const TmParams>(params))
     {
     }
     TmParamList(const std::string& device, TmParams&& params)
-        : MessageTo(mcc::Names::coreTm()), _device(device), _params(std::move(params))
+        : MessageTo(mcc::Names::coreTm()), _device(device), _params(std::make_shared<const TmParams>(std::move(params)))
+    {
+    }
+    TmParamList(const std::string& device, const TmParamsPtr& params)
+        : MessageTo(mcc::Names::coreTm()), _device(device), _params(params)
+    {
+    }
+    //кадр, воспроизведённый из архива и записанный в момент recorded; в архив он снова не пишется
+    TmParamList(const std::string& device, TmParams&& params, mcc::misc::Timestamp recorded)
+        : MessageTo(mcc::Names::coreTm()), _device(device), _params(std::make_shared<const TmParams>(std::move(params))), _recorded(recorded)
     {
     }
     virtual ~TmParamList(){}
@@ -95,16 +122,249 @@ public:
     MESSAGE_REQUIREMENTS_DECLARATIONS();
 
     const std::string& device() const { return _device; }
-    const TmParams params() const { return _params; }
+    const TmParams& params() const { return *_params; }
+    const TmParamsPtr& sharedParams() const { return _params; }
+    bool isReplay() const { return _recorded.isSome(); }
+    //время значений: время записи у воспроизведённого кадра, иначе время отправки
+    mcc::misc::Timestamp sampleTime() const { return _recorded.unwrapOr(time()); }
+    //копия заголовка (время, отправитель) с другим набором параметров
+    std::unique_ptr<TmParamList> cloneWith(const TmParamsPtr& params) const
+    {
+        std::unique_ptr<TmParamList> copy(new TmParamList(*this));
+        copy->_params = params;
+        return copy;
+    }
+    bool coalesce(const Message& newer) override;
 
 protected:
     void serialize_(mcc::protobuf::MessageBody* body) const override;
 
 private:
     std::string _device;
-    TmParams    _params;
+    TmParamsPtr _params;
+    bmcl::Option<mcc::misc::Timestamp> _recorded;
+};
+
+
+//последнее известное значение параметра: время прихода и сколько раз оно обновлялось
+class TmParamState
+{
+public:
+    TmParamState(const std::string& device, const TmParam& param, mcc::misc::Timestamp time, std::uint64_t updates)
+        : _device(device), _param(param), _time(time), _updates(updates)
+    {
+    }
+    const std::string& device() const { return _device; }
+    const TmParam& param() const { return _param; }
+    mcc::misc::Timestamp time() const { return _time; }
+    std::uint64_t updates() const { return _updates; }
+
+private:
+    std::string _device;
+    TmParam _param;
+    mcc::misc::Timestamp _time;
+    std::uint64_t _updates;
 };
+typedef std::vector<TmParamState> TmParamStates;
 
+//Текущие значения телеметрии из кэша core.tm. Пустые device/trait/status - все;
+//since != 0 - только изменившиеся после ответа с sequence() == since
+class TmSnapshot_Request : public MessageTo
+{
+public:
+    TmSnapshot_Request(const std::string& device = std::string(), const std::string& trait = std::string(), const std::string& status = std::string(), std::uint64_t since = 0)
+        : MessageTo(mcc::Names::coreTm()), _device(device), _trait(trait), _status(status), _since(since)
+    {
+    }
+    virtual ~TmSnapshot_Request(){}
+    MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::TmSnapshot_Request& body);
+    const std::string& device() const { return _device; }
+    const std::string& trait() const { return _trait; }
+    const std::string& status() const { return _status; }
+    std::uint64_t since() const { return _since; }
+
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
+private:
+    std::string _device;
+    std::string _trait;
+    std::string _status;
+    std::uint64_t _since;
+};
+
+class TmSnapshot_Response : public Response
+{
+public:
+    TmSnapshot_Response(const TmSnapshot_Request* request, TmParamStates&& states, std::uint64_t sequence)
+        : Response(request), _states(std::move(states)), _sequence(sequence)
+    {
+    }
+    virtual ~TmSnapshot_Response(){}
+    MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::TmSnapshot_Response& body);
+    const TmParamStates& states() const { return _states; }
+    //номер последнего изменения в кэше, передаётся как since в следующий запрос
+    std::uint64_t sequence() const { return _sequence; }
+
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
+private:
+    TmParamStates _states;
+    std::uint64_t _sequence;
+};
+
+struct TmParamName
+{
+    TmParamName(const std::string& trait, const std::string& status) : trait(trait), status(status) {}
+    std::string trait;
+    std::string status;
+};
+typedef std::vector<TmParamName> TmParamNames;
+
+//точка истории. При прореживании - корзина [time, time + bucket): в value среднее,
+//min, max и число исходных точек count; у нечисловых параметров value - последнее значение корзины
+struct TmHistoryPoint
+{
+    TmHistoryPoint(mcc::misc::Timestamp time, const mcc::misc::NetVariant& value, double min = 0, double max = 0, std::uint32_t count = 0)
+        : time(time), value(value), min(min), max(max), count(count)
+    {
+    }
+    mcc::misc::Timestamp time;
+    mcc::misc::NetVariant value;
+    double min;
+    double max;
+    //0 - исходная точка без прореживания
+    std::uint32_t count;
+};
+typedef std::vector<TmHistoryPoint> TmHistoryPoints;
+
+//История телеметрии из архива core.db за from <= time <= to. Пустой params - все параметры
+//устройства, bucket != 0 - прореживание по корзинам такой длины от from.
+//Ответ приходит серией TmHistory_Response по maxPoints точек, у последнего isLast()
+class TmHistory_Request : public MessageTo
+{
+public:
+    static const std::uint32_t defaultMaxPoints = 4096;
+
+    TmHistory_Request(const std::string& device, const TmParamNames& params, mcc::misc::Timestamp from, mcc::misc::Timestamp to,
+                      mcc::misc::Timestamp bucket = 0, std::uint32_t maxPoints = defaultMaxPoints)
+        : MessageTo(mcc::Names::coreDb()), _device(device), _params(params), _from(from), _to(to), _bucket(bucket), _maxPoints(maxPoints)
+    {
+    }
+    virtual ~TmHistory_Request(){}
+    MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::TmHistory_Request& body);
+    const std::string& device() const { return _device; }
+    const TmParamNames& params() const { return _params; }
+    mcc::misc::Timestamp from() const { return _from; }
+    mcc::misc::Timestamp to() const { return _to; }
+    mcc::misc::Timestamp bucket() const { return _bucket; }
+    std::uint32_t maxPoints() const { return _maxPoints; }
+
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
+private:
+    std::string _device;
+    TmParamNames _params;
+    mcc::misc::Timestamp _from;
+    mcc::misc::Timestamp _to;
+    mcc::misc::Timestamp _bucket;
+    std::uint32_t _maxPoints;
+};
+
+//часть ответа: точки одного параметра по возрастанию времени, part - номер части с 0
+class TmHistory_Response : public Response
+{
+public:
+    TmHistory_Response(const TmHistory_Request* request, const TmParamName& param, TmHistoryPoints&& points, std::uint32_t part, bool isLast)
+        : Response(request), _param(param), _points(std::move(points)), _part(part), _isLast(isLast)
+    {
+    }
+    TmHistory_Response(const TmHistory_Request* request, const std::string& error)
+        : Response(request), _param(std::string(), std::string()), _part(0), _isLast(true), _error(error)
+    {
+    }
+    virtual ~TmHistory_Response(){}
+    MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::TmHistory_Response& body);
+    const TmParamName& param() const { return _param; }
+    const TmHistoryPoints& points() const { return _points; }
+    std::uint32_t part() const { return _part; }
+    bool isLast() const { return _isLast; }
+    const std::string& error() const { return _error; }
+
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
+private:
+    TmParamName _param;
+    TmHistoryPoints _points;
+    std::uint32_t _part;
+    bool _isLast;
+    std::string _error;
+};
+
+//Воспроизведение записанного архива телеметрии (mcc.core.replay): кадры уходят в core.tm
+//как TmParamList с isReplay() и временем записи, с исходными промежутками между ними, делёнными
+//на speed; speed 0 - без пауз. core.tm не пересылает их в core.db, архив не растёт от воспроизведения.
+//Пустой devices - все устройства архива, пустой path останавливает текущее воспроизведение.
+//Ответ приходит, когда воспроизведение закончилось или было прервано следующим запросом
+class TmReplay_Request : public MessageTo
+{
+public:
+    TmReplay_Request(const std::string& path, const std::vector<std::string>& devices, mcc::misc::Timestamp from, mcc::misc::Timestamp to, double speed = 1)
+        : MessageTo(mcc::Names::coreReplay()), _path(path), _devices(devices), _from(from), _to(to), _speed(speed)
+    {
+    }
+    virtual ~TmReplay_Request(){}
+    MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::TmReplay_Request& body);
+    const std::string& path() const { return _path; }
+    const std::vector<std::string>& devices() const { return _devices; }
+    mcc::misc::Timestamp from() const { return _from; }
+    mcc::misc::Timestamp to() const { return _to; }
+    double speed() const { return _speed; }
+
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
+private:
+    std::string _path;
+    std::vector<std::string> _devices;
+    mcc::misc::Timestamp _from;
+    mcc::misc::Timestamp _to;
+    double _speed;
+};
+
+//сколько отправлено кадров и значений и за какое реальное время (нс)
+class TmReplay_Response : public Response
+{
+public:
+    TmReplay_Response(const TmReplay_Request* request, std::uint64_t frames, std::uint64_t points, mcc::misc::Timestamp duration, const std::string& error = std::string())
+        : Response(request), _frames(frames), _points(points), _duration(duration), _error(error)
+    {
+    }
+    virtual ~TmReplay_Response(){}
+    MESSAGE_REQUIREMENTS_DECLARATIONS();
+    static std::unique_ptr<Message> deserialize(const mcc::protobuf::TmReplay_Response& body);
+    std::uint64_t frames() const { return _frames; }
+    std::uint64_t points() const { return _points; }
+    mcc::misc::Timestamp duration() const { return _duration; }
+    const std::string& error() const { return _error; }
+
+protected:
+    void serialize_(mcc::protobuf::MessageBody* body) const override;
+
+private:
+    std::uint64_t _frames;
+    std::uint64_t _points;
+    mcc::misc::Timestamp _duration;
+    std::string _error;
+};
 
 
 }
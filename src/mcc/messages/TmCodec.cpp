@@ -0,0 +1,297 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "bmcl/Endian.h"
+#include "bmcl/MemWriter.h"
+#include "mcc/messages/TmCodec.h"
+
+
+namespace mcc {
+namespace messages {
+
+using mcc::misc::NetVariant;
+using mcc::misc::NetVariantType;
+
+static const std::size_t headerSize = 4 + 4 + 1;
+static const std::uint32_t emptySlot = 0xffffffff;
+
+namespace {
+
+//строки без повторов: открытая адресация по хешу, сами строки сравниваются с кучей,
+//так что на каждую строку нет отдельного выделения памяти
+class StringTable
+{
+public:
+    explicit StringTable(std::size_t expected)
+    {
+        std::size_t size = 16;
+        while (size < expected * 2)
+            size *= 2;
+        _slots.assign(size, emptySlot);
+    }
+
+    std::uint32_t add(const char* data, std::size_t size)
+    {
+        std::size_t mask = _slots.size() - 1;
+        for (std::size_t slot = hash(data, size) & mask;; slot = (slot + 1) & mask)
+        {
+            std::uint32_t index = _slots[slot];
+            if (index == emptySlot)
+            {
+                index = (std::uint32_t)_ends.size();
+                _heap.append(data, size);
+                _ends.push_back((std::uint32_t)_heap.size());
+                _slots[slot] = index;
+                if (_ends.size() * 2 > _slots.size())
+                    grow();
+                return index;
+            }
+            std::size_t begin = index == 0 ? 0 : _ends[index - 1];
+            if (_ends[index] - begin == size && std::memcmp(_heap.data() + begin, data, size) == 0)
+                return index;
+        }
+    }
+
+    std::uint32_t add(const std::string& str) { return add(str.data(), str.size()); }
+
+    std::size_t size() const { return _ends.size(); }
+    const std::vector<std::uint32_t>& ends() const { return _ends; }
+    const std::string& heap() const { return _heap; }
+
+private:
+    static std::size_t hash(const char* data, std::size_t size)
+    {
+        //FNV-1a
+        std::uint64_t value = 14695981039346656037ull;
+        for (std::size_t i = 0; i < size; i++)
+            value = (value ^ (std::uint8_t)data[i]) * 1099511628211ull;
+        return (std::size_t)(value ^ (value >> 32));
+    }
+
+    void grow()
+    {
+        _slots.assign(_slots.size() * 2, emptySlot);
+        std::size_t mask = _slots.size() - 1;
+        std::size_t begin = 0;
+        for (std::uint32_t index = 0; index < _ends.size(); index++)
+        {
+            std::size_t slot = hash(_heap.data() + begin, _ends[index] - begin) & mask;
+            while (_slots[slot] != emptySlot)
+                slot = (slot + 1) & mask;
+            _slots[slot] = index;
+            begin = _ends[index];
+        }
+    }
+
+    std::vector<std::uint32_t> _slots;
+    std::vector<std::uint32_t> _ends;
+    std::string _heap;
+};
+}
+
+static void writeIndices(bmcl::MemWriter* writer, const std::vector<std::uint32_t>& indices, std::size_t indexSize)
+{
+    if (indexSize == 2)
+    {
+        for (auto i : indices)
+            writer->writeUint16Le((std::uint16_t)i);
+    }
+    else
+    {
+        for (auto i : indices)
+            writer->writeUint32Le(i);
+    }
+}
+
+void TmCodec::encode(const TmParams& params, std::string* dest)
+{
+    StringTable strings(params.size() * 2);
+    std::vector<std::uint32_t> traits;
+    std::vector<std::uint32_t> statuses;
+    std::vector<std::uint8_t> types;
+    std::vector<std::uint64_t> numbers;
+    std::vector<std::uint32_t> values;
+    traits.reserve(params.size());
+    statuses.reserve(params.size());
+    types.reserve(params.size());
+    numbers.reserve(params.size());
+
+    for (const auto& i : params)
+    {
+        traits.push_back(strings.add(i.trait()));
+        statuses.push_back(strings.add(i.status()));
+        const NetVariant& value = i.value();
+        switch (value.type())
+        {
+        case NetVariantType::None:
+            break;
+        case NetVariantType::String:
+            values.push_back(strings.add(value.stringData(), value.stringSize()));
+            break;
+        case NetVariantType::QString:
+            values.push_back(strings.add(value.asQString().toStdString()));
+            types.push_back((std::uint8_t)NetVariantType::String);
+            continue;
+        default:
+            numbers.push_back(value.numericBits());
+        }
+        types.push_back((std::uint8_t)value.type());
+    }
+
+    std::size_t indexSize = strings.size() <= 0x10000 ? 2 : 4;
+    std::size_t size = headerSize
+        + strings.size() * 4 + strings.heap().size()
+        + types.size()
+        + (traits.size() + statuses.size() + values.size()) * indexSize
+        + numbers.size() * 8;
+    std::size_t offset = dest->size();
+    dest->resize(offset + size);
+
+    bmcl::MemWriter writer(&(*dest)[offset], size);
+    writer.writeUint32Le((std::uint32_t)params.size());
+    writer.writeUint32Le((std::uint32_t)strings.size());
+    writer.writeUint8((std::uint8_t)indexSize);
+    for (auto i : strings.ends())
+        writer.writeUint32Le(i);
+    writer.write(strings.heap().data(), strings.heap().size());
+    writer.write(types.data(), types.size());
+    writeIndices(&writer, traits, indexSize);
+    writeIndices(&writer, statuses, indexSize);
+    for (auto i : numbers)
+        writer.writeUint64Le(i);
+    writeIndices(&writer, values, indexSize);
+}
+
+//колонки разбираются отдельными циклами без ранних выходов, проверки копятся в общий флаг/максимум,
+//так что компилятор может их векторизовать
+
+static std::uint32_t readIndices(bmcl::MemReader* src, std::size_t indexSize, std::size_t count, std::vector<std::uint32_t>* dest)
+{
+    dest->resize(count);
+    const std::uint8_t* data = src->current();
+    std::uint32_t max = 0;
+    if (indexSize == 2)
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            std::uint16_t value;
+            std::memcpy(&value, data + i * 2, 2);
+            (*dest)[i] = le16toh(value);
+            max = std::max(max, (*dest)[i]);
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            std::uint32_t value;
+            std::memcpy(&value, data + i * 4, 4);
+            (*dest)[i] = le32toh(value);
+            max = std::max(max, (*dest)[i]);
+        }
+    }
+    src->skip(count * indexSize);
+    return max;
+}
+
+bmcl::Result<TmParams, TmCodecError> TmCodec::decode(bmcl::MemReader* src)
+{
+    if (src->readableSize() < headerSize)
+        return TmCodecError::InvalidSize;
+    std::size_t count = src->readUint32Le();
+    std::size_t stringCount = src->readUint32Le();
+    std::size_t indexSize = src->readUint8();
+    if (indexSize != 2 && indexSize != 4)
+        return TmCodecError::InvalidSize;
+    //минимум: концы строк, типы и индексы имён
+    if (src->readableSize() / 4 < stringCount || src->readableSize() - stringCount * 4 < count * (1 + 2 * indexSize))
+        return TmCodecError::InvalidSize;
+
+    std::vector<std::uint32_t> ends(stringCount);
+    const std::uint8_t* data = src->current();
+    bool isUnordered = false;
+    std::uint32_t previous = 0;
+    for (std::size_t i = 0; i < stringCount; i++)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, data + i * 4, 4);
+        ends[i] = le32toh(value);
+        isUnordered |= ends[i] < previous;
+        previous = ends[i];
+    }
+    src->skip(stringCount * 4);
+    std::size_t heapSize = stringCount == 0 ? 0 : ends.back();
+    if (isUnordered)
+        return TmCodecError::InvalidIndex;
+    if (src->readableSize() < heapSize + count * (1 + 2 * indexSize))
+        return TmCodecError::InvalidSize;
+
+    std::vector<std::string> strings;
+    strings.reserve(stringCount);
+    const char* heap = (const char*)src->current();
+    for (std::size_t i = 0; i < stringCount; i++)
+    {
+        std::size_t begin = i == 0 ? 0 : ends[i - 1];
+        strings.emplace_back(heap + begin, ends[i] - begin);
+    }
+    src->skip(heapSize);
+
+    const std::uint8_t* types = src->current();
+    std::uint8_t maxType = 0;
+    std::size_t numberCount = 0;
+    std::size_t valueCount = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        maxType = std::max(maxType, types[i]);
+        numberCount += (std::uint8_t)(types[i] - (std::uint8_t)NetVariantType::Bool) <= (std::uint8_t)NetVariantType::Double - (std::uint8_t)NetVariantType::Bool;
+        valueCount += types[i] == (std::uint8_t)NetVariantType::String;
+    }
+    if (maxType > (std::uint8_t)NetVariantType::String)
+        return TmCodecError::InvalidType;
+    src->skip(count);
+
+    std::vector<std::uint32_t> traits;
+    std::vector<std::uint32_t> statuses;
+    std::uint32_t maxIndex = readIndices(src, indexSize, count, &traits);
+    maxIndex = std::max(maxIndex, readIndices(src, indexSize, count, &statuses));
+
+    if (src->readableSize() < numberCount * 8 + valueCount * indexSize)
+        return TmCodecError::InvalidSize;
+    std::vector<std::uint64_t> numbers(numberCount);
+    data = src->current();
+    for (std::size_t i = 0; i < numberCount; i++)
+    {
+        std::uint64_t value;
+        std::memcpy(&value, data + i * 8, 8);
+        numbers[i] = le64toh(value);
+    }
+    src->skip(numberCount * 8);
+
+    std::vector<std::uint32_t> values;
+    maxIndex = std::max(maxIndex, readIndices(src, indexSize, valueCount, &values));
+    if ((count != 0 || valueCount != 0) && maxIndex >= stringCount)
+        return TmCodecError::InvalidIndex;
+
+    TmParams params;
+    params.reserve(count);
+    std::size_t number = 0;
+    std::size_t value = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        NetVariantType type = (NetVariantType)types[i];
+        if (type == NetVariantType::String)
+            params.emplace_back(strings[traits[i]], strings[statuses[i]], NetVariant(strings[values[value++]]));
+        else if (type == NetVariantType::None)
+            params.emplace_back(strings[traits[i]], strings[statuses[i]], NetVariant());
+        else
+            params.emplace_back(strings[traits[i]], strings[statuses[i]], NetVariant::fromNumericBits(type, numbers[number++]));
+    }
+    return params;
+}
+}
+}
@@ -0,0 +1,37 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "bmcl/MemReader.h"
+#include "bmcl/Result.h"
+#include "mcc/messages/Tm.h"
+
+
+namespace mcc {
+namespace messages {
+
+enum class TmCodecError { InvalidSize, InvalidType, InvalidIndex };
+
+//Поколоночная упаковка TmParams, все поля little endian:
+//  u32 число параметров, u32 число строк, u8 размер индекса строки (2 или 4)
+//  u32 конец каждой строки в куче, куча строк
+//  u8 тип значения (NetVariantType) на каждый параметр
+//  индексы признаков, индексы статусов
+//  u64 на каждое числовое значение (NetVariant::numericBits)
+//  индекс на каждое строковое значение
+//Имена и строковые значения лежат в куче по одному разу, числа - сплошным массивом независимо от типа,
+//поэтому разбор идёт простыми циклами по колонкам без ветвлений на каждое значение.
+//QString передаётся как String в utf8
+class TmCodec
+{
+public:
+    //дописывает упакованные параметры в конец dest
+    static void encode(const TmParams& params, std::string* dest);
+    static bmcl::Result<TmParams, TmCodecError> decode(bmcl::MemReader* src);
+};
+}
+}
@@ -0,0 +1,131 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include "mcc/messages/Trace.h"
+
+
+namespace mcc {
+namespace messages {
+
+static StatLatency toStat(const mcc::misc::LatencyHistogram::Snapshot& s)
+{
+    StatLatency stat;
+    stat._count = s.count;
+    stat._mean = s.mean();
+    stat._p50 = s.percentile(0.5);
+    stat._p99 = s.percentile(0.99);
+    stat._max = s.max;
+    return stat;
+}
+
+ServiceTrace::ServiceTrace(const std::string& service) : _service(service)
+{
+    for (std::size_t i = 0; i < messageTypeCount; i++)
+    {
+        _received[i] = 0;
+        _sent[i] = 0;
+    }
+}
+
+StatTrace ServiceTrace::stats() const
+{
+    StatTrace stat;
+    stat._name = _service;
+    stat._wait = toStat(_wait.snapshot());
+    stat._handle = toStat(_handle.snapshot());
+    for (std::size_t i = 0; i < messageTypeCount; i++)
+    {
+        auto received = _received[i].load(std::memory_order_relaxed);
+        if (received != 0)
+            stat._received.emplace_back(Tracer::typeName((MessageType)i), received);
+        auto sent = _sent[i].load(std::memory_order_relaxed);
+        if (sent != 0)
+            stat._sent.emplace_back(Tracer::typeName((MessageType)i), sent);
+    }
+    return stat;
+}
+
+static std::mutex& registryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::map<std::string, ServiceTracePtr>& registry()
+{
+    static std::map<std::string, ServiceTracePtr> services;
+    return services;
+}
+
+const mcc::misc::Timestamp Tracer::reportPeriod;
+
+ServiceTracePtr Tracer::service(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    auto& trace = registry()[name];
+    if (!trace)
+        trace = std::make_shared<ServiceTrace>(name);
+    return trace;
+}
+
+StatTraces Tracer::stats()
+{
+    std::vector<ServiceTracePtr> services;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (const auto& i : registry())
+            services.push_back(i.second);
+    }
+    StatTraces traces;
+    traces.reserve(services.size());
+    for (const auto& i : services)
+        traces.push_back(i->stats());
+    return traces;
+}
+
+static void writeLatency(std::ostream& out, const char* what, const StatLatency& latency)
+{
+    out << "  " << what << " count " << latency._count
+        << " mean " << latency._mean / 1000 << "us"
+        << " p50 " << latency._p50 / 1000 << "us"
+        << " p99 " << latency._p99 / 1000 << "us"
+        << " max " << latency._max / 1000 << "us\n";
+}
+
+bool Tracer::dump(const std::string& path)
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out)
+        return false;
+    out << "# " << mcc::misc::formatTimestamp(mcc::misc::currentTimestamp()) << "\n";
+    for (const auto& trace : stats())
+    {
+        out << trace._name << "\n";
+        writeLatency(out, "wait  ", trace._wait);
+        writeLatency(out, "handle", trace._handle);
+        for (const auto& i : trace._received)
+            out << "  received " << i.first << " " << i.second << "\n";
+        for (const auto& i : trace._sent)
+            out << "  sent " << i.first << " " << i.second << "\n";
+    }
+    out.flush();
+    return (bool)out;
+}
+
+const char* Tracer::typeName(MessageType type)
+{
+    switch (type)
+    {
+#define MCC_MESSAGE_TYPE_NAME(TypeName) case MessageType::TypeName: return #TypeName;
+        MCC_MESSAGE_TYPES(MCC_MESSAGE_TYPE_NAME)
+#undef MCC_MESSAGE_TYPE_NAME
+    }
+    return "?";
+}
+
+}
+}
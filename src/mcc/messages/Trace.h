@@ -0,0 +1,72 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <string>
+#include "mcc/misc/LatencyHistogram.h"
+#include "mcc/misc/TimeUtils.h"
+#include "mcc/messages/Deaclarations.h"
+#include "mcc/messages/Stats.h"
+
+
+namespace mcc {
+namespace messages {
+
+//Трассировка сообщений: сколько сообщение ждало от MessageSenderX::send до выборки в
+//ServiceAbstract::tick, сколько заняла обработка и сколько сообщений каких типов прошло.
+//Вызовы в отправителе и сервисе есть только при сборке с MCC_ENABLE_TRACING (макрос
+//MCC_TRACING), без неё трассировка ничего не стоит.
+
+//пишут поток сервиса и все его отправители без блокировок, читать можно из любого потока
+class ServiceTrace
+{
+public:
+    explicit ServiceTrace(const std::string& service);
+    const std::string& service() const { return _service; }
+
+    void sent(MessageType type)
+    {
+        _sent[(std::size_t)type].fetch_add(1, std::memory_order_relaxed);
+    }
+    //sentAt - Message::time(), now - момент выборки из очереди
+    void received(MessageType type, mcc::misc::Timestamp sentAt, mcc::misc::Timestamp now)
+    {
+        _received[(std::size_t)type].fetch_add(1, std::memory_order_relaxed);
+        _wait.record(now - sentAt);
+    }
+    void handled(mcc::misc::Timestamp start, mcc::misc::Timestamp end)
+    {
+        _handle.record(end - start);
+    }
+
+    StatTrace stats() const;
+
+private:
+    std::string _service;
+    mcc::misc::LatencyHistogram _wait;
+    mcc::misc::LatencyHistogram _handle;
+    std::atomic<std::uint64_t> _received[messageTypeCount];
+    std::atomic<std::uint64_t> _sent[messageTypeCount];
+};
+typedef std::shared_ptr<ServiceTrace> ServiceTracePtr;
+
+//все ServiceTrace процесса
+class Tracer
+{
+public:
+    //как часто сервисы отправляют SystemComponentTrace
+    static const mcc::misc::Timestamp reportPeriod = 10 * 1000 * 1000 * 1000LL;
+
+    //для одного имени всегда один объект, так что сервис и его отправители пишут в общий
+    static ServiceTracePtr service(const std::string& name);
+    static StatTraces stats();
+    //текстовая таблица по всем сервисам, false - файл не удалось записать
+    static bool dump(const std::string& path);
+    static const char* typeName(MessageType type);
+};
+
+}
+}
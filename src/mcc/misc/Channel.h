@@ -7,12 +7,16 @@
 #include <mcc/misc/Option.h>
 #include <mcc/misc/Result.h>
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <deque>
+#include <functional>
 #include <mutex>
 #include <memory>
 #include <chrono>
+#include <iterator>
+#include <vector>
 
 namespace mcc {
 namespace misc {
@@ -29,16 +33,27 @@ public:
     bool sendEmplace(A&&... args);
     bool send(const T& value);
     bool send(T&& value);
+    template <typename I>
+    bool sendBatch(I first, I last);
+    bool sendBatch(std::vector<T>&& values);
     mcc::misc::Option<T> recv();
     mcc::misc::Result<T, ChannelError> tryRecv();
     template <typename R, typename P>
     mcc::misc::Result<T, ChannelError> tryRecvFor(const std::chrono::duration<R, P>& dur);
+    std::size_t recvAll(std::vector<T>* dest, std::size_t maxCount);
+    template <typename R, typename P>
+    std::size_t recvAllFor(std::vector<T>* dest, std::size_t maxCount, const std::chrono::duration<R, P>& dur);
+    template <typename F>
+    bool update(F&& f);
+    template <typename R, typename P>
+    bool waitForSpace(std::size_t maxSize, const std::chrono::duration<R, P>& dur);
     void clear();
     bool isEmpty() const;
     std::size_t size() const;
     void close();
     void reopen();
     bool isOpen() const { return _isOpen; }
+    void setWaker(const std::function<void()>& waker);
 
     Channel(const Channel&) = delete;
     Channel(Channel&&) = delete;
@@ -46,15 +61,25 @@ public:
     Channel& operator=(Channel&&) = delete;
 
 private:
+    typedef std::shared_ptr<const std::function<void()>> WakerPtr;
+
+    void wake(const WakerPtr& waker);
+    std::size_t popMany(std::vector<T>* dest, std::size_t maxCount);
+    void notifySpace();
+
     std::deque<T> _queue;
     mutable std::mutex _queueMutex;
     std::condition_variable _queueNotEmpty;
+    std::condition_variable _queueNotFull;
+    std::size_t _spaceWaiters;
     std::atomic<bool> _isOpen;
+    WakerPtr _waker;
 };
 
 template <typename T>
 inline Channel<T>::Channel()
-    : _isOpen(true)
+    : _spaceWaiters(0)
+    , _isOpen(true)
 {
 }
 
@@ -67,18 +92,28 @@ inline Channel<T>::~Channel()
 template <typename T>
 bool Channel<T>::send(const T& value)
 {
-    std::lock_guard<std::mutex> lock(_queueMutex);
-    _queue.push_back(value);
-    _queueNotEmpty.notify_one();
+    WakerPtr waker;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _queue.push_back(value);
+        _queueNotEmpty.notify_one();
+        waker = _waker;
+    }
+    wake(waker);
     return _isOpen;
 }
 
 template <typename T>
 bool Channel<T>::send(T&& value)
 {
-    std::lock_guard<std::mutex> lock(_queueMutex);
-    _queue.push_back(std::forward<T>(value));
-    _queueNotEmpty.notify_one();
+    WakerPtr waker;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _queue.push_back(std::forward<T>(value));
+        _queueNotEmpty.notify_one();
+        waker = _waker;
+    }
+    wake(waker);
     return _isOpen;
 }
 
@@ -86,12 +121,45 @@ template <typename T>
 template <typename... A>
 bool Channel<T>::sendEmplace(A&&... args)
 {
-    std::lock_guard<std::mutex> lock(_queueMutex);
-    _queue.emplace_back(std::forward<A>(args)...);
-    _queueNotEmpty.notify_one();
+    WakerPtr waker;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _queue.emplace_back(std::forward<A>(args)...);
+        _queueNotEmpty.notify_one();
+        waker = _waker;
+    }
+    wake(waker);
     return _isOpen;
 }
 
+// whole batch is queued under one lock with one notification
+template <typename T>
+template <typename I>
+bool Channel<T>::sendBatch(I first, I last)
+{
+    if (first == last) {
+        return _isOpen;
+    }
+    WakerPtr waker;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _queue.insert(_queue.end(), first, last);
+        _queueNotEmpty.notify_all();
+        waker = _waker;
+    }
+    wake(waker);
+    return _isOpen;
+}
+
+// values are moved from and cleared
+template <typename T>
+bool Channel<T>::sendBatch(std::vector<T>&& values)
+{
+    bool isOpen = sendBatch(std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+    values.clear();
+    return isOpen;
+}
+
 template <typename T>
 mcc::misc::Option<T> Channel<T>::recv()
 {
@@ -106,6 +174,7 @@ mcc::misc::Option<T> Channel<T>::recv()
     }
     mcc::misc::Option<T> res(std::move(_queue.front()));
     _queue.pop_front();
+    notifySpace();
     return res;
 }
 
@@ -121,6 +190,7 @@ mcc::misc::Result<T, ChannelError> Channel<T>::tryRecv()
     }
     mcc::misc::Result<T, ChannelError> res(std::move(_queue.front()));
     _queue.pop_front();
+    notifySpace();
     return res;
 }
 
@@ -142,14 +212,96 @@ mcc::misc::Result<T, ChannelError> Channel<T>::tryRecvFor(const std::chrono::dur
     }
     mcc::misc::Result<T, ChannelError> res(std::move(_queue.front()));
     _queue.pop_front();
+    notifySpace();
     return res;
 }
 
+// appends up to maxCount queued values to dest without blocking, returns their number
+template <typename T>
+std::size_t Channel<T>::recvAll(std::vector<T>* dest, std::size_t maxCount)
+{
+    if (!_isOpen) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    return popMany(dest, maxCount);
+}
+
+// same as recvAll, but waits up to dur for the first value
+template <typename T>
+template <typename R, typename P>
+std::size_t Channel<T>::recvAllFor(std::vector<T>* dest, std::size_t maxCount, const std::chrono::duration<R, P>& dur)
+{
+    std::unique_lock<std::mutex> lock(_queueMutex);
+    bool isActive;
+    _queueNotEmpty.wait_for(lock, dur, [&]() {
+        isActive = _isOpen;
+        return !_queue.empty() || !isActive;
+    });
+    if (!isActive) {
+        return 0;
+    }
+    return popMany(dest, maxCount);
+}
+
+template <typename T>
+std::size_t Channel<T>::popMany(std::vector<T>* dest, std::size_t maxCount)
+{
+    std::size_t count = std::min(maxCount, _queue.size());
+    auto last = _queue.begin() + count;
+    dest->insert(dest->end(), std::make_move_iterator(_queue.begin()), std::make_move_iterator(last));
+    _queue.erase(_queue.begin(), last);
+    notifySpace();
+    return count;
+}
+
+// f(std::deque<T>*) is called under the channel lock and may inspect and modify the queued
+// values, e.g. to evict or coalesce them; consumers are woken if f returns true
+template <typename T>
+template <typename F>
+bool Channel<T>::update(F&& f)
+{
+    WakerPtr waker;
+    bool isChanged;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        isChanged = f(&_queue);
+        if (!isChanged) {
+            return false;
+        }
+        _queueNotEmpty.notify_all();
+        waker = _waker;
+    }
+    wake(waker);
+    return true;
+}
+
+// waits until less than maxSize values are queued; false on timeout or if the channel is closed
+template <typename T>
+template <typename R, typename P>
+bool Channel<T>::waitForSpace(std::size_t maxSize, const std::chrono::duration<R, P>& dur)
+{
+    std::unique_lock<std::mutex> lock(_queueMutex);
+    _spaceWaiters++;
+    bool hasSpace = _queueNotFull.wait_for(lock, dur, [&]() { return _queue.size() < maxSize || !_isOpen; });
+    _spaceWaiters--;
+    return hasSpace && _isOpen;
+}
+
+template <typename T>
+inline void Channel<T>::notifySpace()
+{
+    if (_spaceWaiters != 0) {
+        _queueNotFull.notify_all();
+    }
+}
+
 template <typename T>
 inline void Channel<T>::clear()
 {
     std::lock_guard<std::mutex> lock(_queueMutex);
     _queue.clear();
+    notifySpace();
 }
 
 template <typename T>
@@ -172,6 +324,7 @@ void Channel<T>::close()
     _isOpen = false;
     clear();
     _queueNotEmpty.notify_all();
+    _queueNotFull.notify_all();
 }
 
 template <typename T>
@@ -180,111 +333,165 @@ void Channel<T>::reopen()
     _isOpen = true;
 }
 
+// waker is invoked after every send, outside of the channel lock; used to schedule
+// cooperative consumers instead of having them block in recv
 template <typename T>
-using ChannelPtr = std::shared_ptr<Channel<T>>;
+void Channel<T>::setWaker(const std::function<void()>& waker)
+{
+    WakerPtr ptr;
+    if (waker) {
+        ptr = std::make_shared<const std::function<void()>>(waker);
+    }
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    _waker = ptr;
+}
 
 template <typename T>
+inline void Channel<T>::wake(const WakerPtr& waker)
+{
+    if (waker) {
+        (*waker)();
+    }
+}
+
+template <typename T>
+using ChannelPtr = std::shared_ptr<Channel<T>>;
+
+template <typename T, typename C = Channel<T>>
 class Sender {
 public:
     Sender()
     {
     }
 
-    Sender(const ChannelPtr<T>& chan);
+    Sender(const std::shared_ptr<C>& chan);
 
     template <typename... A>
     bool sendEmplace(A&&... args);
     bool send(const T& value);
     bool send(T&& value);
+    template <typename I>
+    bool sendBatch(I first, I last);
+    bool sendBatch(std::vector<T>&& values);
 
     void close();
     void reopen();
     bool isOpen() const { return _chan->isOpen(); }
 
 private:
-    ChannelPtr<T> _chan;
+    std::shared_ptr<C> _chan;
 };
 
-template <typename T>
-inline Sender<T>::Sender(const ChannelPtr<T>& chan)
+template <typename T, typename C>
+inline Sender<T, C>::Sender(const std::shared_ptr<C>& chan)
     : _chan(chan)
 {
 }
 
-template <typename T>
+template <typename T, typename C>
 template <typename... A>
-inline bool Sender<T>::sendEmplace(A&&... args)
+inline bool Sender<T, C>::sendEmplace(A&&... args)
 {
     return _chan->sendEmplace(std::forward<A>(args)...);
 }
 
-template <typename T>
-inline bool Sender<T>::send(const T& value)
+template <typename T, typename C>
+inline bool Sender<T, C>::send(const T& value)
 {
     return _chan->send(value);
 }
 
-template <typename T>
-inline bool Sender<T>::send(T&& value)
+template <typename T, typename C>
+inline bool Sender<T, C>::send(T&& value)
 {
     return _chan->send(std::forward<T>(value));
 }
 
-template <typename T>
-inline void Sender<T>::close()
+template <typename T, typename C>
+template <typename I>
+inline bool Sender<T, C>::sendBatch(I first, I last)
+{
+    return _chan->sendBatch(first, last);
+}
+
+template <typename T, typename C>
+inline bool Sender<T, C>::sendBatch(std::vector<T>&& values)
+{
+    return _chan->sendBatch(std::move(values));
+}
+
+template <typename T, typename C>
+inline void Sender<T, C>::close()
 {
     return _chan->close();
 }
 
-template <typename T>
-inline void Sender<T>::reopen()
+template <typename T, typename C>
+inline void Sender<T, C>::reopen()
 {
     return _chan->reopen();
 }
 
-template <typename T>
+template <typename T, typename C = Channel<T>>
 class Reciever {
 public:
     Reciever()
     {
     }
 
-    Reciever(const ChannelPtr<T>& chan);
+    Reciever(const std::shared_ptr<C>& chan);
 
     mcc::misc::Option<T> recv();
     mcc::misc::Result<T, ChannelError> tryRecv();
     template <typename R, typename P>
     mcc::misc::Result<T, ChannelError> tryRecvFor(const std::chrono::duration<R, P>& dur);
+    std::size_t recvAll(std::vector<T>* dest, std::size_t maxCount);
+    template <typename R, typename P>
+    std::size_t recvAllFor(std::vector<T>* dest, std::size_t maxCount, const std::chrono::duration<R, P>& dur);
 
 private:
-    ChannelPtr<T> _chan;
+    std::shared_ptr<C> _chan;
 };
 
-template <typename T>
-inline Reciever<T>::Reciever(const ChannelPtr<T>& chan)
+template <typename T, typename C>
+inline Reciever<T, C>::Reciever(const std::shared_ptr<C>& chan)
     : _chan(chan)
 {
 }
 
-template <typename T>
-inline Option<T> Reciever<T>::recv()
+template <typename T, typename C>
+inline Option<T> Reciever<T, C>::recv()
 {
     return _chan->recv();
 }
 
-template <typename T>
-inline Result<T, ChannelError> Reciever<T>::tryRecv()
+template <typename T, typename C>
+inline Result<T, ChannelError> Reciever<T, C>::tryRecv()
 {
     return _chan->tryRecv();
 }
 
-template <typename T>
+template <typename T, typename C>
 template <typename R, typename P>
-inline Result<T, ChannelError> Reciever<T>::tryRecvFor(const std::chrono::duration<R, P>& dur)
+inline Result<T, ChannelError> Reciever<T, C>::tryRecvFor(const std::chrono::duration<R, P>& dur)
 {
     return _chan->tryRecvFor(dur);
 }
 
+template <typename T, typename C>
+inline std::size_t Reciever<T, C>::recvAll(std::vector<T>* dest, std::size_t maxCount)
+{
+    return _chan->recvAll(dest, maxCount);
+}
+
+template <typename T, typename C>
+template <typename R, typename P>
+inline std::size_t Reciever<T, C>::recvAllFor(std::vector<T>* dest, std::size_t maxCount,
+                                             const std::chrono::duration<R, P>& dur)
+{
+    return _chan->recvAllFor(dest, maxCount, dur);
+}
+
 template <typename T, typename R = T>
 struct ChannelPair {
     ChannelPair()
@@ -0,0 +1,182 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mcc/misc/Executor.h"
+
+#include <cassert>
+
+namespace mcc {
+namespace misc {
+
+const std::size_t Executor::laneCount;
+
+static thread_local Executor* currentExecutor = nullptr;
+static thread_local std::size_t currentWorker = 0;
+
+Executor::Executor(std::size_t nThreads)
+    : _nextWorker(0)
+    , _pending(0)
+    , _sleeping(0)
+    , _isRunning(true)
+{
+    if (nThreads == 0) {
+        nThreads = 1;
+    }
+    for (std::size_t i = 0; i < nThreads; i++) {
+        _workers.emplace_back(new Worker);
+    }
+    for (std::size_t i = 0; i < nThreads; i++) {
+        _threads.emplace_back(&Executor::workerLoop, this, i);
+    }
+    _timerThread = std::thread(&Executor::timerLoop, this);
+}
+
+Executor::~Executor()
+{
+    stop();
+}
+
+void Executor::stop()
+{
+    {
+        std::lock_guard<std::mutex> idleLock(_idleMutex);
+        std::lock_guard<std::mutex> timerLock(_timerMutex);
+        _isRunning = false;
+    }
+    _idle.notify_all();
+    _timerChanged.notify_all();
+    for (std::thread& thread : _threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    if (_timerThread.joinable()) {
+        _timerThread.join();
+    }
+    _timers.clear();
+    for (const auto& worker : _workers) {
+        for (std::deque<Task>& lane : worker->lanes) {
+            lane.clear();
+        }
+    }
+}
+
+bool Executor::isWorkerThread()
+{
+    return currentExecutor != nullptr;
+}
+
+void Executor::post(Task&& task, TaskPriority priority)
+{
+    if (!_isRunning) {
+        return;
+    }
+    std::size_t index;
+    if (currentExecutor == this) {
+        index = currentWorker;
+    } else {
+        index = _nextWorker.fetch_add(1, std::memory_order_relaxed) % _workers.size();
+    }
+    // counted before it is published, otherwise a worker may take it and decrement first
+    _pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(_workers[index]->mutex);
+        _workers[index]->lanes[(std::size_t)priority].push_back(std::move(task));
+    }
+    if (_sleeping.load() != 0) {
+        std::lock_guard<std::mutex> lock(_idleMutex);
+        _idle.notify_one();
+    }
+}
+
+void Executor::postAfter(Clock::duration delay, Task&& task, TaskPriority priority)
+{
+    std::lock_guard<std::mutex> lock(_timerMutex);
+    if (!_isRunning) {
+        return;
+    }
+    auto deadline = Clock::now() + delay;
+    bool isFirst = _timers.empty() || deadline < _timers.begin()->first;
+    Timer timer;
+    timer.task = std::move(task);
+    timer.priority = priority;
+    _timers.emplace(deadline, std::move(timer));
+    if (isFirst) {
+        _timerChanged.notify_one();
+    }
+}
+
+bool Executor::popLocal(std::size_t index, Task* task)
+{
+    Worker* worker = _workers[index].get();
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    for (std::deque<Task>& lane : worker->lanes) {
+        if (!lane.empty()) {
+            *task = std::move(lane.front());
+            lane.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// thieves take from the back so that the owner and the thief rarely touch the same end
+bool Executor::steal(std::size_t index, Task* task)
+{
+    for (std::size_t lane = 0; lane < laneCount; lane++) {
+        for (std::size_t i = 1; i < _workers.size(); i++) {
+            Worker* victim = _workers[(index + i) % _workers.size()].get();
+            std::unique_lock<std::mutex> lock(victim->mutex, std::try_to_lock);
+            if (!lock.owns_lock() || victim->lanes[lane].empty()) {
+                continue;
+            }
+            *task = std::move(victim->lanes[lane].back());
+            victim->lanes[lane].pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void Executor::workerLoop(std::size_t index)
+{
+    currentExecutor = this;
+    currentWorker = index;
+    Task task;
+    while (_isRunning) {
+        if (popLocal(index, &task) || steal(index, &task)) {
+            _pending.fetch_sub(1);
+            task();
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(_idleMutex);
+        _sleeping.fetch_add(1);
+        _idle.wait(lock, [this]() { return _pending.load() != 0 || !_isRunning; });
+        _sleeping.fetch_sub(1);
+    }
+}
+
+void Executor::timerLoop()
+{
+    std::unique_lock<std::mutex> lock(_timerMutex);
+    while (_isRunning) {
+        if (_timers.empty()) {
+            _timerChanged.wait(lock);
+            continue;
+        }
+        auto first = _timers.begin();
+        if (Clock::now() < first->first) {
+            _timerChanged.wait_until(lock, first->first);
+            continue;
+        }
+        Timer timer = std::move(first->second);
+        _timers.erase(first);
+        lock.unlock();
+        post(std::move(timer.task), timer.priority);
+        lock.lock();
+    }
+}
+}
+}
@@ -0,0 +1,81 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mcc {
+namespace misc {
+
+enum class TaskPriority { High, Normal, Low };
+
+// Fixed pool of workers, each with its own task deque. Idle workers steal from the
+// others before going to sleep, so a burst posted to one worker spreads over all of them.
+// Tasks posted from a worker thread go to that worker's deque. Every deque has a lane
+// per TaskPriority, a lower lane is served only when all higher lanes are empty.
+class Executor {
+public:
+    typedef std::function<void()> Task;
+    typedef std::chrono::steady_clock Clock;
+
+    explicit Executor(std::size_t nThreads = std::thread::hardware_concurrency());
+    ~Executor();
+
+    void post(Task&& task, TaskPriority priority = TaskPriority::Normal);
+    void postAfter(Clock::duration delay, Task&& task, TaskPriority priority = TaskPriority::Normal);
+    void stop();
+    bool isRunning() const { return _isRunning; }
+    std::size_t threadCount() const { return _threads.size(); }
+    // true inside a task of any executor: such a caller must not wait for other tasks,
+    // the one it waits for may need this very worker
+    static bool isWorkerThread();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+private:
+    static const std::size_t laneCount = 3;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> lanes[laneCount];
+    };
+
+    struct Timer {
+        Task task;
+        TaskPriority priority;
+    };
+
+    bool popLocal(std::size_t index, Task* task);
+    bool steal(std::size_t index, Task* task);
+    void workerLoop(std::size_t index);
+    void timerLoop();
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::vector<std::thread> _threads;
+    std::atomic<std::size_t> _nextWorker;
+    std::atomic<std::size_t> _pending;
+    std::atomic<std::size_t> _sleeping;
+    std::atomic<bool> _isRunning;
+    std::mutex _idleMutex;
+    std::condition_variable _idle;
+
+    std::thread _timerThread;
+    std::mutex _timerMutex;
+    std::condition_variable _timerChanged;
+    std::multimap<Clock::time_point, Timer> _timers;
+};
+}
+}
@@ -0,0 +1,120 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mcc/misc/LatencyHistogram.h"
+
+namespace mcc {
+namespace misc {
+
+const unsigned LatencyHistogram::subBucketBits;
+const std::size_t LatencyHistogram::subBucketCount;
+const unsigned LatencyHistogram::maxExponent;
+const std::size_t LatencyHistogram::bucketCount;
+
+static unsigned floorLog2(std::uint64_t value)
+{
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    unsigned result = 0;
+    for (unsigned shift = 32; shift != 0; shift /= 2) {
+        if (value >= (std::uint64_t(1) << shift)) {
+            value >>= shift;
+            result += shift;
+        }
+    }
+    return result;
+#endif
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+// values below subBucketCount get a bucket each, then every power of two 2^e gets
+// subBucketCount buckets of width 2^(e - subBucketBits)
+std::size_t LatencyHistogram::bucketIndex(std::int64_t ns)
+{
+    if (ns < (std::int64_t)subBucketCount) {
+        return ns < 0 ? 0 : (std::size_t)ns;
+    }
+    unsigned exponent = floorLog2((std::uint64_t)ns);
+    if (exponent > maxExponent) {
+        return bucketCount - 1;
+    }
+    unsigned shift = exponent - subBucketBits;
+    std::size_t sub = (std::size_t)((std::uint64_t)ns >> shift) - subBucketCount;
+    return subBucketCount * (shift + 1) + sub;
+}
+
+std::int64_t LatencyHistogram::bucketLowest(std::size_t index)
+{
+    if (index < subBucketCount) {
+        return (std::int64_t)index;
+    }
+    std::size_t shift = index / subBucketCount - 1;
+    std::size_t sub = index % subBucketCount;
+    return (std::int64_t)((subBucketCount + sub) << shift);
+}
+
+void LatencyHistogram::record(std::int64_t ns)
+{
+    if (ns < 0) {
+        ns = 0;
+    }
+    _buckets[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(ns, std::memory_order_relaxed);
+    std::int64_t max = _max.load(std::memory_order_relaxed);
+    while (ns > max && !_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    Snapshot s;
+    s.buckets.resize(bucketCount);
+    for (std::size_t i = 0; i < bucketCount; i++) {
+        s.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+        s.count += s.buckets[i];
+    }
+    s.sum = _sum.load(std::memory_order_relaxed);
+    s.max = _max.load(std::memory_order_relaxed);
+    return s;
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<std::uint64_t>& bucket : _buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    _count.store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+std::int64_t LatencyHistogram::Snapshot::percentile(double q) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    std::uint64_t rank = (std::uint64_t)(q * count + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // the middle of the bucket, but never above the largest recorded value
+            std::int64_t lowest = bucketLowest(i);
+            std::int64_t middle = lowest + (bucketLowest(i + 1) - lowest) / 2;
+            return middle < max ? middle : max;
+        }
+    }
+    return max;
+}
+}
+}
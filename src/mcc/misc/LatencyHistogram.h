@@ -0,0 +1,61 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mcc {
+namespace misc {
+
+// Log-linear histogram of durations in nanoseconds (HDR histogram layout): every power
+// of two is split into subBucketCount linear buckets, so a value is reported with at most
+// 1/subBucketCount relative error. record() is wait-free and may be called from any
+// number of threads, readers take a snapshot() without stopping writers.
+class LatencyHistogram {
+public:
+    static const unsigned subBucketBits = 5;
+    static const std::size_t subBucketCount = std::size_t(1) << subBucketBits;
+    // values above 2^maxExponent ns (about 2.5 hours) are counted in the last bucket
+    static const unsigned maxExponent = 43;
+    static const std::size_t bucketCount = subBucketCount * (maxExponent - subBucketBits + 2);
+
+    struct Snapshot {
+        std::uint64_t count = 0;
+        std::int64_t sum = 0;
+        std::int64_t max = 0;
+        std::vector<std::uint64_t> buckets;
+
+        // q in [0, 1], 0 if nothing was recorded
+        std::int64_t percentile(double q) const;
+        std::int64_t mean() const { return count == 0 ? 0 : sum / (std::int64_t)count; }
+    };
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // negative values are counted as zero
+    void record(std::int64_t ns);
+    std::uint64_t count() const { return _count.load(std::memory_order_relaxed); }
+    Snapshot snapshot() const;
+    // values recorded concurrently with reset() may survive it
+    void reset();
+
+    static std::size_t bucketIndex(std::int64_t ns);
+    // smallest value that falls into the bucket
+    static std::int64_t bucketLowest(std::size_t index);
+
+private:
+    std::atomic<std::uint64_t> _buckets[bucketCount];
+    std::atomic<std::uint64_t> _count;
+    std::atomic<std::int64_t> _sum;
+    std::atomic<std::int64_t> _max;
+};
+}
+}
@@ -0,0 +1,94 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mcc/misc/NameTable.h"
+
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <unordered_map>
+
+namespace mcc {
+namespace misc {
+
+const NameId NameTable::emptyId;
+const std::size_t NameTable::maxCount;
+
+static const std::size_t chunkSize = 256;
+static const std::size_t chunkCount = NameTable::maxCount / chunkSize;
+
+// names are stored in fixed chunks that are never moved, so readers need only the count
+struct Names {
+    Names()
+        : count(0)
+    {
+        for (std::atomic<std::string*>& chunk : chunks) {
+            chunk = nullptr;
+        }
+        chunks[0] = new std::string[chunkSize];
+        ids.emplace(std::string(), NameTable::emptyId);
+        count = 1;
+    }
+
+    std::atomic<std::string*> chunks[chunkCount];
+    std::atomic<std::size_t> count;
+    std::mutex mutex;
+    std::unordered_map<std::string, NameId> ids;
+};
+
+static Names& names()
+{
+    static Names* instance = new Names;
+    return *instance;
+}
+
+NameId NameTable::intern(const std::string& name)
+{
+    static thread_local std::unordered_map<std::string, NameId> cache;
+    auto cached = cache.find(name);
+    if (cached != cache.end()) {
+        return cached->second;
+    }
+
+    Names& table = names();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto i = table.ids.find(name);
+    if (i != table.ids.end()) {
+        cache.emplace(name, i->second);
+        return i->second;
+    }
+
+    std::size_t id = table.count.load(std::memory_order_relaxed);
+    if (id >= maxCount) {
+        assert(false);
+        return emptyId;
+    }
+    std::string* chunk = table.chunks[id / chunkSize].load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new std::string[chunkSize];
+        table.chunks[id / chunkSize].store(chunk, std::memory_order_relaxed);
+    }
+    chunk[id % chunkSize] = name;
+    table.ids.emplace(name, (NameId)id);
+    table.count.store(id + 1, std::memory_order_release);
+    cache.emplace(name, (NameId)id);
+    return (NameId)id;
+}
+
+const std::string& NameTable::name(NameId id)
+{
+    Names& table = names();
+    if (id >= table.count.load(std::memory_order_acquire)) {
+        assert(false);
+        id = emptyId;
+    }
+    return table.chunks[id / chunkSize].load(std::memory_order_relaxed)[id % chunkSize];
+}
+
+std::size_t NameTable::count()
+{
+    return names().count.load(std::memory_order_acquire);
+}
+}
+}
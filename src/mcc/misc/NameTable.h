@@ -0,0 +1,30 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace mcc {
+namespace misc {
+
+typedef std::uint32_t NameId;
+
+// Process-wide table of service and device names. Every distinct name gets a small
+// integer id that never changes and is never reused, id 0 is the empty name.
+// name() is lock free and the returned reference stays valid until the process exits.
+// intern() takes a lock only for names the calling thread hasn't interned before.
+class NameTable {
+public:
+    static const NameId emptyId = 0;
+    static const std::size_t maxCount = 256 * 1024;
+
+    static NameId intern(const std::string& name);
+    static const std::string& name(NameId id);
+    static std::size_t count();
+};
+}
+}
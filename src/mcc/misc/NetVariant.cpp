@@ -13,49 +13,57 @@
 namespace mcc {
 namespace misc {
 
+const std::size_t NetVariant::smallStringCapacity;
+
 NetVariant::NetVariant(const QVariant& value)
 {
     switch (value.type())
     {
-    case QVariant::Bool: init(value.toBool(), NetVariantType::Bool); break;
-    case QVariant::Int: init(value.toInt(), NetVariantType::Int); break;
-    case QVariant::LongLong: init(value.toInt(), NetVariantType::Int); break;
-    case QVariant::UInt: init(value.toUInt(), NetVariantType::Uint); break;
-    case QVariant::ULongLong: init(value.toUInt(), NetVariantType::Uint); break;
-    case QVariant::Double: init(value.toDouble(), NetVariantType::Double); break;
-    case QVariant::String: init(value.toString(), NetVariantType::QString); break;
+    case QVariant::Bool: initNumber(value.toBool(), NetVariantType::Bool); break;
+    case QVariant::Int: initNumber(std::int64_t(value.toInt()), NetVariantType::Int); break;
+    case QVariant::LongLong: initNumber(std::int64_t(value.toLongLong()), NetVariantType::Int); break;
+    case QVariant::UInt: initNumber(std::uint64_t(value.toUInt()), NetVariantType::Uint); break;
+    case QVariant::ULongLong: initNumber(std::uint64_t(value.toULongLong()), NetVariantType::Uint); break;
+    case QVariant::Double: initNumber(value.toDouble(), NetVariantType::Double); break;
+    case QVariant::String:
+        new (cast<QString>()) QString(value.toString());
+        _type = NetVariantType::QString;
+        _isHeap = true;
+        break;
     default:
         assert(false);
-        _type = NetVariantType::None;
+        initNumber<std::uint64_t>(0, NetVariantType::None);
     }
 }
 
-void NetVariant::construct(const NetVariant& other)
+void NetVariant::initString(const char* data, std::size_t size)
 {
-    switch (other._type) {
-    case NetVariantType::Bool:
-        *cast<bool>() = *other.cast<bool>();
-        break;
-    case NetVariantType::Int:
-        *cast<std::int64_t>() = *other.cast<std::int64_t>();
-        break;
-    case NetVariantType::Uint:
-        *cast<std::uint64_t>() = *other.cast<std::uint64_t>();
-        break;
-    case NetVariantType::Float:
-        *cast<float>() = *other.cast<float>();
-        break;
-    case NetVariantType::Double:
-        *cast<double>() = *other.cast<double>();
-        break;
-    case NetVariantType::String:
-        new (cast<std::string>()) std::string(*other.cast<std::string>());
-        break;
-    case NetVariantType::QString:
+    _type = NetVariantType::String;
+    if (size <= smallStringCapacity) {
+        SmallString* small = cast<SmallString>();
+        std::memcpy(small->data, data, size);
+        small->data[size] = '\0';
+        small->size = (std::uint8_t)size;
+        _isHeap = false;
+        return;
+    }
+    HeapString* heap = cast<HeapString>();
+    heap->data = new char[size];
+    std::memcpy(heap->data, data, size);
+    heap->size = size;
+    _isHeap = true;
+}
+
+void NetVariant::constructSlow(const NetVariant& other)
+{
+    if (other._type == NetVariantType::QString) {
         new (cast<QString>()) QString(*other.cast<QString>());
-        break;
+        _type = NetVariantType::QString;
+        _isHeap = true;
+        return;
     }
-    _type = other._type;
+    const HeapString* heap = other.cast<HeapString>();
+    initString(heap->data, heap->size);
 }
 
 std::string NetVariant::stringify() const
@@ -106,75 +114,22 @@ QString NetVariant::qstringify() const
     case NetVariantType::Double:
         return QString::number(asDouble());
     case NetVariantType::String:
-        return QString::fromStdString(asString());
+        return QString::fromUtf8(stringData(), (int)stringSize());
     case NetVariantType::QString:
         return asQString();
     }
 }
 
-void NetVariant::construct(NetVariant&& other)
-{
-    switch (other._type) {
-    case NetVariantType::Bool:
-        *cast<bool>() = *other.cast<bool>();
-        break;
-    case NetVariantType::Int:
-        *cast<std::int64_t>() = *other.cast<std::int64_t>();
-        break;
-    case NetVariantType::Uint:
-        *cast<std::uint64_t>() = *other.cast<std::uint64_t>();
-        break;
-    case NetVariantType::Float:
-        *cast<float>() = *other.cast<float>();
-        break;
-    case NetVariantType::Double:
-        *cast<double>() = *other.cast<double>();
-        break;
-    case NetVariantType::String:
-        new (cast<std::string>()) std::string(std::move(*other.cast<std::string>()));
-        break;
-    case NetVariantType::QString:
-        new (cast<QString>()) QString(std::move(*other.cast<QString>()));
-        break;
-    }
-    _type = other._type;
-    other._type = NetVariantType::None;
-}
-
-void NetVariant::destruct()
-{
-    switch (_type) {
-    case NetVariantType::String:
-        cast<std::string>()->~basic_string<char>();
-        break;
-    case NetVariantType::QString:
-        cast<QString>()->~QString();
-        break;
-    }
-}
-
-NetVariant& NetVariant::operator=(const NetVariant& other)
-{
-    destruct();
-    construct(other);
-    return *this;
-}
-
-NetVariant& NetVariant::operator=(NetVariant&& other)
-{
-    destruct();
-    construct(std::move(other));
-    return *this;
-}
-
 void NetVariant::serialize(std::string* dest) const
 {
     std::uint8_t header = (std::uint8_t)_type;
+    std::size_t offset = dest->size();
     bmcl::MemWriter result((void*)dest->data(), dest->size()); // в с++11 строки представлены 1 куском в памяти
 
-    auto reserve = [&result, dest, header](std::size_t size) {
-        dest->resize(dest->size() + size + 1);
-        result = bmcl::MemWriter((void*)dest->data(), dest->size()); // HACK: после resize может быть realloc
+    // значение дописывается в конец dest
+    auto reserve = [&result, dest, header, offset](std::size_t size) {
+        dest->resize(offset + size + 1);
+        result = bmcl::MemWriter((void*)(dest->data() + offset), size + 1); // HACK: после resize может быть realloc
         result.writeUint8(header);
     };
 
@@ -203,10 +158,10 @@ void NetVariant::serialize(std::string* dest) const
         result.writeFloat64Le(asDouble());
         break;
     case NetVariantType::String: {
-        const std::string& str = asString();
-        reserve(8 + str.size() + 1);
-        result.writeUint64Le(str.size() + 1);
-        result.write(str.data(), str.size());
+        std::size_t size = stringSize();
+        reserve(8 + size);
+        result.writeUint64Le(size);
+        result.write(stringData(), size);
         break;
     }
     case NetVariantType::QString: {
@@ -234,9 +189,17 @@ bmcl::Result<NetVariant, NetVariantError> NetVariant::deserialize(bmcl::MemReade
     NetVariantType type = (NetVariantType)src->readUint8();
 
     std::size_t size;
-    if (type == NetVariantType::Float) {
+    switch (type) {
+    case NetVariantType::None:
+        size = 0;
+        break;
+    case NetVariantType::Bool:
+        size = 1;
+        break;
+    case NetVariantType::Float:
         size = 4;
-    } else {
+        break;
+    default:
         size = 8;
     }
 
@@ -248,13 +211,13 @@ bmcl::Result<NetVariant, NetVariantError> NetVariant::deserialize(bmcl::MemReade
     case NetVariantType::None:
         return NetVariant();
     case NetVariantType::Bool:
-        return NetVariant(src->readUint8());
+        return NetVariant(src->readUint8() != 0);
     case NetVariantType::Int:
         return NetVariant(src->readInt64Le());
     case NetVariantType::Uint:
         return NetVariant(src->readUint64Le());
     case NetVariantType::Float:
-        return NetVariant(src->readFloat32Be());
+        return NetVariant(src->readFloat32Le());
     case NetVariantType::Double:
         return NetVariant(src->readFloat64Le());
     case NetVariantType::String: {
@@ -309,7 +272,7 @@ T NetVariant::to(S stringConverter, Q qstringConverter) const
     }
 }
 
-std::int64_t NetVariant::toInt() const
+std::int64_t NetVariant::toIntSlow() const
 {
     return to<std::int64_t>([](const std::string& str) {
         return std::stoll(str);
@@ -318,7 +281,7 @@ std::int64_t NetVariant::toInt() const
     });
 }
 
-std::uint64_t NetVariant::toUint() const
+std::uint64_t NetVariant::toUintSlow() const
 {
     return to<std::uint64_t>([](const std::string& str) {
         return std::stoull(str);
@@ -327,16 +290,7 @@ std::uint64_t NetVariant::toUint() const
     });
 }
 
-float NetVariant::toFloat() const
-{
-    return to<float>([](const std::string& str) {
-        return std::stof(str);
-    }, [](const QString& str, bool* isOK) {
-        return str.toFloat(isOK);
-    });
-}
-
-double NetVariant::toDouble() const
+double NetVariant::toDoubleSlow() const
 {
     return to<double>([](const std::string& str) {
         return std::stod(str);
@@ -354,7 +308,7 @@ QVariant NetVariant::toQVariant() const
     case mcc::misc::NetVariantType::Uint: return QVariant((qulonglong)asUint());
     case mcc::misc::NetVariantType::Float: return QVariant(asFloat());
     case mcc::misc::NetVariantType::Double: return QVariant(asDouble());
-    case mcc::misc::NetVariantType::String: return QVariant(QString::fromStdString(asString()));
+    case mcc::misc::NetVariantType::String: return QVariant(QString::fromUtf8(stringData(), (int)stringSize()));
     case mcc::misc::NetVariantType::QString: return QVariant(asQString());
     }
     return QVariant();
@@ -12,6 +12,7 @@
 #include <QVariant>
 
 #include <algorithm>
+#include <cstring>
 #include <string>
 #include <type_traits>
 #include <cstdint>
@@ -45,8 +46,12 @@ private:
 enum class NetVariantType : std::uint8_t { None, Bool, Int, Uint, Float, Double, String, QString };
 enum class NetVariantError { InvalidHeader, InvalidSize };
 
+// Numbers and strings up to smallStringCapacity bytes are stored inline and copied with
+// a plain memcpy, longer strings and QString live on the heap and take the slow path.
 class NetVariant {
 public:
+    static const std::size_t smallStringCapacity = 22;
+
     NetVariant();
     NetVariant(bool value);
     NetVariant(std::int8_t value);
@@ -59,8 +64,8 @@ public:
     NetVariant(std::uint64_t value);
     NetVariant(float value);
     NetVariant(double value);
+    NetVariant(const char* value);
     NetVariant(const std::string& value);
-    NetVariant(std::string&& value);
     NetVariant(const QString& value);
     NetVariant(QString&& value);
     NetVariant(const QVariant& value);
@@ -68,8 +73,6 @@ public:
     NetVariant(NetVariant&& other);
     ~NetVariant();
 
-    // TODO: serialize, deserialize
-
     NetVariantType type() const;
     bool isBool() const;
     bool isFloat() const;
@@ -78,14 +81,18 @@ public:
     bool isUint() const;
     bool isString() const;
     bool isQString() const;
+    // true if copying the value doesn't allocate
+    bool isInline() const;
 
     bool asBool() const;
     std::int64_t asInt() const;
     std::uint64_t asUint() const;
     float asFloat() const;
     double asDouble() const;
-    const std::string& asString() const;
-    std::string&& asString();
+    std::string asString() const;
+    // string value without copying, not null terminated
+    const char* stringData() const;
+    std::size_t stringSize() const;
     const QString& asQString() const;
     QString&& asQString();
 
@@ -95,6 +102,12 @@ public:
     double toDouble() const;
     QVariant toQVariant() const;
 
+    // numeric value as stored: integers and double as is, float in the low 4 bytes, bool as 0 or 1;
+    // used by the batch codecs to move numbers without a switch on the type
+    std::uint64_t numericBits() const;
+    static NetVariant fromNumericBits(NetVariantType type, std::uint64_t value);
+    static bool isNumeric(NetVariantType type);
+
     std::string stringify() const;
     QString qstringify() const;
 
@@ -106,9 +119,21 @@ public:
     NetVariant& operator=(NetVariant&& other);
 
 private:
+    struct SmallString {
+        char data[smallStringCapacity + 1];
+        std::uint8_t size;
+    };
+
+    struct HeapString {
+        char* data;
+        std::size_t size;
+    };
+
     void destruct();
     void construct(const NetVariant& other);
     void construct(NetVariant&& other);
+    void constructSlow(const NetVariant& other);
+    void initString(const char* data, std::size_t size);
 
     template <typename T>
     T* cast();
@@ -120,98 +145,112 @@ private:
     const T* cast() const;
 
     template <typename T>
-    void init(T&& value, NetVariantType type);
+    void initNumber(T value, NetVariantType type);
+
+    std::uint64_t bits() const;
+    // floating point and string values
+    std::uint64_t toUintSlow() const;
+    std::int64_t toIntSlow() const;
+    double toDoubleSlow() const;
 
-    AlignedUnion<std::int64_t, std::uint64_t, float, double, std::string, QString> _data;
+    AlignedUnion<std::int64_t, std::uint64_t, float, double, SmallString, HeapString, QString> _data;
     NetVariantType _type;
+    bool _isHeap;
 };
 
 template <typename T>
-inline void NetVariant::init(T&& value, NetVariantType type)
+inline void NetVariant::initNumber(T value, NetVariantType type)
 {
-    typedef typename std::decay<T>::type U;
-    new (cast<U>()) U(std::forward<T>(value));
+    // the unused bytes are zeroed so that the numeric fast paths can read all 8 bytes
+    std::uint64_t zero = 0;
+    std::memcpy(cast<char>(), &zero, sizeof(zero));
+    std::memcpy(cast<char>(), &value, sizeof(value));
     _type = type;
+    _isHeap = false;
 }
 
 inline NetVariant::NetVariant()
-    : _type(NetVariantType::None)
 {
+    initNumber<std::uint64_t>(0, NetVariantType::None);
 }
 
 inline NetVariant::NetVariant(bool value)
 {
-    init(value, NetVariantType::Bool);
+    initNumber(value, NetVariantType::Bool);
 }
 
 inline NetVariant::NetVariant(std::int8_t value)
 {
-    init(std::int64_t(value), NetVariantType::Int);
+    initNumber(std::int64_t(value), NetVariantType::Int);
 }
 
 inline NetVariant::NetVariant(std::int16_t value)
 {
-    init(std::int64_t(value), NetVariantType::Int);
+    initNumber(std::int64_t(value), NetVariantType::Int);
 }
 
 inline NetVariant::NetVariant(std::int32_t value)
 {
-    init(std::int64_t(value), NetVariantType::Int);
+    initNumber(std::int64_t(value), NetVariantType::Int);
 }
 
 inline NetVariant::NetVariant(std::int64_t value)
 {
-    init(value, NetVariantType::Int);
+    initNumber(value, NetVariantType::Int);
 }
 
 inline NetVariant::NetVariant(std::uint8_t value)
 {
-    init(std::uint64_t(value), NetVariantType::Uint);
+    initNumber(std::uint64_t(value), NetVariantType::Uint);
 }
 
 inline NetVariant::NetVariant(std::uint16_t value)
 {
-    init(std::uint64_t(value), NetVariantType::Uint);
+    initNumber(std::uint64_t(value), NetVariantType::Uint);
 }
 
 inline NetVariant::NetVariant(std::uint32_t value)
 {
-    init(std::uint64_t(value), NetVariantType::Uint);
+    initNumber(std::uint64_t(value), NetVariantType::Uint);
 }
 
 inline NetVariant::NetVariant(std::uint64_t value)
 {
-    init(value, NetVariantType::Uint);
+    initNumber(value, NetVariantType::Uint);
 }
 
 inline NetVariant::NetVariant(float value)
 {
-    init(value, NetVariantType::Float);
+    initNumber(value, NetVariantType::Float);
 }
 
 inline NetVariant::NetVariant(double value)
 {
-    init(value, NetVariantType::Double);
+    initNumber(value, NetVariantType::Double);
 }
 
-inline NetVariant::NetVariant(const std::string& value)
+inline NetVariant::NetVariant(const char* value)
 {
-    init(value, NetVariantType::String);
+    initString(value, std::strlen(value));
 }
 
-inline NetVariant::NetVariant(std::string&& value)
+inline NetVariant::NetVariant(const std::string& value)
 {
-    init(std::move(value), NetVariantType::String);
+    initString(value.data(), value.size());
 }
 
 inline NetVariant::NetVariant(const QString& value)
 {
-    init(value, NetVariantType::QString);
+    new (cast<QString>()) QString(value);
+    _type = NetVariantType::QString;
+    _isHeap = true;
 }
 
 inline NetVariant::NetVariant(QString&& value)
 {
-    init(std::move(value), NetVariantType::QString);
+    new (cast<QString>()) QString(std::move(value));
+    _type = NetVariantType::QString;
+    _isHeap = true;
 }
 
 inline NetVariant::NetVariant(const NetVariant& other)
@@ -229,6 +268,56 @@ inline NetVariant::~NetVariant()
     destruct();
 }
 
+inline void NetVariant::destruct()
+{
+    if (_isHeap) {
+        if (_type == NetVariantType::QString) {
+            cast<QString>()->~QString();
+        } else {
+            delete[] cast<HeapString>()->data;
+        }
+    }
+}
+
+inline void NetVariant::construct(const NetVariant& other)
+{
+    if (!other._isHeap) {
+        std::memcpy(cast<char>(), other.cast<char>(), sizeof(_data));
+        _type = other._type;
+        _isHeap = false;
+        return;
+    }
+    constructSlow(other);
+}
+
+inline void NetVariant::construct(NetVariant&& other)
+{
+    // heap strings and QString (a single d pointer) are relocatable, the bytes move as they are
+    std::memcpy(cast<char>(), other.cast<char>(), sizeof(_data));
+    _type = other._type;
+    _isHeap = other._isHeap;
+    other._type = NetVariantType::None;
+    other._isHeap = false;
+}
+
+inline NetVariant& NetVariant::operator=(const NetVariant& other)
+{
+    if (this != &other) {
+        destruct();
+        construct(other);
+    }
+    return *this;
+}
+
+inline NetVariant& NetVariant::operator=(NetVariant&& other)
+{
+    if (this != &other) {
+        destruct();
+        construct(std::move(other));
+    }
+    return *this;
+}
+
 inline NetVariantType NetVariant::type() const
 {
     return _type;
@@ -269,6 +358,11 @@ inline bool NetVariant::isQString() const
     return _type == NetVariantType::QString;
 }
 
+inline bool NetVariant::isInline() const
+{
+    return !_isHeap;
+}
+
 template <typename T>
 inline T* NetVariant::cast()
 {
@@ -281,6 +375,13 @@ inline const T* NetVariant::cast() const
     return reinterpret_cast<const T*>(&_data);
 }
 
+inline std::uint64_t NetVariant::bits() const
+{
+    std::uint64_t value;
+    std::memcpy(&value, cast<char>(), sizeof(value));
+    return value;
+}
+
 inline bool NetVariant::asBool() const
 {
     assert(isBool());
@@ -311,16 +412,21 @@ inline double NetVariant::asDouble() const
     return *cast<double>();
 }
 
-inline const std::string& NetVariant::asString() const
+inline const char* NetVariant::stringData() const
 {
     assert(isString());
-    return *cast<std::string>();
+    return _isHeap ? cast<HeapString>()->data : cast<SmallString>()->data;
 }
 
-inline std::string&& NetVariant::asString()
+inline std::size_t NetVariant::stringSize() const
 {
     assert(isString());
-    return std::move(*cast<std::string>());
+    return _isHeap ? cast<HeapString>()->size : cast<SmallString>()->size;
+}
+
+inline std::string NetVariant::asString() const
+{
+    return std::string(stringData(), stringSize());
 }
 
 inline const QString& NetVariant::asQString() const
@@ -334,5 +440,75 @@ inline QString&& NetVariant::asQString()
     assert(isQString());
     return std::move(*cast<QString>());
 }
+
+inline bool NetVariant::isNumeric(NetVariantType type)
+{
+    return type >= NetVariantType::Bool && type <= NetVariantType::Double;
+}
+
+inline std::uint64_t NetVariant::numericBits() const
+{
+    assert(_type <= NetVariantType::Double);
+    return bits();
+}
+
+inline NetVariant NetVariant::fromNumericBits(NetVariantType type, std::uint64_t value)
+{
+    assert(type <= NetVariantType::Double);
+    NetVariant result;
+    switch (type) {
+    case NetVariantType::Bool:
+        result.initNumber(value != 0, type);
+        break;
+    case NetVariantType::Float:
+        result.initNumber(value & 0xffffffff, type);
+        break;
+    default:
+        result.initNumber(value, type);
+    }
+    return result;
+}
+
+// numbers are converted by picking from a table indexed by the type instead of a switch;
+// the unused bytes of the storage are zero, so every entry is computed from defined bits
+inline double NetVariant::toDouble() const
+{
+    if (_type > NetVariantType::Double) {
+        return toDoubleSlow();
+    }
+    std::uint64_t u = bits();
+    std::int64_t i = (std::int64_t)u;
+    float f;
+    double d;
+    std::memcpy(&f, cast<char>(), sizeof(f));
+    std::memcpy(&d, cast<char>(), sizeof(d));
+    const double values[] = {0.0, double(u), double(i), double(u), double(f), d};
+    return values[(std::size_t)_type];
+}
+
+inline std::uint64_t NetVariant::toUint() const
+{
+    if (_type > NetVariantType::Uint) {
+        return toUintSlow();
+    }
+    // None, Bool, Int and Uint share the same bits
+    return bits();
+}
+
+inline std::int64_t NetVariant::toInt() const
+{
+    if (_type > NetVariantType::Uint) {
+        return toIntSlow();
+    }
+    return (std::int64_t)bits();
+}
+
+inline float NetVariant::toFloat() const
+{
+    if (_type == NetVariantType::Float) {
+        return *cast<float>();
+    }
+    return (float)toDouble();
+}
 }
 }
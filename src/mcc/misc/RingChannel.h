@@ -0,0 +1,511 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <mcc/misc/Channel.h>
+#include <mcc/misc/Option.h>
+#include <mcc/misc/Result.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace mcc {
+namespace misc {
+
+enum class OverflowPolicy { Block, DropOldest, Reject };
+
+// Bounded multi-producer/single-consumer queue with the same interface as Channel.
+// Producers and the consumer never share a lock on the fast path; the mutex is taken
+// only to sleep or to wake up a side that is actually waiting.
+template <typename T>
+class RingChannel {
+public:
+    explicit RingChannel(std::size_t capacity = 1024, OverflowPolicy policy = OverflowPolicy::Block);
+    ~RingChannel();
+
+    template <typename... A>
+    bool sendEmplace(A&&... args);
+    bool send(const T& value);
+    bool send(T&& value);
+    mcc::misc::Option<T> recv();
+    mcc::misc::Result<T, ChannelError> tryRecv();
+    template <typename R, typename P>
+    mcc::misc::Result<T, ChannelError> tryRecvFor(const std::chrono::duration<R, P>& dur);
+    std::size_t recvAll(std::vector<T>* dest, std::size_t maxCount);
+    template <typename R, typename P>
+    std::size_t recvAllFor(std::vector<T>* dest, std::size_t maxCount, const std::chrono::duration<R, P>& dur);
+    void clear();
+    bool isEmpty() const;
+    std::size_t size() const;
+    std::size_t capacity() const { return _mask + 1; }
+    OverflowPolicy policy() const { return _policy; }
+    std::uint64_t droppedCount() const { return _dropped; }
+    void close();
+    void reopen();
+    bool isOpen() const { return _isOpen; }
+
+    RingChannel(const RingChannel&) = delete;
+    RingChannel(RingChannel&&) = delete;
+    RingChannel& operator=(const RingChannel&) = delete;
+    RingChannel& operator=(RingChannel&&) = delete;
+
+private:
+    static constexpr std::size_t cacheLineSize = 64;
+
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* value() { return reinterpret_cast<T*>(&storage); }
+    };
+
+    template <typename... A>
+    bool push(A&&... args);
+    Cell* claimPush(std::size_t* pos);
+    Cell* claimPop(std::size_t* pos);
+    T take(Cell* cell, std::size_t pos);
+    void discard(Cell* cell, std::size_t pos);
+    bool hasData() const;
+    bool hasSpace() const;
+    void dropOldest();
+    void waitForSpace();
+    void waitForData();
+    template <typename C, typename D>
+    bool waitForDataUntil(const std::chrono::time_point<C, D>& deadline);
+    void notifyConsumer();
+    void notifyProducers(bool force = false);
+    bool spinForData() const;
+
+    std::unique_ptr<Cell[]> _cells;
+    std::size_t _mask;
+    OverflowPolicy _policy;
+
+    alignas(cacheLineSize) std::atomic<std::size_t> _enqueuePos;
+    alignas(cacheLineSize) std::atomic<std::size_t> _dequeuePos;
+    alignas(cacheLineSize) std::atomic<std::size_t> _waitingConsumers;
+    std::atomic<std::size_t> _waitingProducers;
+    std::atomic<std::uint64_t> _dropped;
+    std::atomic<bool> _isOpen;
+
+    std::mutex _mutex;
+    std::condition_variable _dataAvailable;
+    std::condition_variable _spaceAvailable;
+};
+
+template <typename T>
+constexpr std::size_t RingChannel<T>::cacheLineSize;
+
+template <typename T>
+RingChannel<T>::RingChannel(std::size_t capacity, OverflowPolicy policy)
+    : _policy(policy)
+    , _enqueuePos(0)
+    , _dequeuePos(0)
+    , _waitingConsumers(0)
+    , _waitingProducers(0)
+    , _dropped(0)
+    , _isOpen(true)
+{
+    std::size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    _mask = size - 1;
+    _cells.reset(new Cell[size]);
+    for (std::size_t i = 0; i < size; i++) {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+inline RingChannel<T>::~RingChannel()
+{
+    close();
+}
+
+template <typename T>
+typename RingChannel<T>::Cell* RingChannel<T>::claimPush(std::size_t* pos)
+{
+    std::size_t current = _enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        Cell* cell = &_cells[current & _mask];
+        std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)current;
+        if (diff == 0) {
+            if (_enqueuePos.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+                *pos = current;
+                return cell;
+            }
+        } else if (diff < 0) {
+            return nullptr;
+        } else {
+            current = _enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// dequeue position is advanced with CAS so that producers can evict the oldest element
+// under OverflowPolicy::DropOldest without racing the consumer
+template <typename T>
+typename RingChannel<T>::Cell* RingChannel<T>::claimPop(std::size_t* pos)
+{
+    std::size_t current = _dequeuePos.load(std::memory_order_relaxed);
+    while (true) {
+        Cell* cell = &_cells[current & _mask];
+        std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)(current + 1);
+        if (diff == 0) {
+            if (_dequeuePos.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+                *pos = current;
+                return cell;
+            }
+        } else if (diff < 0) {
+            return nullptr;
+        } else {
+            current = _dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+inline T RingChannel<T>::take(Cell* cell, std::size_t pos)
+{
+    T value(std::move(*cell->value()));
+    discard(cell, pos);
+    return value;
+}
+
+template <typename T>
+inline void RingChannel<T>::discard(Cell* cell, std::size_t pos)
+{
+    cell->value()->~T();
+    cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+}
+
+template <typename T>
+inline bool RingChannel<T>::hasData() const
+{
+    std::size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+    std::size_t seq = _cells[pos & _mask].sequence.load(std::memory_order_acquire);
+    return (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1) >= 0;
+}
+
+template <typename T>
+inline bool RingChannel<T>::hasSpace() const
+{
+    std::size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    std::size_t seq = _cells[pos & _mask].sequence.load(std::memory_order_acquire);
+    return (std::ptrdiff_t)seq - (std::ptrdiff_t)pos >= 0;
+}
+
+template <typename T>
+inline void RingChannel<T>::notifyConsumer()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_waitingConsumers.load(std::memory_order_relaxed) != 0) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _dataAvailable.notify_one();
+    }
+}
+
+// blocked producers are woken only after the consumer has freed half of the ring,
+// otherwise every recv from a full channel would take the mutex
+template <typename T>
+inline void RingChannel<T>::notifyProducers(bool force)
+{
+    if (_policy != OverflowPolicy::Block) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_waitingProducers.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    if (force || size() <= capacity() / 2) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _spaceAvailable.notify_all();
+    }
+}
+
+template <typename T>
+bool RingChannel<T>::spinForData() const
+{
+    for (int i = 0; i < 16; i++) {
+        if (hasData() || !_isOpen) {
+            return true;
+        }
+        std::this_thread::yield();
+    }
+    return false;
+}
+
+template <typename T>
+void RingChannel<T>::waitForData()
+{
+    if (spinForData()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _waitingConsumers.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    _dataAvailable.wait(lock, [this]() { return hasData() || !_isOpen; });
+    _waitingConsumers.fetch_sub(1);
+}
+
+template <typename T>
+template <typename C, typename D>
+bool RingChannel<T>::waitForDataUntil(const std::chrono::time_point<C, D>& deadline)
+{
+    if (spinForData()) {
+        return true;
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _waitingConsumers.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool isReady = _dataAvailable.wait_until(lock, deadline, [this]() { return hasData() || !_isOpen; });
+    _waitingConsumers.fetch_sub(1);
+    return isReady;
+}
+
+template <typename T>
+void RingChannel<T>::waitForSpace()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _waitingProducers.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    _spaceAvailable.wait(lock, [this]() { return hasSpace() || !_isOpen; });
+    _waitingProducers.fetch_sub(1);
+}
+
+template <typename T>
+void RingChannel<T>::dropOldest()
+{
+    std::size_t pos;
+    Cell* cell = claimPop(&pos);
+    if (!cell) {
+        // slot is claimed by the consumer but not yet released
+        std::this_thread::yield();
+        return;
+    }
+    discard(cell, pos);
+    _dropped++;
+}
+
+template <typename T>
+template <typename... A>
+bool RingChannel<T>::push(A&&... args)
+{
+    while (_isOpen) {
+        std::size_t pos;
+        Cell* cell = claimPush(&pos);
+        if (cell) {
+            new (cell->value()) T(std::forward<A>(args)...);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            notifyConsumer();
+            return true;
+        }
+        switch (_policy) {
+        case OverflowPolicy::Block:
+            waitForSpace();
+            break;
+        case OverflowPolicy::DropOldest:
+            dropOldest();
+            break;
+        case OverflowPolicy::Reject:
+            _dropped++;
+            return false;
+        }
+    }
+    return false;
+}
+
+template <typename T>
+template <typename... A>
+inline bool RingChannel<T>::sendEmplace(A&&... args)
+{
+    return push(std::forward<A>(args)...);
+}
+
+template <typename T>
+inline bool RingChannel<T>::send(const T& value)
+{
+    return push(value);
+}
+
+template <typename T>
+inline bool RingChannel<T>::send(T&& value)
+{
+    return push(std::move(value));
+}
+
+template <typename T>
+mcc::misc::Option<T> RingChannel<T>::recv()
+{
+    while (_isOpen) {
+        std::size_t pos;
+        Cell* cell = claimPop(&pos);
+        if (cell) {
+            mcc::misc::Option<T> res(take(cell, pos));
+            notifyProducers();
+            return res;
+        }
+        waitForData();
+    }
+    return None;
+}
+
+template <typename T>
+mcc::misc::Result<T, ChannelError> RingChannel<T>::tryRecv()
+{
+    if (!_isOpen) {
+        return ChannelError::Closed;
+    }
+    std::size_t pos;
+    Cell* cell = claimPop(&pos);
+    if (!cell) {
+        return ChannelError::Empty;
+    }
+    mcc::misc::Result<T, ChannelError> res(take(cell, pos));
+    notifyProducers();
+    return res;
+}
+
+template <typename T>
+template <typename R, typename P>
+mcc::misc::Result<T, ChannelError> RingChannel<T>::tryRecvFor(const std::chrono::duration<R, P>& dur)
+{
+    auto deadline = std::chrono::steady_clock::now() + dur;
+    while (_isOpen) {
+        std::size_t pos;
+        Cell* cell = claimPop(&pos);
+        if (cell) {
+            mcc::misc::Result<T, ChannelError> res(take(cell, pos));
+            notifyProducers();
+            return res;
+        }
+        if (!waitForDataUntil(deadline)) {
+            return ChannelError::Timeout;
+        }
+    }
+    return ChannelError::Closed;
+}
+
+template <typename T>
+std::size_t RingChannel<T>::recvAll(std::vector<T>* dest, std::size_t maxCount)
+{
+    std::size_t count = 0;
+    while (count < maxCount && _isOpen) {
+        std::size_t pos;
+        Cell* cell = claimPop(&pos);
+        if (!cell) {
+            break;
+        }
+        dest->push_back(take(cell, pos));
+        count++;
+    }
+    if (count != 0) {
+        notifyProducers();
+    }
+    return count;
+}
+
+template <typename T>
+template <typename R, typename P>
+std::size_t RingChannel<T>::recvAllFor(std::vector<T>* dest, std::size_t maxCount,
+                                       const std::chrono::duration<R, P>& dur)
+{
+    auto deadline = std::chrono::steady_clock::now() + dur;
+    while (_isOpen) {
+        std::size_t count = recvAll(dest, maxCount);
+        if (count != 0) {
+            return count;
+        }
+        if (!waitForDataUntil(deadline)) {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+template <typename T>
+void RingChannel<T>::clear()
+{
+    std::size_t pos;
+    while (Cell* cell = claimPop(&pos)) {
+        discard(cell, pos);
+    }
+    notifyProducers(true);
+}
+
+template <typename T>
+inline bool RingChannel<T>::isEmpty() const
+{
+    return !hasData();
+}
+
+template <typename T>
+inline std::size_t RingChannel<T>::size() const
+{
+    std::size_t head = _dequeuePos.load(std::memory_order_relaxed);
+    std::size_t tail = _enqueuePos.load(std::memory_order_relaxed);
+    return tail > head ? tail - head : 0;
+}
+
+template <typename T>
+void RingChannel<T>::close()
+{
+    _isOpen = false;
+    clear();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _dataAvailable.notify_all();
+    _spaceAvailable.notify_all();
+}
+
+template <typename T>
+inline void RingChannel<T>::reopen()
+{
+    _isOpen = true;
+}
+
+template <typename T>
+using RingChannelPtr = std::shared_ptr<RingChannel<T>>;
+
+template <typename T>
+using RingSender = Sender<T, RingChannel<T>>;
+
+template <typename T>
+using RingReciever = Reciever<T, RingChannel<T>>;
+
+template <typename T>
+struct RingChannelPair {
+    RingChannelPair()
+    {
+    }
+
+    RingChannelPair(const RingChannelPtr<T>& chan)
+        : sender(chan)
+        , reciever(chan)
+    {
+    }
+
+    RingSender<T> sender;
+    RingReciever<T> reciever;
+};
+
+template <typename T>
+inline RingChannelPair<T> makeRingChannel(std::size_t capacity = 1024, OverflowPolicy policy = OverflowPolicy::Block)
+{
+    RingChannelPtr<T> chan = std::make_shared<RingChannel<T>>(capacity, policy);
+    return RingChannelPair<T>(chan);
+}
+}
+}
@@ -3,12 +3,15 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <cassert>
 #include <mutex>
 #include <future>
 #include <string>
+#include <functional>
 #include <condition_variable>
 #include <QThread>
 #include <QDebug>
+#include "mcc/misc/Executor.h"
 
 namespace mcc {
 namespace misc {
@@ -16,7 +19,7 @@ namespace misc {
 class Runnable
 {
 public:
-    virtual ~Runnable() { assert(!isRunning_()); }
+    virtual ~Runnable();
     void finish(bool wait = false);
     const std::string& name() const { return _name; }
     bool isFinished() const;
@@ -24,10 +27,20 @@ public:
     template<typename T, typename... A>
     static std::unique_ptr<T> startInThread(A&&... args);
 
+    // Cooperative mode: pre/tick/post run as tasks on the executor, tick is not called
+    // in a loop but only after wakeup_() (e.g. from a channel waker) or wakeupAfter_().
+    // The executor must outlive the runnable.
+    template<typename T, typename... A>
+    static std::unique_ptr<T> startInExecutor(Executor* executor, A&&... args);
+
 protected:
     Runnable(const std::string& name) : _name(name) { _isRunning = true; }
     bool isRunning_() const { return _isRunning; }
     void stopRunning_() { _isRunning = false; }
+    bool isCooperative_() const { return _task != nullptr; }
+    void wakeup_();
+    void wakeupAfter_(Executor::Clock::duration delay);
+    std::function<void()> waker_() const;
     virtual bool pre() = 0;
     virtual void tick() = 0;
     virtual void post() = 0;
@@ -36,11 +49,35 @@ protected:
     std::condition_variable _wakeup;
 
 private:
+    // shared with everything that may wake the runnable up, so that late wakeups
+    // after destruction are harmless
+    struct CooperativeTask : public std::enable_shared_from_this<CooperativeTask>
+    {
+        CooperativeTask(Executor* executor, Runnable* self)
+            : _executor(executor), _self(self), _isScheduled(false), _isWoken(false)
+        {
+        }
+        void wakeup();
+        void run();
+
+        Executor*           _executor;
+        std::mutex          _selfMutex;
+        Runnable*           _self;
+        std::atomic<bool>   _isScheduled;
+        std::atomic<bool>   _isWoken;
+    };
+
     void run();
+    void step();
 
     std::string                 _name;
     mutable std::future<void>   _future;
     std::atomic<bool>           _isRunning;
+
+    std::shared_ptr<CooperativeTask> _task;
+    std::promise<void>          _done;
+    bool                        _isStarted = false;
+    bool                        _isDone = false;
 };
 
 template<typename T, typename... A>
@@ -51,12 +88,135 @@ inline std::unique_ptr<T> Runnable::startInThread(A&&... args)
     return ptr;
 }
 
+template<typename T, typename... A>
+inline std::unique_ptr<T> Runnable::startInExecutor(Executor* executor, A&&... args)
+{
+    auto ptr = std::unique_ptr<T>(new T(std::forward<A>(args)...));
+    Runnable* self = ptr.get();
+    self->_task = std::make_shared<CooperativeTask>(executor, self);
+    self->_future = self->_done.get_future();
+    self->wakeup_();
+    return ptr;
+}
+
+inline Runnable::~Runnable()
+{
+    assert(!isRunning_());
+    if (_task)
+    {
+        std::lock_guard<std::mutex> lock(_task->_selfMutex);
+        _task->_self = nullptr;
+    }
+}
+
+inline void Runnable::CooperativeTask::wakeup()
+{
+    _isWoken = true;
+    if (!_isScheduled.exchange(true))
+    {
+        auto task = shared_from_this();
+        _executor->post([task]() { task->run(); });
+    }
+}
+
+inline void Runnable::CooperativeTask::run()
+{
+    _isWoken = false;
+    {
+        std::lock_guard<std::mutex> lock(_selfMutex);
+        if (_self)
+            _self->step();
+    }
+    _isScheduled = false;
+    if (_isWoken && !_isScheduled.exchange(true))
+    {
+        auto task = shared_from_this();
+        _executor->post([task]() { task->run(); });
+    }
+}
+
+inline void Runnable::wakeup_()
+{
+    if (_task)
+        _task->wakeup();
+}
+
+inline void Runnable::wakeupAfter_(Executor::Clock::duration delay)
+{
+    if (!_task)
+        return;
+    std::weak_ptr<CooperativeTask> task = _task;
+    _task->_executor->postAfter(delay, [task]() {
+        auto p = task.lock();
+        if (p)
+            p->wakeup();
+    });
+}
+
+inline std::function<void()> Runnable::waker_() const
+{
+    std::weak_ptr<CooperativeTask> task = _task;
+    return [task]() {
+        auto p = task.lock();
+        if (p)
+            p->wakeup();
+    };
+}
+
+inline void Runnable::step()
+{
+    if (_isDone)
+        return;
+    try
+    {
+        if (!_isStarted)
+        {
+            _isStarted = true;
+            qDebug() << QString::fromStdString(_name) << "started";
+            if (!pre())
+            {
+                post();
+                _isDone = true;
+                _done.set_value();
+                return;
+            }
+            qDebug() << QString::fromStdString(_name) << "inited";
+        }
+
+        if (_isRunning)
+            tick();
+
+        if (!_isRunning)
+        {
+            post();
+            qDebug() << QString::fromStdString(_name) << "finished";
+            _isDone = true;
+            _done.set_value();
+        }
+    }
+    catch (std::exception& e)
+    {
+        Q_UNUSED(e);
+
+        assert(false);
+        _isDone = true;
+        _done.set_value();
+    }
+    catch (...)
+    {
+        assert(false);
+        _isDone = true;
+        _done.set_value();
+    }
+}
+
 inline void Runnable::finish(bool wait)
 {
     if (isFinished())
         return;
     _isRunning = false;
     _wakeup.notify_all();
+    wakeup_();
     if (!wait)
         return;
     if (_future.valid())
@@ -0,0 +1,275 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mcc/misc/ShmRing.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory counters must be lock free");
+
+namespace mcc {
+namespace misc {
+
+static const std::uint32_t ringMagic = 0x4d434352; // "MCCR"
+static const std::uint32_t ringVersion = 1;
+static const std::uint32_t wrapMarker = 0xffffffff;
+static const std::size_t frameAlign = 8;
+static const std::size_t cacheLine = 64;
+
+// head and tail count bytes since creation and only grow, offsets are taken modulo capacity;
+// the producer writes only head, the consumer writes only tail
+struct ShmRing::Header {
+    std::atomic<std::uint32_t> magic;
+    std::uint32_t version;
+    std::uint64_t capacity;
+    char padding1[cacheLine - 16];
+    std::atomic<std::uint64_t> head;
+    char padding2[cacheLine - 8];
+    std::atomic<std::uint64_t> tail;
+    char padding3[cacheLine - 8];
+};
+
+static std::size_t frameSize(std::size_t size)
+{
+    return (sizeof(std::uint32_t) + size + frameAlign - 1) & ~(frameAlign - 1);
+}
+
+static std::string systemError(const std::string& what, const std::string& name)
+{
+    return what + " " + name + ": " + std::strerror(errno);
+}
+
+// spin first, the other side is usually running on another core, then back off to sleeps
+template <typename F>
+static bool waitFor(std::chrono::milliseconds timeout, F&& tryOnce)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::chrono::microseconds sleep(50);
+    for (unsigned attempt = 0;; attempt++) {
+        if (tryOnce()) {
+            return true;
+        }
+        if (attempt < 64) {
+            continue;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        if (attempt < 128) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::this_thread::sleep_for(sleep);
+        if (sleep < std::chrono::milliseconds(1)) {
+            sleep *= 2;
+        }
+    }
+}
+
+ShmRing::ShmRing(const std::string& name, void* memory, std::size_t mappedSize, bool isOwner)
+    : _name(name)
+    , _memory(memory)
+    , _mappedSize(mappedSize)
+    , _isOwner(isOwner)
+    , _header(static_cast<Header*>(memory))
+    , _data(static_cast<std::uint8_t*>(memory) + sizeof(Header))
+    , _capacity(_header->capacity)
+    , _isBroken(false)
+{
+}
+
+#ifdef _WIN32
+
+ShmRing::~ShmRing()
+{
+}
+
+Result<ShmRingPtr, std::string> ShmRing::create(const std::string& name, std::size_t)
+{
+    return std::string("shared memory rings are not supported on this platform: ") + name;
+}
+
+Result<ShmRingPtr, std::string> ShmRing::open(const std::string& name)
+{
+    return std::string("shared memory rings are not supported on this platform: ") + name;
+}
+
+#else
+
+ShmRing::~ShmRing()
+{
+    munmap(_memory, _mappedSize);
+    if (_isOwner) {
+        shm_unlink(_name.c_str());
+    }
+}
+
+Result<ShmRingPtr, std::string> ShmRing::create(const std::string& name, std::size_t capacity)
+{
+    std::size_t rounded = 1024;
+    while (rounded < capacity) {
+        rounded *= 2;
+    }
+
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        return systemError("shm_open", name);
+    }
+    std::size_t mappedSize = sizeof(Header) + rounded;
+    if (ftruncate(fd, mappedSize) != 0) {
+        std::string error = systemError("ftruncate", name);
+        close(fd);
+        shm_unlink(name.c_str());
+        return error;
+    }
+    void* memory = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        std::string error = systemError("mmap", name);
+        shm_unlink(name.c_str());
+        return error;
+    }
+
+    Header* header = new (memory) Header;
+    header->version = ringVersion;
+    header->capacity = rounded;
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_relaxed);
+    // open() accepts the segment only after this store
+    header->magic.store(ringMagic, std::memory_order_release);
+    return ShmRingPtr(new ShmRing(name, memory, mappedSize, true));
+}
+
+Result<ShmRingPtr, std::string> ShmRing::open(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+        return systemError("shm_open", name);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        std::string error = systemError("fstat", name);
+        close(fd);
+        return error;
+    }
+    std::size_t mappedSize = info.st_size;
+    if (mappedSize < sizeof(Header)) {
+        close(fd);
+        return std::string("not initialized: ") + name;
+    }
+    void* memory = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        return systemError("mmap", name);
+    }
+
+    Header* header = static_cast<Header*>(memory);
+    if (header->magic.load(std::memory_order_acquire) != ringMagic || header->version != ringVersion
+        || header->capacity + sizeof(Header) != mappedSize || (header->capacity & (header->capacity - 1)) != 0) {
+        munmap(memory, mappedSize);
+        return std::string("not a ring or not initialized yet: ") + name;
+    }
+    return ShmRingPtr(new ShmRing(name, memory, mappedSize, false));
+}
+
+#endif
+
+std::size_t ShmRing::maxFrameSize() const
+{
+    // a frame that doesn't fit at the end is written from the start, so half of the ring
+    // is the most that is always possible
+    return _capacity / 2 - sizeof(std::uint32_t);
+}
+
+bool ShmRing::write(const void* data, std::size_t size)
+{
+    if (size > maxFrameSize()) {
+        return false;
+    }
+    std::uint64_t head = _header->head.load(std::memory_order_relaxed);
+    std::uint64_t tail = _header->tail.load(std::memory_order_acquire);
+    std::size_t offset = head & (_capacity - 1);
+    std::size_t contiguous = _capacity - offset;
+    std::size_t need = frameSize(size);
+    std::size_t total = need <= contiguous ? need : contiguous + need;
+    if (head + total - tail > _capacity) {
+        return false;
+    }
+
+    if (need > contiguous) {
+        std::memcpy(_data + offset, &wrapMarker, sizeof(wrapMarker));
+        head += contiguous;
+        offset = 0;
+    }
+    std::uint32_t frame = (std::uint32_t)size;
+    std::memcpy(_data + offset, &frame, sizeof(frame));
+    std::memcpy(_data + offset + sizeof(frame), data, size);
+    _header->head.store(head + need, std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::writeFor(const void* data, std::size_t size, std::chrono::milliseconds timeout)
+{
+    if (size > maxFrameSize()) {
+        return false;
+    }
+    return waitFor(timeout, [&]() { return write(data, size); });
+}
+
+bool ShmRing::read(std::vector<std::uint8_t>* frame)
+{
+    if (_isBroken) {
+        return false;
+    }
+    std::uint64_t tail = _header->tail.load(std::memory_order_relaxed);
+    std::uint64_t head = _header->head.load(std::memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+    // head and the frame lengths come from the other process, trust nothing that would
+    // make us read outside the ring or past what was published
+    if (head < tail || head - tail > _capacity) {
+        _isBroken = true;
+        return false;
+    }
+
+    std::size_t offset = tail & (_capacity - 1);
+    std::uint32_t size;
+    std::memcpy(&size, _data + offset, sizeof(size));
+    if (size == wrapMarker) {
+        tail += _capacity - offset;
+        offset = 0;
+        if (tail >= head) {
+            _isBroken = true;
+            return false;
+        }
+        std::memcpy(&size, _data, sizeof(size));
+    }
+    if (size > maxFrameSize() || offset + sizeof(size) + size > _capacity || tail + frameSize(size) > head) {
+        _isBroken = true;
+        return false;
+    }
+    frame->assign(_data + offset + sizeof(size), _data + offset + sizeof(size) + size);
+    _header->tail.store(tail + frameSize(size), std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::readFor(std::vector<std::uint8_t>* frame, std::chrono::milliseconds timeout)
+{
+    return waitFor(timeout, [&]() { return read(frame) || _isBroken; }) && !_isBroken;
+}
+}
+}
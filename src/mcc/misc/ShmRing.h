@@ -0,0 +1,71 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include "mcc/misc/Result.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mcc {
+namespace misc {
+
+class ShmRing;
+typedef std::shared_ptr<ShmRing> ShmRingPtr;
+
+// Single producer single consumer ring of variable size frames in a POSIX shared memory
+// segment. One process creates the segment, the other opens it by name; exactly one
+// thread writes and one thread reads, in the same or in different processes.
+// Frames are copied in and out, nothing in the segment points to process memory.
+class ShmRing {
+public:
+    // name is a shm_open name ("/mcc.db"), capacity is rounded up to a power of two;
+    // an existing segment with the same name is replaced
+    static Result<ShmRingPtr, std::string> create(const std::string& name, std::size_t capacity);
+    static Result<ShmRingPtr, std::string> open(const std::string& name);
+
+    // the creator also removes the name, processes that opened the segment keep using it
+    ~ShmRing();
+
+    ShmRing(const ShmRing&) = delete;
+    ShmRing& operator=(const ShmRing&) = delete;
+
+    // producer side, false if there is no room for the frame now
+    bool write(const void* data, std::size_t size);
+    // waits for room with backoff (spin, yield, short sleeps), false on timeout
+    bool writeFor(const void* data, std::size_t size, std::chrono::milliseconds timeout);
+
+    // consumer side, false if the ring is empty or broken
+    bool read(std::vector<std::uint8_t>* frame);
+    bool readFor(std::vector<std::uint8_t>* frame, std::chrono::milliseconds timeout);
+    // the other side left a frame that doesn't fit the ring (it crashed mid-write or the
+    // segment is corrupt); nothing is read from such a ring any more
+    bool isBroken() const { return _isBroken; }
+
+    std::size_t capacity() const { return _capacity; }
+    // frames larger than this never fit
+    std::size_t maxFrameSize() const;
+    const std::string& name() const { return _name; }
+
+private:
+    struct Header;
+
+    ShmRing(const std::string& name, void* memory, std::size_t mappedSize, bool isOwner);
+
+    std::string _name;
+    void* _memory;
+    std::size_t _mappedSize;
+    bool _isOwner;
+    Header* _header;
+    std::uint8_t* _data;
+    std::size_t _capacity;
+    bool _isBroken;
+};
+}
+}
@@ -0,0 +1,122 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace mcc {
+namespace misc {
+
+// Latest value holder for one writer thread and one reader thread (triple buffer).
+// Unlike SharedVar neither side ever waits: the writer overwrites values the reader
+// hasn't seen yet, the reader always gets the newest complete value. Works with any
+// copyable T, no locks and no allocations after construction.
+template <typename T>
+class SnapshotVar {
+public:
+    // every buffer is initialized with T(args...)
+    template <typename... A>
+    SnapshotVar(const A&... args)
+        : _middle(1)
+        , _back(2)
+        , _front(0)
+        , _version(0)
+    {
+        for (Slot& slot : _slots) {
+            slot.value = T(args...);
+        }
+    }
+
+    SnapshotVar(const SnapshotVar&) = delete;
+    SnapshotVar& operator=(const SnapshotVar&) = delete;
+
+    // writer side
+
+    void write(const T& value)
+    {
+        _slots[_back].value = value;
+        publish();
+    }
+
+    void write(T&& value)
+    {
+        _slots[_back].value = std::move(value);
+        publish();
+    }
+
+    // buffer for in place update, holds some older value, not the last written one
+    T& writeBuffer()
+    {
+        return _slots[_back].value;
+    }
+
+    void publish()
+    {
+        _version.fetch_add(1, std::memory_order_relaxed);
+        _back = _middle.exchange(_back | dirtyBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // reader side
+
+    bool hasUpdate() const
+    {
+        return (_middle.load(std::memory_order_relaxed) & dirtyBit) != 0;
+    }
+
+    // reference stays valid and unchanged until the next read() call
+    const T& read()
+    {
+        if (hasUpdate()) {
+            _front = _middle.exchange(_front, std::memory_order_acq_rel) & indexMask;
+        }
+        return _slots[_front].value;
+    }
+
+    // number of publish() calls, may be used to count skipped values
+    std::uint64_t version() const
+    {
+        return _version.load(std::memory_order_relaxed);
+    }
+
+private:
+    static const std::uint8_t dirtyBit = 4;
+    static const std::uint8_t indexMask = 3;
+    static const std::size_t cacheLine = 64;
+
+    struct Slot {
+        T value;
+        char padding[cacheLine];
+    };
+
+    Slot _slots[3];
+    std::atomic<std::uint8_t> _middle;
+    char _padding1[cacheLine];
+    std::uint8_t _back;
+    char _padding2[cacheLine];
+    std::uint8_t _front;
+    char _padding3[cacheLine];
+    std::atomic<std::uint64_t> _version;
+};
+
+template <typename T>
+const std::uint8_t SnapshotVar<T>::dirtyBit;
+
+template <typename T>
+const std::uint8_t SnapshotVar<T>::indexMask;
+
+template <typename T>
+using SnapshotVarPtr = std::shared_ptr<SnapshotVar<T>>;
+
+template <typename T, typename... A>
+SnapshotVarPtr<T> makeSnapshotVar(const A&... args)
+{
+    return std::make_shared<SnapshotVar<T>>(args...);
+}
+}
+}
@@ -5,8 +5,16 @@
 #pragma once
 
 #include <mcc/misc/Channel.h>
+#include <mcc/misc/Executor.h>
 
+#include <atomic>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace mcc {
@@ -98,5 +106,236 @@ void TaskPool<F>::mainLoop()
         task.unwrap()();
     }
 }
+
+class TaskCancelled : public std::exception {
+public:
+    const char* what() const noexcept override
+    {
+        return "task cancelled";
+    }
+};
+
+// Shared cancellation flag. A default constructed token is never cancelled,
+// copies of a token made by makeCancellationToken() share one flag.
+class CancellationToken {
+public:
+    CancellationToken() {}
+
+    void cancel()
+    {
+        if (_isCancelled) {
+            _isCancelled->store(true);
+        }
+    }
+
+    bool isCancelled() const
+    {
+        return _isCancelled && _isCancelled->load();
+    }
+
+private:
+    friend CancellationToken makeCancellationToken();
+
+    explicit CancellationToken(const std::shared_ptr<std::atomic<bool>>& flag)
+        : _isCancelled(flag)
+    {
+    }
+
+    std::shared_ptr<std::atomic<bool>> _isCancelled;
+};
+
+inline CancellationToken makeCancellationToken()
+{
+    return CancellationToken(std::make_shared<std::atomic<bool>>(false));
+}
+
+namespace detail {
+
+template <typename R>
+struct TaskState {
+    TaskState(Executor* executor, std::promise<R>* promise)
+        : executor(executor)
+        , future(promise->get_future().share())
+        , isDone(false)
+    {
+    }
+
+    void addContinuation(Executor::Task&& task, TaskPriority priority)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!isDone) {
+                continuations.emplace_back(std::move(task), priority);
+                return;
+            }
+        }
+        executor->post(std::move(task), priority);
+    }
+
+    void complete()
+    {
+        std::vector<std::pair<Executor::Task, TaskPriority>> tasks;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isDone = true;
+            tasks.swap(continuations);
+        }
+        for (auto& task : tasks) {
+            executor->post(std::move(task.first), task.second);
+        }
+    }
+
+    Executor* executor;
+    std::shared_future<R> future;
+    std::mutex mutex;
+    bool isDone;
+    std::vector<std::pair<Executor::Task, TaskPriority>> continuations;
+};
+
+template <typename R, typename C>
+void fulfil(std::promise<R>* promise, C& callable)
+{
+    promise->set_value(callable());
+}
+
+template <typename C>
+void fulfil(std::promise<void>* promise, C& callable)
+{
+    callable();
+    promise->set_value();
+}
+
+// the promise is owned only by the returned task, if the executor drops the task
+// on stop() the future gets broken_promise instead of blocking forever
+template <typename R, typename F>
+Executor::Task makeTask(const std::shared_ptr<TaskState<R>>& state, const std::shared_ptr<std::promise<R>>& promise,
+                        const std::shared_ptr<F>& callable, const CancellationToken& token)
+{
+    return [state, promise, callable, token]() {
+        if (token.isCancelled()) {
+            promise->set_exception(std::make_exception_ptr(TaskCancelled()));
+        } else {
+            try {
+                fulfil(promise.get(), *callable);
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        }
+        state->complete();
+    };
+}
+}
+
+// Result of FutureTaskPool::submit(). Unlike std::future it can be copied and
+// chained with then(), the continuation runs on the pool once the result is set.
+template <typename R>
+class TaskFuture {
+public:
+    TaskFuture() {}
+
+    bool isValid() const
+    {
+        return _state != nullptr;
+    }
+
+    bool isReady() const
+    {
+        return _state->future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    void wait() const
+    {
+        _state->future.wait();
+    }
+
+    // rethrows the task exception or TaskCancelled
+    auto get() const -> decltype(std::declval<const std::shared_future<R>&>().get())
+    {
+        return _state->future.get();
+    }
+
+    const std::shared_future<R>& future() const
+    {
+        return _state->future;
+    }
+
+    // callable gets the finished std::shared_future<R> of this task, including
+    // the failed and cancelled ones
+    template <typename C>
+    TaskFuture<typename std::result_of<typename std::decay<C>::type(const std::shared_future<R>&)>::type>
+        then(C&& callable, TaskPriority priority = TaskPriority::Normal,
+             const CancellationToken& token = CancellationToken()) const;
+
+private:
+    friend class FutureTaskPool;
+    template <typename>
+    friend class TaskFuture;
+
+    explicit TaskFuture(const std::shared_ptr<detail::TaskState<R>>& state)
+        : _state(state)
+    {
+    }
+
+    std::shared_ptr<detail::TaskState<R>> _state;
+};
+
+// TaskPool mode for the tasks that produce results. Runs on a work-stealing
+// Executor: tasks submitted from a worker stay in its local queue, idle workers steal,
+// higher priority lanes go first. A cancelled task is not run, its future throws TaskCancelled.
+class FutureTaskPool {
+public:
+    explicit FutureTaskPool(std::size_t nThreads = std::thread::hardware_concurrency())
+        : _executor(nThreads)
+    {
+    }
+
+    template <typename C>
+    TaskFuture<typename std::result_of<typename std::decay<C>::type()>::type>
+        submit(C&& callable, TaskPriority priority = TaskPriority::Normal,
+               const CancellationToken& token = CancellationToken());
+
+    // pending tasks are dropped, their futures throw std::future_error
+    void stop()
+    {
+        _executor.stop();
+    }
+
+    std::size_t threadCount() const
+    {
+        return _executor.threadCount();
+    }
+
+private:
+    Executor _executor;
+};
+
+template <typename C>
+TaskFuture<typename std::result_of<typename std::decay<C>::type()>::type>
+    FutureTaskPool::submit(C&& callable, TaskPriority priority, const CancellationToken& token)
+{
+    typedef typename std::decay<C>::type F;
+    typedef typename std::result_of<F()>::type R;
+    auto promise = std::make_shared<std::promise<R>>();
+    auto state = std::make_shared<detail::TaskState<R>>(&_executor, promise.get());
+    auto f = std::make_shared<F>(std::forward<C>(callable));
+    _executor.post(detail::makeTask(state, promise, f, token), priority);
+    return TaskFuture<R>(state);
+}
+
+template <typename R>
+template <typename C>
+TaskFuture<typename std::result_of<typename std::decay<C>::type(const std::shared_future<R>&)>::type>
+    TaskFuture<R>::then(C&& callable, TaskPriority priority, const CancellationToken& token) const
+{
+    typedef typename std::decay<C>::type F;
+    typedef typename std::result_of<F(const std::shared_future<R>&)>::type T;
+    auto promise = std::make_shared<std::promise<T>>();
+    auto state = std::make_shared<detail::TaskState<T>>(_state->executor, promise.get());
+    std::shared_future<R> previous = _state->future;
+    auto f = std::make_shared<F>(std::forward<C>(callable));
+    auto bound = std::make_shared<std::function<T()>>([previous, f]() { return (*f)(previous); });
+    _state->addContinuation(detail::makeTask(state, promise, bound, token), priority);
+    return TaskFuture<T>(state);
+}
 }
 }
@@ -0,0 +1,76 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "mcc/misc/TimeUtils.h"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+namespace mcc {
+namespace misc {
+
+struct Clock {
+    Clock()
+        : wall(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count())
+        , steady(std::chrono::steady_clock::now())
+    {
+    }
+
+    Timestamp wall;
+    std::chrono::steady_clock::time_point steady;
+};
+
+static const Clock& clock()
+{
+    static Clock start;
+    return start;
+}
+
+Timestamp currentTimestamp()
+{
+    const Clock& start = clock();
+    return start.wall + std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start.steady).count();
+}
+
+std::string formatTimestamp(Timestamp time)
+{
+    // splitting seconds into a date is the slow part, consecutive calls mostly fall into the same second
+    static thread_local std::time_t lastSeconds = -1;
+    // sized for six full ints so that snprintf can never truncate
+    static thread_local char prefix[6 * 11 + 5 + 1];
+
+    std::time_t seconds = (std::time_t)(time / 1000000000);
+    int millis = (int)(time % 1000000000 / 1000000);
+    if (time < 0 && millis != 0) {
+        seconds -= 1;
+        millis += 1000;
+    }
+    if (seconds != lastSeconds) {
+        std::tm local;
+#ifdef _WIN32
+        localtime_s(&local, &seconds);
+#else
+        localtime_r(&seconds, &local);
+#endif
+        std::snprintf(prefix, sizeof(prefix), "%04d-%02d-%02dT%02d:%02d:%02d",
+                      local.tm_year + 1900, local.tm_mon + 1, local.tm_mday, local.tm_hour, local.tm_min, local.tm_sec);
+        lastSeconds = seconds;
+    }
+    char buffer[sizeof(prefix) + 1 + 11];
+    int size = std::snprintf(buffer, sizeof(buffer), "%s.%03d", prefix, millis);
+    return std::string(buffer, size);
+}
+
+Timestamp parseTimestamp(const std::string& time)
+{
+    QDateTime dateTime = QDateTime::fromString(QString::fromStdString(time), dateSerializeFormat());
+    if (!dateTime.isValid()) {
+        return 0;
+    }
+    return dateTime.toMSecsSinceEpoch() * 1000000;
+}
+
+}
+}
@@ -3,6 +3,8 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #pragma once
+#include <cstdint>
+#include <string>
 #include <QString>
 #include <QDateTime>
 
@@ -20,5 +22,23 @@ static inline std::string currentDateTime()
     return QDateTime::currentDateTime().toString(dateSerializeFormat()).toStdString();
 }
 
+// nanoseconds since 1970-01-01 UTC
+typedef std::int64_t Timestamp;
+
+// system clock at process start plus steady_clock since then: cheap to get and never
+// goes back when the system clock is adjusted. Convert to text only for display and db.
+Timestamp currentTimestamp();
+
+// local time in dateSerializeFormat()
+std::string formatTimestamp(Timestamp time);
+
+// for older messages and files that carry the time as text, 0 if time can't be parsed
+Timestamp parseTimestamp(const std::string& time);
+
+static inline QDateTime toDateTime(Timestamp time)
+{
+    return QDateTime::fromMSecsSinceEpoch(time / 1000000);
+}
+
 
 }}
@@ -660,6 +660,8 @@ SimpleModel::SimpleModel(const mcc::messages::LocalRouterPtr& router, const std:
         , _connectionAvailable(true)
         , _accuracyM(30.)
 {
+    handle<mcc::messages::Cmd>();
+
     std::uniform_int_distribution<uint16_t> dist;
     for (auto& aRoute : _routes)
     {
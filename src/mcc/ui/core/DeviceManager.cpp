@@ -134,34 +134,10 @@ namespace mcc {
             {
                 using mcc::misc::TmParam;
 
-                emit(subscribeTmParam(TmParam(device->name(), "Device", "batteryLevel")));
-                emit(subscribeTmParam(TmParam(device->name(), "Device", "signalLevel")));
-
-                emit(subscribeTmParam(TmParam(device->name(), "Navigation.Motion", "latitude")));
-                emit(subscribeTmParam(TmParam(device->name(), "Navigation.Motion", "longitude")));
-                emit(subscribeTmParam(TmParam(device->name(), "Navigation.Motion", "altitude")));
-                emit(subscribeTmParam(TmParam(device->name(), "Navigation.Motion", "pitch")));
-                emit(subscribeTmParam(TmParam(device->name(), "Navigation.Motion", "roll")));
-                emit(subscribeTmParam(TmParam(device->name(), "Navigation.Motion", "heading")));
-                emit(subscribeTmParam(TmParam(device->name(), "Navigation.Motion", "throttle")));
-                emit(subscribeTmParam(TmParam(device->name(), "Navigation.Route", "nextPoint")));
-
-                for (int i = 1; i <= 6; ++i)
-                {
-                    auto trait = QString("Route.Point%1").arg(i);
-                    emit(subscribeTmParam(TmParam(device->name(), trait, "latitude")));
-                    emit(subscribeTmParam(TmParam(device->name(), trait, "longitude")));
-                    emit(subscribeTmParam(TmParam(device->name(), trait, "altitude")));
-                    emit(subscribeTmParam(TmParam(device->name(), trait, "speed")));
-                }
-
-                emit(subscribeTmParam(TmParam(device->name(), "Debug.Waypoint", "Latitude")));
-                emit(subscribeTmParam(TmParam(device->name(), "Debug.Waypoint", "Longitude")));
-                emit(subscribeTmParam(TmParam(device->name(), "Debug.Waypoint", "LatitudeDelta")));
-                emit(subscribeTmParam(TmParam(device->name(), "Debug.Waypoint", "LongitudeDelta")));
-                emit(subscribeTmParam(TmParam(device->name(), "Debug.Waypoint", "Angle")));
-                emit(subscribeTmParam(TmParam(device->name(), "Debug.Waypoint", "Distance")));
-                emit(subscribeTmParam(TmParam(device->name(), "Debug.Waypoint", "AngleDelta")));
+                //FlyingDevice::processTmParamList разбирает почти все параметры устройства
+                //(режим, точку упреждения, скорость, состояние...), поэтому подписываемся на всё
+                //устройство: пустой признак, как раньше, когда core.tm рассылал кадры целиком
+                emit(subscribeTmParam(TmParam(device->name(), QString(), QString())));
             }
 
             void DeviceManager::sendCmd(const mcc::misc::Cmd& cmd)
@@ -30,6 +30,31 @@ Service::Service(const mcc::messages::LocalRouterPtr& router)
     , _in(router->recv(mcc::Names::ui()))
     , _out(router->send(mcc::Names::ui()))
 {
+    handle<mcc::messages::SystemState>();
+    handle<mcc::messages::CmdState>();
+    handle<mcc::messages::DeviceActivate_Response>();
+    handle<mcc::messages::DeviceConnect_Response>();
+    handle<mcc::messages::DeviceDisconnect_Response>();
+    handle<mcc::messages::DeviceRegister_Response>();
+    handle<mcc::messages::DeviceList_Response>();
+    handle<mcc::messages::DeviceRegistered>();
+    handle<mcc::messages::DeviceUnRegistered>();
+    handle<mcc::messages::DeviceUnRegister_Response>();
+    handle<mcc::messages::DeviceUpdated>();
+    handle<mcc::messages::DeviceDescription_Response>();
+    handle<mcc::messages::DeviceFileLoad_Response>();
+    handle<mcc::messages::DeviceState_Response>();
+    handle<mcc::messages::Channel_Response>();
+    handle<mcc::messages::ChannelState_Response>();
+    handle<mcc::messages::TmParamSubscribe_Response>();
+    handle<mcc::messages::TmParamList>();
+    handle<mcc::messages::ProtocolList_Response>();
+    handle<mcc::messages::ProtocolDescription_Response>();
+    handle<mcc::messages::ProtocolForDevice_Response>();
+    handle<mcc::messages::ProtocolForDeviceRegister_Response>();
+    handle<mcc::messages::FirmwareDescription_Response>();
+    handle<mcc::messages::FirmwareRegistered>();
+
     qRegisterMetaType<mcc::misc::TmParam>();
     qRegisterMetaType<mcc::misc::Cmd>();
     qRegisterMetaType<mcc::misc::CmdCollationId>();
@@ -92,7 +117,7 @@ void Service::process(std::unique_ptr<mcc::messages::TmParamList>&& response)
         mcc::misc::TmParam param(device, std::move(trait), std::move(name), std::move(i.value()));
         params.emplace(std::move(full_name), std::move(param));
     }
-    emit tmParamList(QDateTime::fromString(QString::fromStdString(response->time()), mcc::misc::dateSerializeFormat()), params);
+    emit tmParamList(mcc::misc::toDateTime(response->sampleTime()), params);
 }
 
 void Service::process(std::unique_ptr<mcc::messages::CmdState>&& state)
@@ -103,7 +128,7 @@ void Service::process(std::unique_ptr<mcc::messages::CmdState>&& state)
 //     {
 //         response.push_back(QString::number(*(uint8_t*)i));
 //     }
-    emit cmdState(QDateTime::fromString(QString::fromStdString(state->time()), mcc::misc::dateSerializeFormat()), state->cmdId(), (mcc::misc::CmdState)state->state(), response, err);
+    emit cmdState(mcc::misc::toDateTime(state->time()), state->cmdId(), (mcc::misc::CmdState)state->state(), response, err);
 }
 
 void Service::process(std::unique_ptr<mcc::messages::Channel_Response>&& response)
@@ -150,13 +175,13 @@ void Service::process(std::unique_ptr<mcc::messages::ChannelState_Response>&& re
 
         state._stats._sentBytes = i._sent._bytes;
         state._stats._sentPackets = i._sent._packets;
-        state._stats._sent = QDateTime::fromString(QString::fromStdString(i._sent._time), mcc::misc::dateSerializeFormat());
+        state._stats._sent = mcc::misc::toDateTime(i._sent._time);
         state._stats._rcvdBytes = i._rcvd._bytes;
         state._stats._rcvdPackets = i._rcvd._packets;
-        state._stats._rcvd = QDateTime::fromString(QString::fromStdString(i._rcvd._time), mcc::misc::dateSerializeFormat());
+        state._stats._rcvd = mcc::misc::toDateTime(i._rcvd._time);
         state._stats._rcvdBadBytes = i._bad._bytes;
         state._stats._rcvdBadPackets = i._bad._packets;
-        state._stats._rcvdBad = QDateTime::fromString(QString::fromStdString(i._bad._time), mcc::misc::dateSerializeFormat());
+        state._stats._rcvdBad = mcc::misc::toDateTime(i._bad._time);
 
         list.push_back(state);
     }
@@ -176,13 +201,13 @@ void Service::process(std::unique_ptr<mcc::messages::DeviceState_Response>&& res
 
         state._stats._sentBytes = i._sent._bytes;
         state._stats._sentPackets = i._sent._packets;
-        state._stats._sent = QDateTime::fromString(QString::fromStdString(i._sent._time), mcc::misc::dateSerializeFormat());
+        state._stats._sent = mcc::misc::toDateTime(i._sent._time);
         state._stats._rcvdBytes = i._rcvd._bytes;
         state._stats._rcvdPackets = i._rcvd._packets;
-        state._stats._rcvd = QDateTime::fromString(QString::fromStdString(i._rcvd._time), mcc::misc::dateSerializeFormat());
+        state._stats._rcvd = mcc::misc::toDateTime(i._rcvd._time);
         state._stats._rcvdBadBytes = i._bad._bytes;
         state._stats._rcvdBadPackets = i._bad._packets;
-        state._stats._rcvdBad = QDateTime::fromString(QString::fromStdString(i._bad._time), mcc::misc::dateSerializeFormat());
+        state._stats._rcvdBad = mcc::misc::toDateTime(i._bad._time);
 
         for (const auto& j : i._files)
         {
@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -204,6 +205,106 @@ TEST(ChannelTest, clear)
     EXPECT_TRUE(channel.isEmpty());
 }
 
+TEST(ChannelTest, sendBatch)
+{
+    Channel<std::unique_ptr<int>> channel;
+    std::vector<std::unique_ptr<int>> values;
+    for (int i = 0; i < 5; i++) {
+        values.emplace_back(new int(i));
+    }
+    EXPECT_TRUE(channel.sendBatch(std::move(values)));
+    EXPECT_TRUE(values.empty());
+    EXPECT_EQ(5u, channel.size());
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(i, *channel.recv().unwrap());
+    }
+}
+
+TEST(ChannelTest, sendBatchRange)
+{
+    Channel<int> channel;
+    std::vector<int> values = {1, 2, 3};
+    channel.sendBatch(values.begin(), values.end());
+    channel.sendBatch(values.begin(), values.begin());
+    EXPECT_EQ(3u, channel.size());
+    EXPECT_EQ(3u, values.size());
+}
+
+TEST(ChannelTest, recvAll)
+{
+    Channel<int> channel;
+    for (int i = 0; i < 10; i++) {
+        channel.send(i);
+    }
+    std::vector<int> values;
+    EXPECT_EQ(4u, channel.recvAll(&values, 4));
+    EXPECT_EQ(6u, channel.recvAll(&values, 100));
+    EXPECT_EQ(0u, channel.recvAll(&values, 100));
+    ASSERT_EQ(10u, values.size());
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(i, values[i]);
+    }
+}
+
+TEST(ChannelTest, recvAllFor)
+{
+    Channel<int> channel;
+    std::vector<int> values;
+    EXPECT_EQ(0u, channel.recvAllFor(&values, 10, std::chrono::milliseconds(1)));
+    std::thread sender([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        std::vector<int> batch = {1, 2, 3};
+        channel.sendBatch(std::move(batch));
+    });
+    EXPECT_EQ(3u, channel.recvAllFor(&values, 10, std::chrono::seconds(10)));
+    sender.join();
+    channel.close();
+    EXPECT_EQ(0u, channel.recvAllFor(&values, 10, std::chrono::seconds(10)));
+}
+
+TEST(ChannelTest, update)
+{
+    Channel<int> channel;
+    channel.send(1);
+    channel.send(2);
+    bool isChanged = channel.update([](std::deque<int>* queue) {
+        queue->pop_front();
+        queue->push_back(3);
+        return true;
+    });
+    EXPECT_TRUE(isChanged);
+    EXPECT_FALSE(channel.update([](std::deque<int>*) { return false; }));
+    EXPECT_EQ(2, channel.recv().unwrap());
+    EXPECT_EQ(3, channel.recv().unwrap());
+}
+
+TEST(ChannelTest, waitForSpace)
+{
+    Channel<int> channel;
+    EXPECT_TRUE(channel.waitForSpace(1, std::chrono::milliseconds(1)));
+    channel.send(1);
+    channel.send(2);
+    EXPECT_FALSE(channel.waitForSpace(2, std::chrono::milliseconds(1)));
+    std::thread reciever([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        channel.recv();
+    });
+    EXPECT_TRUE(channel.waitForSpace(2, std::chrono::seconds(10)));
+    reciever.join();
+}
+
+TEST(ChannelTest, waitForSpaceClosed)
+{
+    Channel<int> channel;
+    channel.send(1);
+    std::thread closer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        channel.close();
+    });
+    EXPECT_FALSE(channel.waitForSpace(1, std::chrono::seconds(10)));
+    closer.join();
+}
+
 // пример использвания
 
 TEST(ChannelPairTest, basic)
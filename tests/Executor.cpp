@@ -0,0 +1,136 @@
+#include "mcc/misc/Executor.h"
+#include "mcc/misc/Runnable.h"
+#include "mcc/misc/Channel.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace mcc::misc;
+
+static void waitFor(const std::atomic<int>& value, int expected)
+{
+    auto start = std::chrono::steady_clock::now();
+    while (value != expected && std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+TEST(ExecutorTest, post)
+{
+    Executor executor(4);
+    std::atomic<int> counter(0);
+    for (int i = 0; i < 1000; i++) {
+        executor.post([&counter]() { counter++; });
+    }
+    waitFor(counter, 1000);
+    EXPECT_EQ(1000, counter);
+}
+
+TEST(ExecutorTest, postFromWorker)
+{
+    Executor executor(2);
+    std::atomic<int> counter(0);
+    executor.post([&]() {
+        for (int i = 0; i < 100; i++) {
+            executor.post([&counter]() { counter++; });
+        }
+    });
+    waitFor(counter, 100);
+    EXPECT_EQ(100, counter);
+}
+
+TEST(ExecutorTest, postAfter)
+{
+    Executor executor(1);
+    std::atomic<int> counter(0);
+    auto start = std::chrono::steady_clock::now();
+    executor.postAfter(std::chrono::milliseconds(50), [&counter]() { counter++; });
+    executor.postAfter(std::chrono::milliseconds(10), [&counter]() { counter++; });
+    waitFor(counter, 2);
+    EXPECT_EQ(2, counter);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+}
+
+TEST(ExecutorTest, stopDropsTimers)
+{
+    std::atomic<int> counter(0);
+    {
+        Executor executor(1);
+        executor.postAfter(std::chrono::seconds(100), [&counter]() { counter++; });
+    }
+    EXPECT_EQ(0, counter);
+}
+
+class Consumer : public Runnable {
+public:
+    Consumer(const ChannelPtr<int>& channel)
+        : Runnable("consumer")
+        , _ticks(0)
+        , _sum(0)
+        , _isPosted(false)
+        , _channel(channel)
+    {
+    }
+
+    ~Consumer()
+    {
+        finish(true);
+    }
+
+    std::atomic<int> _ticks;
+    std::atomic<int> _sum;
+    std::atomic<bool> _isPosted;
+
+protected:
+    bool pre() override
+    {
+        _channel->setWaker(waker_());
+        return true;
+    }
+
+    void tick() override
+    {
+        _ticks++;
+        while (true) {
+            auto m = _channel->tryRecv();
+            if (m.isErr()) {
+                return;
+            }
+            _sum += m.unwrap();
+        }
+    }
+
+    void post() override
+    {
+        _channel->setWaker(nullptr);
+        _isPosted = true;
+    }
+
+private:
+    ChannelPtr<int> _channel;
+};
+
+TEST(ExecutorTest, cooperativeRunnable)
+{
+    Executor executor(2);
+    ChannelPtr<int> channel = std::make_shared<Channel<int>>();
+    auto consumer = Runnable::startInExecutor<Consumer>(&executor, channel);
+    for (int i = 1; i <= 10; i++) {
+        channel->send(i);
+    }
+    waitFor(consumer->_sum, 55);
+    EXPECT_EQ(55, consumer->_sum);
+
+    // no sends - no ticks
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    int ticks = consumer->_ticks;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(ticks, consumer->_ticks);
+
+    consumer->finish(true);
+    EXPECT_TRUE(consumer->isFinished());
+    EXPECT_TRUE(consumer->_isPosted);
+    channel->send(1);
+}
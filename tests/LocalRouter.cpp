@@ -0,0 +1,277 @@
+#include "mcc/Names.h"
+#include "mcc/messages/LocalRouter.h"
+#include "mcc/messages/MessageSender.h"
+#include "mcc/messages/Device.h"
+#include "mcc/messages/Tm.h"
+#include "mcc/messages/ShmLink.h"
+#include "mcc/misc/Executor.h"
+
+#include <gtest/gtest.h>
+
+#include <future>
+#include <thread>
+
+using namespace mcc::messages;
+
+static MessagePtr makeTm(const std::string& device, const std::string& trait, int value)
+{
+    TmParams params;
+    params.emplace_back(trait, "status", mcc::misc::NetVariant(value));
+    return MessagePtr(new TmParamList(device, std::move(params)));
+}
+
+static MessagePtr makeLog(const std::string& action)
+{
+    return MessagePtr(new DeviceActionLog("kind", "name", action));
+}
+
+static StatQueue stat(const LocalRouter& router, const std::string& client)
+{
+    for (const auto& i : router.queueStats())
+    {
+        if (i._name == client)
+            return i;
+    }
+    return StatQueue();
+}
+
+TEST(LocalRouter, deliverUnknown)
+{
+    LocalRouter router;
+    EXPECT_FALSE(router.deliver("nobody", makeLog("a")));
+}
+
+TEST(LocalRouter, coalesceSameDevice)
+{
+    LocalRouter router;
+    router.add("db", 2);
+    auto queue = router.recv("db");
+
+    router.deliver("db", makeTm("a", "x", 1));
+    router.deliver("db", makeTm("b", "x", 1));
+    router.deliver("db", makeTm("a", "y", 2));
+    router.deliver("db", makeTm("a", "x", 3));
+    ASSERT_EQ(2u, queue->size());
+
+    auto first = queue->tryRecv().take();
+    const TmParamList* list = static_cast<const TmParamList*>(first.get());
+    EXPECT_EQ("a", list->device());
+    ASSERT_EQ(2u, list->params().size());
+    EXPECT_EQ("x", list->params()[0].trait());
+    EXPECT_EQ(3, list->params()[0].value().toInt());
+    EXPECT_EQ("y", list->params()[1].trait());
+
+    StatQueue s = stat(router, "db");
+    EXPECT_EQ(2u, s._coalesced);
+    EXPECT_EQ(0u, s._dropped);
+}
+
+TEST(LocalRouter, coalesceFallsBackToDropOldest)
+{
+    LocalRouter router;
+    router.add("db", 1);
+    auto queue = router.recv("db");
+
+    router.deliver("db", makeTm("a", "x", 1));
+    router.deliver("db", makeTm("b", "x", 2));
+    ASSERT_EQ(1u, queue->size());
+    auto m = queue->tryRecv().take();
+    EXPECT_EQ("b", static_cast<const TmParamList*>(m.get())->device());
+    EXPECT_EQ(1u, stat(router, "db")._dropped);
+}
+
+TEST(LocalRouter, dropOldestKeepsOtherTypes)
+{
+    LocalRouter router;
+    router.add("db", 2);
+    router.setPolicy(MessageType::TmParamList, QueuePolicy::DropOldest);
+    auto queue = router.recv("db");
+
+    router.deliver("db", makeLog("log"));
+    router.deliver("db", makeTm("a", "x", 1));
+    router.deliver("db", makeTm("a", "x", 2));
+    ASSERT_EQ(2u, queue->size());
+    EXPECT_EQ(DeviceActionLog::_message_name, queue->tryRecv().take()->message_name());
+    auto m = queue->tryRecv().take();
+    EXPECT_EQ(2, static_cast<const TmParamList*>(m.get())->params()[0].value().toInt());
+    EXPECT_EQ(1u, stat(router, "db")._dropped);
+}
+
+TEST(LocalRouter, dbKeepsEveryTmSample)
+{
+    LocalRouter router;
+    router.add(mcc::Names::coreDb(), 2);
+    router.add(mcc::Names::coreTm(), 2);
+    router.add("ui", 2);
+    EXPECT_EQ(QueuePolicy::Block, router.policy(mcc::Names::coreDb(), MessageType::TmParamList));
+    EXPECT_EQ(QueuePolicy::Block, router.policy(mcc::Names::coreTm(), MessageType::TmParamList));
+    EXPECT_EQ(QueuePolicy::Coalesce, router.policy("ui", MessageType::TmParamList));
+    auto db = router.recv(mcc::Names::coreDb());
+    auto ui = router.recv("ui");
+
+    for (int i = 0; i < 3; i++)
+    {
+        router.deliver(mcc::Names::coreDb(), makeTm("a", "x", i));
+        router.deliver("ui", makeTm("a", "x", i));
+    }
+    EXPECT_EQ(3u, db->size());
+    EXPECT_EQ(0u, stat(router, mcc::Names::coreDb())._coalesced);
+    EXPECT_EQ(1u, stat(router, mcc::Names::coreDb())._overflowed);
+    EXPECT_EQ(2u, ui->size());
+    EXPECT_EQ(1u, stat(router, "ui")._coalesced);
+}
+
+TEST(LocalRouter, clientPolicyOverridesDefault)
+{
+    LocalRouter router;
+    router.setPolicy("a", MessageType::DeviceActionLog, QueuePolicy::DropOldest);
+    router.add("a", 1);
+    router.add("b", 1);
+    router.setPolicy(MessageType::DeviceActionLog, QueuePolicy::Coalesce);
+    EXPECT_EQ(QueuePolicy::DropOldest, router.policy("a", MessageType::DeviceActionLog));
+    EXPECT_EQ(QueuePolicy::Coalesce, router.policy("b", MessageType::DeviceActionLog));
+}
+
+TEST(LocalRouter, reportsQueueSize)
+{
+    LocalRouter router;
+    router.add("ui", 10);
+    auto queue = router.recv("ui");
+    router.deliver("ui", makeLog("1"));
+    router.deliver("ui", makeLog("2"));
+    EXPECT_EQ(2u, router.queueSize(mcc::misc::NameTable::intern("ui")));
+    queue->tryRecv();
+    EXPECT_EQ(1u, router.queueSize(mcc::misc::NameTable::intern("ui")));
+    EXPECT_EQ(0u, router.queueSize(mcc::misc::NameTable::intern("nobody")));
+}
+
+TEST(LocalRouter, blockOverflowsAfterTimeout)
+{
+    LocalRouter router;
+    router.add("db", 1);
+    auto queue = router.recv("db");
+
+    router.deliver("db", makeLog("1"));
+    router.deliver("db", makeLog("2"));
+    EXPECT_EQ(2u, queue->size());
+    StatQueue s = stat(router, "db");
+    EXPECT_EQ(1u, s._blocked);
+    EXPECT_EQ(1u, s._overflowed);
+    EXPECT_EQ(0u, s._dropped);
+}
+
+TEST(LocalRouter, blockDoesNotWaitInExecutorTask)
+{
+    LocalRouter router;
+    router.add("db", 1);
+    auto queue = router.recv("db");
+    router.deliver("db", makeLog("1"));
+
+    mcc::misc::Executor executor(1);
+    std::promise<std::chrono::steady_clock::duration> elapsed;
+    executor.post([&]()
+    {
+        auto start = std::chrono::steady_clock::now();
+        router.deliver("db", makeLog("2"));
+        elapsed.set_value(std::chrono::steady_clock::now() - start);
+    });
+    EXPECT_LT(elapsed.get_future().get(), std::chrono::milliseconds(50));
+    EXPECT_EQ(2u, queue->size());
+    EXPECT_EQ(1u, stat(router, "db")._overflowed);
+}
+
+TEST(LocalRouter, blockWaitsForConsumer)
+{
+    LocalRouter router;
+    router.add("db", 1);
+    auto queue = router.recv("db");
+
+    router.deliver("db", makeLog("1"));
+    std::thread consumer([queue]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        queue->recv();
+    });
+    router.deliver("db", makeLog("2"));
+    consumer.join();
+    EXPECT_EQ(1u, queue->size());
+    StatQueue s = stat(router, "db");
+    EXPECT_EQ(1u, s._blocked);
+    EXPECT_EQ(0u, s._overflowed);
+}
+
+TEST(LocalRouter, senderDeliversDirectly)
+{
+    LocalRouter router;
+    router.add("a");
+    router.add("b");
+    auto sender = router.send("a");
+    auto queue = router.recv("b");
+
+    sender->sendTo("b", makeLog("direct"));
+    ASSERT_EQ(1u, queue->size());
+    auto message = queue->tryRecv().take();
+    EXPECT_EQ("a", message->sender());
+    EXPECT_EQ("b", message->receiver());
+
+    //неизвестные получатели и multicast остаются потоку роутера
+    sender->sendTo("nobody", makeLog("unknown"));
+    sender->sendTo(mcc::Names::multicast(), makeLog("all"));
+    EXPECT_EQ(0u, queue->size());
+}
+
+TEST(LocalRouter, rejectsUnhandledTypes)
+{
+    LocalRouter router;
+    router.add("a");
+    router.add("db");
+    auto queue = router.recv("db");
+    std::bitset<messageTypeCount> types;
+    types.set((std::size_t)MessageType::TmParamList);
+    router.setAccepted("db", types);
+
+    router.deliver("db", makeTm("a", "x", 1));
+    router.deliver("db", makeLog("ignored"));
+    auto sender = router.send("a");
+    sender->sendTo("db", makeLog("ignored"));
+
+    EXPECT_EQ(1u, queue->size());
+    EXPECT_EQ(2u, stat(router, "db")._rejected);
+}
+
+#ifndef _WIN32
+TEST(LocalRouter, remoteThroughSharedMemory)
+{
+    auto ring = mcc::misc::ShmRing::create("/mcc.test.localrouter", 1 << 16);
+    ASSERT_TRUE(ring.isOk()) << ring.unwrapErr();
+
+    //два роутера вместо двух процессов: "tm" живёт в первом, "db" - во втором
+    auto first = std::make_shared<LocalRouter>();
+    first->add("tm");
+    first->addRemote("db", ring.unwrap());
+    auto second = std::make_shared<LocalRouter>();
+    second->add("db");
+    auto queue = second->recv("db");
+    auto in = mcc::misc::ShmRing::open("/mcc.test.localrouter");
+    ASSERT_TRUE(in.isOk()) << in.unwrapErr();
+    ShmLink link(second, in.unwrap());
+
+    auto sender = first->send("tm");
+    sender->sendTo("db", makeLog("not serializable"));
+    sender->sendTo("db", makeTm("device", "trait", 42));
+
+    auto message = queue->tryRecvFor(std::chrono::seconds(5));
+    ASSERT_TRUE(message.isOk());
+    EXPECT_EQ("tm", message.unwrap()->sender());
+    EXPECT_EQ("db", message.unwrap()->receiver());
+    auto tm = dynamic_cast<const TmParamList*>(message.unwrap().get());
+    ASSERT_NE(nullptr, tm);
+    EXPECT_EQ("device", tm->device());
+    ASSERT_EQ(1u, tm->params().size());
+    EXPECT_EQ(42, tm->params()[0].value().toInt());
+
+    link.stop();
+    EXPECT_EQ(1u, link.received());
+    EXPECT_EQ(0u, link.broken());
+    EXPECT_EQ(1u, stat(*first, "db")._rejected);
+}
+#endif
@@ -0,0 +1,447 @@
+#include "mcc/messages/Tm.h"
+#include "mcc/messages/TmCodec.h"
+#include "mcc/messages/protobuf/Message.pb.h"
+#include "mcc/messages/protobuf/Tm.pb.h"
+#include "mcc/messages/Cmd.h"
+#include "mcc/messages/Device.h"
+#include "mcc/messages/System.h"
+#include "mcc/messages/Trace.h"
+#include "mcc/messages/MessageSender.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace mcc::messages;
+
+static TmParams makeParams(int value)
+{
+    TmParams params;
+    params.emplace_back("trait", "status", mcc::misc::NetVariant(value));
+    return params;
+}
+
+TEST(TmParamList, cloneSharesParams)
+{
+    TmParamList list("device", makeParams(1));
+    auto clone = list.clone();
+    const TmParamList* cloned = static_cast<const TmParamList*>(clone.get());
+    EXPECT_EQ(list.sharedParams().get(), cloned->sharedParams().get());
+    EXPECT_EQ("device", cloned->device());
+}
+
+TEST(TmParamList, coalesceCopiesOnWrite)
+{
+    TmParamList list("device", makeParams(1));
+    auto clone = list.clone();
+    TmParamList newer("device", makeParams(2));
+
+    EXPECT_TRUE(clone->coalesce(newer));
+    const TmParamList* merged = static_cast<const TmParamList*>(clone.get());
+    EXPECT_EQ(2, merged->params()[0].value().toInt());
+    EXPECT_EQ(1, list.params()[0].value().toInt());
+    EXPECT_NE(list.sharedParams().get(), merged->sharedParams().get());
+}
+
+TEST(TmParamList, coalesceTakesNewerTime)
+{
+    MessageQueue queue = std::make_shared<MessageQueue::element_type>();
+    MessageSenderX sender("encoder", queue);
+    sender.sendTo("tm", MessagePtr(new TmParamList("device", makeParams(1))));
+    auto older = queue->tryRecv().take();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    sender.sendTo("tm", MessagePtr(new TmParamList("device", makeParams(2))));
+    auto newer = queue->tryRecv().take();
+    ASSERT_LT(older->time(), newer->time());
+
+    EXPECT_TRUE(older->coalesce(*newer));
+    EXPECT_EQ(newer->time(), older->time());
+    EXPECT_EQ(newer->time(), static_cast<const TmParamList*>(older.get())->sampleTime());
+}
+
+TEST(TmParamList, coalesceOtherDevice)
+{
+    TmParamList list("a", makeParams(1));
+    TmParamList newer("b", makeParams(2));
+    EXPECT_FALSE(list.coalesce(newer));
+    EXPECT_EQ(1, list.params()[0].value().toInt());
+}
+
+TEST(TmParamList, replayKeepsRecordedTime)
+{
+    TmParamList live("a", makeParams(1));
+    TmParamList replayed("a", makeParams(2), 1234);
+    EXPECT_FALSE(live.isReplay());
+    EXPECT_TRUE(replayed.isReplay());
+    EXPECT_EQ(1234, replayed.sampleTime());
+    EXPECT_FALSE(live.coalesce(replayed));
+
+    auto clone = replayed.cloneWith(replayed.sharedParams());
+    EXPECT_TRUE(clone->isReplay());
+    EXPECT_TRUE(clone->coalesce(TmParamList("a", makeParams(3), 5678)));
+    EXPECT_EQ(5678, clone->sampleTime());
+}
+
+static TmParams makeMixedParams()
+{
+    TmParams params;
+    params.emplace_back("nav", "lat", mcc::misc::NetVariant(55.75));
+    params.emplace_back("nav", "lon", mcc::misc::NetVariant(37.5f));
+    params.emplace_back("nav", "armed", mcc::misc::NetVariant(true));
+    params.emplace_back("power", "current", mcc::misc::NetVariant(std::int64_t(-12)));
+    params.emplace_back("power", "cycles", mcc::misc::NetVariant(std::uint64_t(1) << 40));
+    params.emplace_back("power", "unknown", mcc::misc::NetVariant());
+    params.emplace_back("nav", "mode", mcc::misc::NetVariant("auto"));
+    params.emplace_back("nav", "comment", mcc::misc::NetVariant(std::string(40, 'x')));
+    params.emplace_back("nav", "name", mcc::misc::NetVariant(QString::fromStdString("qstring")));
+    return params;
+}
+
+TEST(TmCodec, roundTripsAllTypes)
+{
+    TmParams params = makeMixedParams();
+    std::string buffer("prefix");
+    TmCodec::encode(params, &buffer);
+    EXPECT_EQ("prefix", buffer.substr(0, 6));
+
+    bmcl::MemReader reader((const std::uint8_t*)buffer.data() + 6, buffer.size() - 6);
+    auto result = TmCodec::decode(&reader);
+    ASSERT_TRUE(result.isOk());
+    EXPECT_EQ(0u, reader.readableSize());
+    const TmParams& decoded = result.unwrap();
+    ASSERT_EQ(params.size(), decoded.size());
+    for (std::size_t i = 0; i < params.size(); i++)
+    {
+        EXPECT_EQ(params[i].trait(), decoded[i].trait());
+        EXPECT_EQ(params[i].status(), decoded[i].status());
+    }
+    EXPECT_EQ(55.75, decoded[0].value().asDouble());
+    EXPECT_EQ(37.5f, decoded[1].value().asFloat());
+    EXPECT_TRUE(decoded[2].value().asBool());
+    EXPECT_EQ(-12, decoded[3].value().asInt());
+    EXPECT_EQ(std::uint64_t(1) << 40, decoded[4].value().asUint());
+    EXPECT_EQ(mcc::misc::NetVariantType::None, decoded[5].value().type());
+    EXPECT_EQ("auto", decoded[6].value().asString());
+    EXPECT_EQ(std::string(40, 'x'), decoded[7].value().asString());
+    ASSERT_TRUE(decoded[8].value().isString());
+    EXPECT_EQ("qstring", decoded[8].value().asString());
+}
+
+TEST(TmCodec, smallerThanPerValueProtobuf)
+{
+    TmParams params;
+    for (int i = 0; i < 40; i++)
+        params.emplace_back(i < 20 ? "navigation" : "power", "status" + std::to_string(i), mcc::misc::NetVariant(i * 0.5));
+
+    std::string packed;
+    TmCodec::encode(params, &packed);
+    mcc::protobuf::TmParamList perValue;
+    for (const auto& i : params)
+    {
+        auto param = perValue.add_params();
+        param->set_trait(i.trait());
+        param->set_status(i.status());
+        param->set_value(i.value().serialize());
+    }
+    EXPECT_LT(packed.size() * 5, perValue.ByteSize() * 4);
+}
+
+TEST(TmCodec, rejectsCorruptInput)
+{
+    std::string buffer;
+    TmCodec::encode(makeMixedParams(), &buffer);
+    for (std::size_t size = 0; size < buffer.size(); size++)
+    {
+        bmcl::MemReader reader((const std::uint8_t*)buffer.data(), size);
+        EXPECT_TRUE(TmCodec::decode(&reader).isErr()) << size;
+    }
+
+    //тип первого параметра лежит сразу за кучей строк
+    std::string badType = buffer;
+    std::uint32_t stringCount = (std::uint8_t)buffer[4];
+    std::size_t heapEnd = 9 + stringCount * 4;
+    std::uint32_t heapSize;
+    std::memcpy(&heapSize, buffer.data() + heapEnd - 4, 4);
+    badType[heapEnd + heapSize] = 42;
+    bmcl::MemReader typeReader((const std::uint8_t*)badType.data(), badType.size());
+    auto typeResult = TmCodec::decode(&typeReader);
+    ASSERT_TRUE(typeResult.isErr());
+    EXPECT_EQ(TmCodecError::InvalidType, typeResult.unwrapErr());
+
+    std::string badIndex = buffer;
+    std::size_t traitIndex = heapEnd + heapSize + makeMixedParams().size();
+    badIndex[traitIndex] = (char)0xff;
+    badIndex[traitIndex + 1] = (char)0xff;
+    bmcl::MemReader indexReader((const std::uint8_t*)badIndex.data(), badIndex.size());
+    auto indexResult = TmCodec::decode(&indexReader);
+    ASSERT_TRUE(indexResult.isErr());
+    EXPECT_EQ(TmCodecError::InvalidIndex, indexResult.unwrapErr());
+}
+
+TEST(TmParamList, readsPerValueEncoding)
+{
+    mcc::protobuf::TmParamList body;
+    body.set_device("device");
+    auto param = body.add_params();
+    param->set_trait("nav");
+    param->set_status("lat");
+    param->set_value(mcc::misc::NetVariant(55.75).serialize());
+    param = body.add_params();
+    param->set_trait("nav");
+    param->set_status("lon");
+    param->set_value(mcc::misc::NetVariant(37.5f).serialize());
+
+    auto message = TmParamList::deserialize(body);
+    ASSERT_TRUE(message != nullptr);
+    const TmParamList* list = static_cast<const TmParamList*>(message.get());
+    ASSERT_EQ(2u, list->params().size());
+    EXPECT_EQ(55.75, list->params()[0].value().asDouble());
+    EXPECT_EQ(37.5f, list->params()[1].value().asFloat());
+}
+
+TEST(TmParamList, writesPerValueEncodingForOldReceivers)
+{
+    TmParamList list("device", makeMixedParams());
+    auto bytes = list.serialize();
+    mcc::protobuf::Message parsed;
+    ASSERT_TRUE(parsed.ParseFromArray(bytes.data(), (int)bytes.size()));
+    auto body = parsed.body()._tmparamlist();
+    EXPECT_TRUE(body.has_packed());
+    ASSERT_EQ((int)makeMixedParams().size(), body.params_size());
+
+    //так его видит получатель, не знающий packed
+    body.clear_packed();
+    auto message = TmParamList::deserialize(body);
+    ASSERT_TRUE(message != nullptr);
+    const TmParamList* old = static_cast<const TmParamList*>(message.get());
+    ASSERT_EQ(makeMixedParams().size(), old->params().size());
+    EXPECT_EQ("comment", old->params()[7].status());
+    EXPECT_EQ(std::string(40, 'x'), old->params()[7].value().asString());
+}
+
+TEST(Message, namesAreInterned)
+{
+    TmParamList list("device");
+    EXPECT_EQ(mcc::misc::NameTable::intern(mcc::Names::coreTm()), list.receiverId());
+    EXPECT_EQ(mcc::Names::coreTm(), list.receiver());
+    EXPECT_EQ(mcc::misc::NameTable::emptyId, list.senderId());
+    EXPECT_TRUE(list.sender().empty());
+}
+
+TEST(Message, timestampSurvivesSerialization)
+{
+    MessageQueue queue = std::make_shared<MessageQueue::element_type>();
+    MessageSenderX sender("tm", queue);
+    mcc::misc::Timestamp before = mcc::misc::currentTimestamp();
+    sender.sendTo("db", MessagePtr(new TmParamList("device", makeParams(1))));
+    auto sent = queue->tryRecv().take();
+    EXPECT_LE(before, sent->time());
+    EXPECT_LE(sent->time(), mcc::misc::currentTimestamp());
+
+    auto bytes = sent->serialize();
+    auto received = Message::deserialize(bytes.data(), bytes.size());
+    ASSERT_TRUE(received != nullptr);
+    EXPECT_EQ(sent->time(), received->time());
+    EXPECT_EQ("tm", received->sender());
+    EXPECT_EQ("db", received->receiver());
+
+    //текстовое время для участников со старой схемой
+    mcc::protobuf::Message parsed;
+    ASSERT_TRUE(parsed.ParseFromArray(bytes.data(), (int)bytes.size()));
+    ASSERT_TRUE(parsed.header().has_time());
+    EXPECT_EQ(mcc::misc::formatTimestamp(sent->time()), parsed.header().time());
+}
+
+template<class T>
+static std::unique_ptr<T> roundTrip(const Message& message)
+{
+    EXPECT_TRUE(Message::isSerializable(message.message_type()));
+    std::vector<uint8_t> buffer;
+    message.serialize(&buffer);
+    auto received = Message::deserialize(buffer.data(), buffer.size());
+    if (!received || received->message_type() != message.message_type())
+        return nullptr;
+    return std::unique_ptr<T>(static_cast<T*>(received.release()));
+}
+
+TEST(Message, serializesWholeMessageSet)
+{
+    auto unsubscribe = roundTrip<TmParamSubscribe_Request>(TmParamSubscribe_Request(false, "device", "trait"));
+    ASSERT_TRUE(unsubscribe != nullptr);
+    EXPECT_FALSE(unsubscribe->isOn());
+    EXPECT_EQ("device", unsubscribe->device());
+    EXPECT_EQ("trait", unsubscribe->trait());
+    EXPECT_TRUE(unsubscribe->status().empty());
+
+    CmdSubscribe_Request request(false, "device");
+    auto response = roundTrip<CmdSubscribe_Response>(CmdSubscribe_Response(&request, "failed"));
+    ASSERT_TRUE(response != nullptr);
+    EXPECT_FALSE(response->isOn());
+    EXPECT_EQ("failed", response->error());
+
+    auto state = roundTrip<CmdState>(CmdState("device", 7, CmdState::SentToDevice, "reason"));
+    ASSERT_TRUE(state != nullptr);
+    EXPECT_EQ(7u, state->cmdId());
+    EXPECT_EQ(CmdState::SentToDevice, state->state());
+    EXPECT_EQ("reason", state->reason());
+
+    StatQueues queues(1);
+    queues[0]._name = "db";
+    queues[0]._dropped = 3;
+    auto stats = roundTrip<SystemQueueStats>(SystemQueueStats(std::move(queues)));
+    ASSERT_TRUE(stats != nullptr);
+    ASSERT_EQ(1u, stats->queues().size());
+    EXPECT_EQ("db", stats->queues()[0]._name);
+    EXPECT_EQ(3u, stats->queues()[0]._dropped);
+
+    auto component = roundTrip<SystemComponentState>(SystemComponentState(true, "reason"));
+    ASSERT_TRUE(component != nullptr);
+    EXPECT_TRUE(component->isStarted());
+    EXPECT_EQ("reason", component->reason());
+
+    DeviceList_Request listRequest;
+    auto list = roundTrip<DeviceList_Response>(DeviceList_Response(&listRequest, std::vector<std::string>{"a", "b"}));
+    ASSERT_TRUE(list != nullptr);
+    EXPECT_EQ(std::vector<std::string>({"a", "b"}), list->devices());
+    EXPECT_TRUE(list->requestId().isSome());
+
+    auto registered = roundTrip<DeviceRegistered>(DeviceRegistered(5, "name", "info"));
+    ASSERT_TRUE(registered != nullptr);
+    EXPECT_EQ(5u, registered->id());
+    EXPECT_EQ("info", registered->info());
+
+    auto tm = roundTrip<TmParamList>(TmParamList("device", makeMixedParams()));
+    ASSERT_TRUE(tm != nullptr);
+    EXPECT_EQ("device", tm->device());
+    ASSERT_EQ(makeMixedParams().size(), tm->params().size());
+    EXPECT_EQ("comment", tm->params()[7].status());
+    EXPECT_EQ(std::string(40, 'x'), tm->params()[7].value().asString());
+    EXPECT_FALSE(tm->isReplay());
+
+    TmParams replayParams = makeMixedParams();
+    auto replayed = roundTrip<TmParamList>(TmParamList("device", std::move(replayParams), 1234));
+    ASSERT_TRUE(replayed != nullptr);
+    EXPECT_TRUE(replayed->isReplay());
+    EXPECT_EQ(1234, replayed->sampleTime());
+
+    TmParamStates states;
+    states.emplace_back("device", TmParam("trait", "status", mcc::misc::NetVariant(2.5)), 1234, 7);
+    TmSnapshot_Request snapshotRequest("device", "", "", 3);
+    auto snapshot = roundTrip<TmSnapshot_Response>(TmSnapshot_Response(&snapshotRequest, std::move(states), 42));
+    ASSERT_TRUE(snapshot != nullptr);
+    EXPECT_EQ(42u, snapshot->sequence());
+    ASSERT_EQ(1u, snapshot->states().size());
+    EXPECT_EQ("status", snapshot->states()[0].param().status());
+    EXPECT_EQ(2.5, snapshot->states()[0].param().value().asDouble());
+    EXPECT_EQ(1234, snapshot->states()[0].time());
+    EXPECT_EQ(7u, snapshot->states()[0].updates());
+
+    TmParamNames names;
+    names.emplace_back("trait", "status");
+    auto historyRequest = roundTrip<TmHistory_Request>(TmHistory_Request("device", names, -5, 1000, 100, 16));
+    ASSERT_TRUE(historyRequest != nullptr);
+    ASSERT_EQ(1u, historyRequest->params().size());
+    EXPECT_EQ("status", historyRequest->params()[0].status);
+    EXPECT_EQ(-5, historyRequest->from());
+    EXPECT_EQ(1000, historyRequest->to());
+    EXPECT_EQ(100, historyRequest->bucket());
+    EXPECT_EQ(16u, historyRequest->maxPoints());
+
+    TmHistoryPoints points;
+    points.emplace_back(100, mcc::misc::NetVariant(1.5), 1.0, 2.0, 3);
+    points.emplace_back(200, mcc::misc::NetVariant("raw"));
+    auto history = roundTrip<TmHistory_Response>(TmHistory_Response(historyRequest.get(), names[0], std::move(points), 2, true));
+    ASSERT_TRUE(history != nullptr);
+    EXPECT_EQ("trait", history->param().trait);
+    EXPECT_EQ(2u, history->part());
+    EXPECT_TRUE(history->isLast());
+    ASSERT_EQ(2u, history->points().size());
+    EXPECT_EQ(1.5, history->points()[0].value.asDouble());
+    EXPECT_EQ(2.0, history->points()[0].max);
+    EXPECT_EQ(3u, history->points()[0].count);
+    EXPECT_EQ("raw", history->points()[1].value.asString());
+    EXPECT_EQ(0u, history->points()[1].count);
+
+    auto failed = roundTrip<TmHistory_Response>(TmHistory_Response(historyRequest.get(), "no archive"));
+    ASSERT_TRUE(failed != nullptr);
+    EXPECT_EQ("no archive", failed->error());
+    EXPECT_TRUE(failed->isLast());
+
+    auto replayRequest = roundTrip<TmReplay_Request>(TmReplay_Request("flight.tm", {"uav1", "uav2"}, 10, 20, 0));
+    ASSERT_TRUE(replayRequest != nullptr);
+    EXPECT_EQ("flight.tm", replayRequest->path());
+    ASSERT_EQ(2u, replayRequest->devices().size());
+    EXPECT_EQ("uav2", replayRequest->devices()[1]);
+    EXPECT_EQ(20, replayRequest->to());
+    EXPECT_EQ(0, replayRequest->speed());
+
+    auto replay = roundTrip<TmReplay_Response>(TmReplay_Response(replayRequest.get(), 7, 280, 5000, "interrupted"));
+    ASSERT_TRUE(replay != nullptr);
+    EXPECT_EQ(7u, replay->frames());
+    EXPECT_EQ(280u, replay->points());
+    EXPECT_EQ(5000, replay->duration());
+    EXPECT_EQ("interrupted", replay->error());
+
+    EXPECT_FALSE(Message::isSerializable(MessageType::DeviceActionLog));
+}
+
+TEST(Message, typeIds)
+{
+    TmParamList list("device");
+    EXPECT_EQ(MessageType::TmParamList, list.message_type());
+    EXPECT_EQ(MessageType::TmParamList, MessageTypeOf<TmParamList>::value);
+    EXPECT_NE(MessageTypeOf<TmParamSubscribe_Request>::value, MessageTypeOf<TmParamList>::value);
+    EXPECT_LT((std::size_t)MessageTypeOf<ProtocolForDeviceRegister_Response>::value, messageTypeCount);
+}
+
+TEST(Tracer, collectsPerService)
+{
+    auto trace = Tracer::service("trace.test");
+    EXPECT_EQ(trace.get(), Tracer::service("trace.test").get());
+
+    trace->sent(MessageType::TmParamList);
+    trace->received(MessageType::Cmd, 1000, 3000);
+    trace->handled(0, 500);
+
+    StatTrace stat;
+    for (const auto& i : Tracer::stats())
+    {
+        if (i._name == "trace.test")
+            stat = i;
+    }
+    ASSERT_EQ("trace.test", stat._name);
+    EXPECT_EQ(1u, stat._wait._count);
+    EXPECT_EQ(2000, stat._wait._max);
+    EXPECT_EQ(500, stat._handle._max);
+    ASSERT_EQ(1u, stat._received.size());
+    EXPECT_EQ("Cmd", stat._received[0].first);
+    ASSERT_EQ(1u, stat._sent.size());
+    EXPECT_EQ("TmParamList", stat._sent[0].first);
+    EXPECT_FALSE(Tracer::dump("/nonexistent/dir/trace.txt"));
+}
+
+class TmProcessor : public MessageProcessor
+{
+public:
+    TmProcessor() : MessageProcessor(nullptr), _lists(0)
+    {
+        handle<TmParamList>();
+    }
+    void process(std::unique_ptr<TmParamList>&&) override { _lists++; }
+    int _lists;
+};
+
+TEST(MessageProcessor, dispatchTable)
+{
+    TmProcessor processor;
+    EXPECT_TRUE(processor.hasHandlers());
+    EXPECT_EQ(1u, processor.handledTypes().count());
+    EXPECT_TRUE(processor.handledTypes().test((std::size_t)MessageType::TmParamList));
+
+    processor.chooseProcessor(MessagePtr(new TmParamList("device")));
+    MessageProcessor::chooseProcessor(MessagePtr(new TmParamList("device")), &processor);
+    processor.chooseProcessor(MessagePtr(new TmParamSubscribe_Request(true, "device")));
+    EXPECT_EQ(2, processor._lists);
+    EXPECT_EQ(1u, processor.unhandledCount());
+}
@@ -4,10 +4,13 @@
 #include "mcc/misc/Net.h"
 #include "mcc/misc/Protocol.h"
 #include "mcc/misc/TimeUtils.h"
+#include "mcc/misc/LatencyHistogram.h"
+#include "mcc/misc/NetVariant.h"
 
 #include <gtest/gtest.h>
 
 #include <string>
+#include <vector>
 
 #include <QDateTime>
 #include <QDebug>
@@ -389,3 +392,133 @@ TEST(DateTime, serializeDeserialize)
 }
 
 
+
+TEST(DateTime, timestampIsMonotonic)
+{
+    Timestamp previous = currentTimestamp();
+    for (int i = 0; i < 1000; i++) {
+        Timestamp next = currentTimestamp();
+        EXPECT_LE(previous, next);
+        previous = next;
+    }
+    EXPECT_LE(std::abs(QDateTime::currentDateTime().toMSecsSinceEpoch() - toDateTime(previous).toMSecsSinceEpoch()), 1000);
+}
+
+TEST(DateTime, formatParseTimestamp)
+{
+    QDateTime time(QDate(2015, 4, 6), QTime(17, 16, 12, 126));
+    Timestamp timestamp = time.toMSecsSinceEpoch() * 1000000 + 999;
+
+    EXPECT_EQ("2015-04-06T17:16:12.126", formatTimestamp(timestamp));
+    EXPECT_EQ("2015-04-06T17:16:13.000", formatTimestamp(timestamp + 874000000));
+    EXPECT_EQ(time.toMSecsSinceEpoch() * 1000000, parseTimestamp("2015-04-06T17:16:12.126"));
+    EXPECT_EQ(0, parseTimestamp("garbage"));
+    EXPECT_TRUE(time == toDateTime(timestamp));
+}
+
+TEST(LatencyHistogram, bucketsAreContiguous)
+{
+    for (std::size_t i = 0; i + 1 < LatencyHistogram::bucketCount; i++) {
+        std::int64_t lowest = LatencyHistogram::bucketLowest(i);
+        EXPECT_EQ(i, LatencyHistogram::bucketIndex(lowest));
+        EXPECT_EQ(i, LatencyHistogram::bucketIndex(LatencyHistogram::bucketLowest(i + 1) - 1));
+    }
+    EXPECT_EQ(LatencyHistogram::bucketCount - 1, LatencyHistogram::bucketIndex(INT64_MAX));
+    EXPECT_EQ(0u, LatencyHistogram::bucketIndex(-5));
+}
+
+TEST(LatencyHistogram, percentiles)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(0, histogram.snapshot().percentile(0.5));
+    for (std::int64_t i = 1; i <= 1000; i++) {
+        histogram.record(i * 1000);
+    }
+    auto s = histogram.snapshot();
+    EXPECT_EQ(1000u, s.count);
+    EXPECT_EQ(1000000, s.max);
+    EXPECT_EQ(500500, s.mean());
+    EXPECT_NEAR(500000, s.percentile(0.5), 500000 / 32);
+    EXPECT_NEAR(990000, s.percentile(0.99), 990000 / 32);
+    EXPECT_EQ(1000000, s.percentile(1.0));
+
+    histogram.reset();
+    EXPECT_EQ(0u, histogram.count());
+}
+
+TEST(NetVariant, smallStringIsInline)
+{
+    std::string small(NetVariant::smallStringCapacity, 'a');
+    NetVariant value(small);
+    EXPECT_TRUE(value.isString());
+    EXPECT_TRUE(value.isInline());
+    EXPECT_EQ(small, value.asString());
+
+    NetVariant copy(value);
+    EXPECT_TRUE(copy.isInline());
+    EXPECT_EQ(small, copy.asString());
+    EXPECT_EQ(NetVariant::smallStringCapacity, copy.stringSize());
+}
+
+TEST(NetVariant, longStringIsOnHeap)
+{
+    std::string large(NetVariant::smallStringCapacity + 1, 'b');
+    NetVariant value(large);
+    EXPECT_TRUE(value.isString());
+    EXPECT_FALSE(value.isInline());
+
+    NetVariant copy(value);
+    EXPECT_EQ(large, copy.asString());
+    EXPECT_NE(value.stringData(), copy.stringData());
+
+    const char* data = copy.stringData();
+    NetVariant moved(std::move(copy));
+    EXPECT_EQ(data, moved.stringData());
+    EXPECT_EQ(large, moved.asString());
+
+    moved = NetVariant("short");
+    EXPECT_TRUE(moved.isInline());
+    EXPECT_EQ("short", moved.asString());
+    const NetVariant& self = value;
+    value = self;
+    EXPECT_EQ(large, value.asString());
+}
+
+TEST(NetVariant, numericConversions)
+{
+    EXPECT_EQ(0.0, NetVariant().toDouble());
+    EXPECT_EQ(1.0, NetVariant(true).toDouble());
+    EXPECT_EQ(-5.0, NetVariant(std::int32_t(-5)).toDouble());
+    EXPECT_EQ(7.0, NetVariant(std::uint8_t(7)).toDouble());
+    EXPECT_EQ(1.5, NetVariant(1.5f).toDouble());
+    EXPECT_EQ(-2.25, NetVariant(-2.25).toDouble());
+    EXPECT_EQ(3.5, NetVariant("3.5").toDouble());
+
+    EXPECT_EQ(-5, NetVariant(std::int16_t(-5)).toInt());
+    EXPECT_EQ(1u, NetVariant(true).toUint());
+    EXPECT_EQ(42u, NetVariant(std::uint64_t(42)).toUint());
+    EXPECT_EQ(3, NetVariant(3.75).toInt());
+    EXPECT_EQ(12u, NetVariant(std::string("12")).toUint());
+    EXPECT_EQ(2.5f, NetVariant(2.5).toFloat());
+}
+
+TEST(NetVariant, serializeRoundTrip)
+{
+    std::vector<NetVariant> values = {NetVariant(), NetVariant(true), NetVariant(std::int64_t(-3)),
+                                      NetVariant(std::uint64_t(5)), NetVariant(1.25f), NetVariant(-0.5),
+                                      NetVariant("abc"), NetVariant(std::string(30, 'd'))};
+    std::string data("x");
+    for (const NetVariant& value : values) {
+        value.serialize(&data);
+    }
+    EXPECT_EQ('x', data[0]);
+
+    bmcl::MemReader reader((const uint8_t*)data.data() + 1, data.size() - 1);
+    for (const NetVariant& value : values) {
+        auto result = NetVariant::deserialize(&reader);
+        ASSERT_TRUE(result.isOk());
+        ASSERT_EQ(value.type(), result.unwrap().type());
+        EXPECT_EQ(value.stringify(), result.unwrap().stringify());
+    }
+    EXPECT_EQ(0u, reader.readableSize());
+}
@@ -0,0 +1,58 @@
+#include "mcc/misc/NameTable.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using mcc::misc::NameId;
+using mcc::misc::NameTable;
+
+TEST(NameTable, emptyName)
+{
+    EXPECT_EQ(NameTable::emptyId, NameTable::intern(""));
+    EXPECT_EQ("", NameTable::name(NameTable::emptyId));
+}
+
+TEST(NameTable, intern)
+{
+    NameId a = NameTable::intern("mcc.core.a");
+    NameId b = NameTable::intern("mcc.core.b");
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a, NameTable::intern(std::string("mcc.core.a")));
+    EXPECT_EQ("mcc.core.a", NameTable::name(a));
+    EXPECT_EQ("mcc.core.b", NameTable::name(b));
+}
+
+TEST(NameTable, referenceStaysValid)
+{
+    const std::string& first = NameTable::name(NameTable::intern("first"));
+    for (int i = 0; i < 1000; i++) {
+        NameTable::intern("name" + std::to_string(i));
+    }
+    EXPECT_EQ("first", first);
+}
+
+TEST(NameTable, concurrentIntern)
+{
+    const int threadCount = 4;
+    std::vector<std::vector<NameId>> ids(threadCount);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([t, &ids]() {
+            for (int i = 0; i < 500; i++) {
+                ids[t].push_back(NameTable::intern("concurrent" + std::to_string(i)));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int t = 1; t < threadCount; t++) {
+        EXPECT_EQ(ids[0], ids[t]);
+    }
+    for (int i = 0; i < 500; i++) {
+        EXPECT_EQ("concurrent" + std::to_string(i), NameTable::name(ids[0][i]));
+    }
+}
@@ -0,0 +1,122 @@
+#include "mcc/core/replay/ArchiveReader.h"
+#include "mcc/core/replay/ReplayClock.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <limits>
+
+using namespace mcc::messages;
+using mcc::misc::NetVariant;
+using mcc::misc::Timestamp;
+using mcc::core::db::TmArchive;
+using mcc::core::replay::ArchiveReader;
+using mcc::core::replay::Frame;
+using mcc::core::replay::ReplayClock;
+
+static const Timestamp ms = 1000 * 1000;
+static const char* archivePath = "replay-test.tm";
+static const Timestamp maxTime = std::numeric_limits<Timestamp>::max();
+
+static TmParams makeFrame(int i)
+{
+    TmParams params;
+    params.emplace_back("nav", "lat", NetVariant(55.75 + i * 0.0001));
+    params.emplace_back("nav", "alt", NetVariant(std::int64_t(100 + i)));
+    return params;
+}
+
+TEST(ReplayClock, scalesRecordedIntervals)
+{
+    ReplayClock realtime(1);
+    realtime.start(5000 * ms, 100 * ms);
+    EXPECT_EQ(100 * ms, realtime.due(5000 * ms));
+    EXPECT_EQ(120 * ms, realtime.due(5020 * ms));
+
+    ReplayClock fast(10);
+    fast.start(5000 * ms, 100 * ms);
+    EXPECT_EQ(102 * ms, fast.due(5020 * ms));
+
+    ReplayClock unlimited(0);
+    unlimited.start(5000 * ms, 100 * ms);
+    EXPECT_EQ(100 * ms, unlimited.due(9000 * ms));
+}
+
+TEST(ArchiveReader, mergesSeriesIntoFramesAcrossWindows)
+{
+    std::remove(archivePath);
+    {
+        TmArchive::Options options;
+        options.chunkPoints = 16;
+        TmArchive archive;
+        ASSERT_TRUE(archive.open(archivePath, options));
+        Timestamp start = 1000000 * ms;
+        for (int i = 0; i < 100; i++)
+        {
+            archive.append("uav1", makeFrame(i), start + i * 20 * ms);
+            //второе устройство в то же время и со сдвигом
+            if (i % 10 == 0)
+                archive.append("uav2", makeFrame(-i), start + i * 20 * ms + (i % 20 == 0 ? 0 : 5 * ms));
+        }
+    }
+
+    TmArchive::Options options;
+    options.isReadOnly = true;
+    TmArchive archive;
+    ASSERT_TRUE(archive.open(archivePath, options));
+    TmParams ignored;
+    ignored.emplace_back("nav", "lat", NetVariant(0.0));
+    archive.append("uav1", ignored, 0);
+    std::vector<TmArchive::Point> points;
+    archive.query("uav1", "nav", "lat", 0, 0, &points);
+    EXPECT_TRUE(points.empty());
+
+    //окно 300 мс режет запись на части, кадры всё равно идут подряд
+    ArchiveReader reader(&archive, std::vector<std::string>(), 0, maxTime, 300 * ms);
+    Frame frame;
+    std::vector<Frame> frames;
+    while (reader.next(&frame))
+        frames.push_back(frame);
+    ASSERT_EQ(110u, frames.size());
+    for (std::size_t i = 1; i < frames.size(); i++)
+        EXPECT_LE(frames[i - 1].time, frames[i].time);
+
+    EXPECT_EQ("uav1", frames[0].device);
+    EXPECT_EQ("uav2", frames[1].device);
+    EXPECT_EQ(frames[0].time, frames[1].time);
+    ASSERT_EQ(2u, frames[0].params.size());
+    //параметры кадра в порядке trait/status
+    EXPECT_EQ("alt", frames[0].params[0].status());
+    EXPECT_EQ(100, frames[0].params[0].value().asInt());
+    EXPECT_EQ("lat", frames[0].params[1].status());
+
+    //одно устройство и интервал
+    Timestamp start = 1000000 * ms;
+    ArchiveReader part(&archive, {"uav2"}, start + 100 * ms, start + 1000 * ms);
+    frames.clear();
+    while (part.next(&frame))
+        frames.push_back(frame);
+    ASSERT_EQ(4u, frames.size());
+    EXPECT_EQ(start + 205 * ms, frames[0].time);
+    EXPECT_EQ("uav2", frames[0].device);
+
+    ArchiveReader none(&archive, {"unknown"}, 0, maxTime);
+    EXPECT_FALSE(none.next(&frame));
+
+    archive.close();
+    std::remove(archivePath);
+}
+
+TEST(ArchiveReader, readOnlyArchiveMustExist)
+{
+    std::remove(archivePath);
+    TmArchive::Options options;
+    options.isReadOnly = true;
+    TmArchive archive;
+    EXPECT_FALSE(archive.open(archivePath, options));
+    EXPECT_FALSE(archive.isOpen());
+    std::FILE* file = std::fopen(archivePath, "rb");
+    EXPECT_EQ(nullptr, file);
+    if (file)
+        std::fclose(file);
+}
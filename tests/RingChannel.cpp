@@ -0,0 +1,217 @@
+#include "mcc/misc/RingChannel.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mcc::misc;
+
+TEST(RingChannelTest, sendRecvInt)
+{
+    RingChannel<int> channel(16);
+    std::thread sender([&]() {
+        for (int i = 0; i < 1000; i++) {
+            channel.send(i);
+        }
+    });
+    std::thread reciever([&]() {
+        for (int i = 0; i < 1000; i++) {
+            Option<int> option = channel.recv();
+            EXPECT_TRUE(option.isSome());
+            EXPECT_EQ(i, option.unwrap());
+        }
+    });
+    sender.join();
+    reciever.join();
+}
+
+TEST(RingChannelTest, emplaceRecvPair)
+{
+    RingChannel<std::pair<int, std::string>> channel(8);
+    std::thread reciever([&]() {
+        for (int i = 0; i < 100; i++) {
+            Option<std::pair<int, std::string>> option = channel.recv();
+            EXPECT_TRUE(option.isSome());
+            std::string expectedStr = "test" + std::to_string(i);
+            EXPECT_EQ(i, option.unwrap().first);
+            EXPECT_EQ(expectedStr, option.unwrap().second);
+        }
+    });
+    std::thread sender([&]() {
+        for (int i = 0; i < 100; i++) {
+            std::string value = "test" + std::to_string(i);
+            channel.sendEmplace(i, value);
+        }
+    });
+    reciever.join();
+    sender.join();
+}
+
+TEST(RingChannelTest, manyProducers)
+{
+    const int producers = 8;
+    const int perProducer = 10000;
+    RingChannel<int> channel(64);
+    std::vector<std::thread> senders;
+    for (int p = 0; p < producers; p++) {
+        senders.emplace_back([&, p]() {
+            for (int i = 0; i < perProducer; i++) {
+                channel.send(p * perProducer + i);
+            }
+        });
+    }
+    std::vector<int> lastSeen(producers, -1);
+    long long sum = 0;
+    for (int i = 0; i < producers * perProducer; i++) {
+        int value = channel.recv().unwrap();
+        int p = value / perProducer;
+        EXPECT_LT(lastSeen[p], value);
+        lastSeen[p] = value;
+        sum += value;
+    }
+    for (std::thread& thread : senders) {
+        thread.join();
+    }
+    long long n = producers * perProducer;
+    EXPECT_EQ(n * (n - 1) / 2, sum);
+    EXPECT_TRUE(channel.isEmpty());
+}
+
+TEST(RingChannelTest, reject)
+{
+    RingChannel<int> channel(4, OverflowPolicy::Reject);
+    EXPECT_EQ(4u, channel.capacity());
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(channel.send(i));
+    }
+    EXPECT_FALSE(channel.send(4));
+    EXPECT_TRUE(channel.isOpen());
+    EXPECT_EQ(1u, channel.droppedCount());
+    EXPECT_EQ(4u, channel.size());
+    EXPECT_EQ(0, channel.tryRecv().unwrap());
+    EXPECT_TRUE(channel.send(5));
+}
+
+TEST(RingChannelTest, dropOldest)
+{
+    RingChannel<int> channel(4, OverflowPolicy::DropOldest);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(channel.send(i));
+    }
+    EXPECT_EQ(6u, channel.droppedCount());
+    for (int i = 6; i < 10; i++) {
+        EXPECT_EQ(i, channel.tryRecv().unwrap());
+    }
+    EXPECT_EQ(ChannelError::Empty, channel.tryRecv().unwrapErr());
+}
+
+TEST(RingChannelTest, blockUntilSpace)
+{
+    RingChannel<int> channel(2, OverflowPolicy::Block);
+    std::atomic<int> sent(0);
+    std::thread sender([&]() {
+        for (int i = 0; i < 3; i++) {
+            channel.send(i);
+            sent++;
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_EQ(2, sent);
+    EXPECT_EQ(0, channel.recv().unwrap());
+    sender.join();
+    EXPECT_EQ(3, sent);
+    EXPECT_EQ(1, channel.recv().unwrap());
+    EXPECT_EQ(2, channel.recv().unwrap());
+}
+
+TEST(RingChannelTest, recvAll)
+{
+    RingChannel<int> channel(32);
+    for (int i = 0; i < 10; i++) {
+        channel.send(i);
+    }
+    std::vector<int> values;
+    EXPECT_EQ(4u, channel.recvAll(&values, 4));
+    EXPECT_EQ(6u, channel.recvAll(&values, 100));
+    EXPECT_EQ(0u, channel.recvAll(&values, 100));
+    ASSERT_EQ(10u, values.size());
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(i, values[i]);
+    }
+}
+
+TEST(RingChannelTest, recvAllFor)
+{
+    RingChannel<int> channel(32);
+    std::vector<int> values;
+    EXPECT_EQ(0u, channel.recvAllFor(&values, 10, std::chrono::milliseconds(1)));
+    std::thread sender([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        channel.send(1);
+    });
+    EXPECT_EQ(1u, channel.recvAllFor(&values, 10, std::chrono::seconds(10)));
+    EXPECT_EQ(1, values[0]);
+    sender.join();
+}
+
+TEST(RingChannelTest, tryRecvFor)
+{
+    RingChannel<int> channel;
+    std::thread reciever([&]() {
+        Result<int, ChannelError> res = channel.tryRecvFor(std::chrono::seconds(10));
+        EXPECT_TRUE(res.isOk());
+        EXPECT_EQ(1, res.unwrap());
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    channel.send(1);
+    reciever.join();
+}
+
+TEST(RingChannelTest, tryRecvForTimeout)
+{
+    RingChannel<int> channel;
+    Result<int, ChannelError> res = channel.tryRecvFor(std::chrono::microseconds(1));
+    EXPECT_TRUE(res.isErr());
+    EXPECT_EQ(ChannelError::Timeout, res.unwrapErr());
+}
+
+TEST(RingChannelTest, close)
+{
+    RingChannel<int> channel(8);
+    std::thread reciever([&]() {
+        Result<int, ChannelError> res = channel.tryRecvFor(std::chrono::seconds(10));
+        EXPECT_TRUE(res.isErr());
+        EXPECT_EQ(ChannelError::Closed, res.unwrapErr());
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    channel.close();
+    reciever.join();
+    EXPECT_FALSE(channel.send(1));
+    EXPECT_TRUE(channel.recv().isNone());
+}
+
+TEST(RingChannelTest, closeUnblocksSender)
+{
+    RingChannel<int> channel(2, OverflowPolicy::Block);
+    std::thread sender([&]() {
+        while (channel.send(1)) {
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    channel.close();
+    sender.join();
+}
+
+TEST(RingChannelTest, senderReciever)
+{
+    RingChannelPair<std::string> pair = makeRingChannel<std::string>(8);
+    pair.sender.send("one");
+    pair.sender.send("two");
+    std::vector<std::string> values;
+    EXPECT_EQ(2u, pair.reciever.recvAll(&values, 10));
+    EXPECT_EQ("one", values[0]);
+    EXPECT_EQ("two", values[1]);
+}
@@ -0,0 +1,143 @@
+#include "mcc/misc/ShmRing.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace mcc::misc;
+
+static std::string ringName(const char* test)
+{
+    return "/mcc-test-" + std::string(test) + "-" + std::to_string(getpid());
+}
+
+static bool writeString(ShmRing* ring, const std::string& value)
+{
+    return ring->write(value.data(), value.size());
+}
+
+static std::string readString(ShmRing* ring)
+{
+    std::vector<std::uint8_t> frame;
+    if (!ring->read(&frame)) {
+        return "<empty>";
+    }
+    return std::string(frame.begin(), frame.end());
+}
+
+TEST(ShmRing, createOpen)
+{
+    auto created = ShmRing::create(ringName("createOpen"), 1000);
+    ASSERT_TRUE(created.isOk());
+    ShmRingPtr producer = created.take();
+    EXPECT_EQ(1024u, producer->capacity());
+
+    auto opened = ShmRing::open(producer->name());
+    ASSERT_TRUE(opened.isOk());
+    ShmRingPtr consumer = opened.take();
+
+    EXPECT_EQ("<empty>", readString(consumer.get()));
+    EXPECT_TRUE(writeString(producer.get(), "first"));
+    EXPECT_TRUE(writeString(producer.get(), ""));
+    EXPECT_TRUE(writeString(producer.get(), "third"));
+    EXPECT_EQ("first", readString(consumer.get()));
+    EXPECT_EQ("", readString(consumer.get()));
+    EXPECT_EQ("third", readString(consumer.get()));
+    EXPECT_EQ("<empty>", readString(consumer.get()));
+}
+
+TEST(ShmRing, openMissing)
+{
+    EXPECT_TRUE(ShmRing::open(ringName("openMissing")).isErr());
+}
+
+TEST(ShmRing, fullAndWrap)
+{
+    ShmRingPtr ring = ShmRing::create(ringName("fullAndWrap"), 1024).take();
+    std::string big(ring->maxFrameSize(), 'x');
+    EXPECT_FALSE(ring->write(big.data(), big.size() + 1));
+
+    std::deque<std::string> expected;
+    for (int i = 0; i < 3; i++) {
+        expected.emplace_back(300, 'a' + i);
+        EXPECT_TRUE(writeString(ring.get(), expected.back()));
+    }
+    EXPECT_FALSE(writeString(ring.get(), std::string(300, 'z')));
+
+    // every few frames one doesn't fit at the end and goes to the start
+    for (int i = 3; i < 20; i++) {
+        EXPECT_EQ(expected.front(), readString(ring.get()));
+        expected.pop_front();
+        expected.emplace_back(300, 'a' + i);
+        EXPECT_TRUE(writeString(ring.get(), expected.back()));
+    }
+    for (const std::string& frame : expected) {
+        EXPECT_EQ(frame, readString(ring.get()));
+    }
+    EXPECT_EQ("<empty>", readString(ring.get()));
+}
+
+// overwrites the length of the first frame, as a peer that crashed mid-write could leave it
+static void corruptFirstFrame(const std::string& name, std::uint32_t size)
+{
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    ASSERT_GE(fd, 0);
+    struct stat info;
+    ASSERT_EQ(0, fstat(fd, &info));
+    void* memory = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(MAP_FAILED, memory);
+    // the header takes three cache lines, frames start right after it
+    std::memcpy(static_cast<std::uint8_t*>(memory) + 3 * 64, &size, sizeof(size));
+    munmap(memory, info.st_size);
+}
+
+TEST(ShmRing, rejectsCorruptFrameLength)
+{
+    for (std::uint32_t size : {0x7ffffff0u, 600u, 20u}) {
+        ShmRingPtr ring = ShmRing::create(ringName("rejectsCorruptFrameLength"), 1024).take();
+        EXPECT_TRUE(writeString(ring.get(), std::string(10, 'a')));
+        corruptFirstFrame(ring->name(), size);
+
+        std::vector<std::uint8_t> frame;
+        EXPECT_FALSE(ring->read(&frame));
+        EXPECT_TRUE(ring->isBroken());
+        EXPECT_TRUE(frame.empty());
+        // the ring stays broken, later frames can't be trusted either
+        EXPECT_TRUE(writeString(ring.get(), "b"));
+        EXPECT_FALSE(ring->readFor(&frame, std::chrono::milliseconds(10)));
+    }
+}
+
+TEST(ShmRing, producerConsumer)
+{
+    ShmRingPtr producer = ShmRing::create(ringName("producerConsumer"), 4096).take();
+    ShmRingPtr consumer = ShmRing::open(producer->name()).take();
+    const std::uint64_t count = 100000;
+
+    std::thread reader([&]() {
+        std::vector<std::uint8_t> frame;
+        for (std::uint64_t i = 0; i < count; i++) {
+            ASSERT_TRUE(consumer->readFor(&frame, std::chrono::seconds(10)));
+            ASSERT_EQ((i % 37) * 8, frame.size());
+            for (std::size_t j = 0; j < frame.size(); j += 8) {
+                std::uint64_t value;
+                std::memcpy(&value, frame.data() + j, 8);
+                ASSERT_EQ(i, value);
+            }
+        }
+    });
+    std::vector<std::uint64_t> values;
+    for (std::uint64_t i = 0; i < count; i++) {
+        values.assign(i % 37, i);
+        ASSERT_TRUE(producer->writeFor(values.data(), values.size() * 8, std::chrono::seconds(10)));
+    }
+    reader.join();
+}
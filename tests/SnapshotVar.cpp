@@ -0,0 +1,85 @@
+#include "mcc/misc/SnapshotVar.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+
+using namespace mcc::misc;
+
+TEST(SnapshotVar, initial)
+{
+    SnapshotVar<int> var(5);
+    EXPECT_FALSE(var.hasUpdate());
+    EXPECT_EQ(5, var.read());
+    EXPECT_EQ(0u, var.version());
+}
+
+TEST(SnapshotVar, latestWins)
+{
+    SnapshotVar<std::string> var;
+    var.write("a");
+    var.write("b");
+    var.write("c");
+    EXPECT_TRUE(var.hasUpdate());
+    EXPECT_EQ("c", var.read());
+    EXPECT_FALSE(var.hasUpdate());
+    EXPECT_EQ("c", var.read());
+    EXPECT_EQ(3u, var.version());
+}
+
+TEST(SnapshotVar, readReferenceIsStable)
+{
+    SnapshotVar<int> var;
+    var.write(1);
+    const int& value = var.read();
+    var.write(2);
+    var.write(3);
+    var.write(4);
+    EXPECT_EQ(1, value);
+    EXPECT_EQ(4, var.read());
+}
+
+TEST(SnapshotVar, writeBuffer)
+{
+    SnapshotVar<int> var;
+    var.writeBuffer() = 10;
+    var.publish();
+    EXPECT_EQ(10, var.read());
+}
+
+struct Pair {
+    Pair()
+        : a(0)
+        , b(0)
+    {
+    }
+
+    std::uint64_t a;
+    std::uint64_t b;
+};
+
+TEST(SnapshotVar, consistentThreaded)
+{
+    SnapshotVarPtr<Pair> var = makeSnapshotVar<Pair>();
+    const std::uint64_t count = 200000;
+
+    std::thread writer([var, count]() {
+        for (std::uint64_t i = 1; i <= count; i++) {
+            Pair& pair = var->writeBuffer();
+            pair.a = i;
+            pair.b = i * 2;
+            var->publish();
+        }
+    });
+
+    std::uint64_t last = 0;
+    while (last != count) {
+        const Pair& pair = var->read();
+        ASSERT_EQ(pair.a * 2, pair.b);
+        ASSERT_GE(pair.a, last);
+        last = pair.a;
+    }
+    writer.join();
+    EXPECT_EQ(count, var->version());
+}
@@ -0,0 +1,178 @@
+#include "mcc/misc/TaskPool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace mcc::misc;
+
+TEST(TaskPoolTest, schedule)
+{
+    std::atomic<int> counter(0);
+    {
+        TaskPool<std::function<void()>> pool(2);
+        for (int i = 0; i < 100; i++) {
+            pool.schedule([&counter]() { counter++; });
+        }
+        while (counter != 100) {
+            std::this_thread::yield();
+        }
+    }
+    EXPECT_EQ(100, counter);
+}
+
+TEST(FutureTaskPoolTest, submit)
+{
+    FutureTaskPool pool(4);
+    std::vector<TaskFuture<int>> results;
+    for (int i = 0; i < 100; i++) {
+        results.push_back(pool.submit([i]() { return i * i; }));
+    }
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(i * i, results[i].get());
+    }
+}
+
+TEST(FutureTaskPoolTest, submitVoid)
+{
+    FutureTaskPool pool(2);
+    std::atomic<int> counter(0);
+    TaskFuture<void> result = pool.submit([&counter]() { counter++; });
+    result.wait();
+    EXPECT_TRUE(result.isReady());
+    EXPECT_EQ(1, counter);
+}
+
+TEST(FutureTaskPoolTest, exception)
+{
+    FutureTaskPool pool(2);
+    auto result = pool.submit([]() -> int { throw std::runtime_error("fail"); });
+    EXPECT_THROW(result.get(), std::runtime_error);
+}
+
+TEST(FutureTaskPoolTest, then)
+{
+    FutureTaskPool pool(2);
+    auto result = pool.submit([]() { return 20; })
+                      .then([](const std::shared_future<int>& value) { return value.get() + 1; })
+                      .then([](const std::shared_future<int>& value) { return std::to_string(value.get() * 2); });
+    EXPECT_EQ("42", result.get());
+}
+
+TEST(FutureTaskPoolTest, thenAfterReady)
+{
+    FutureTaskPool pool(1);
+    auto first = pool.submit([]() { return 1; });
+    first.wait();
+    auto second = first.then([](const std::shared_future<int>& value) { return value.get() + 1; });
+    EXPECT_EQ(2, second.get());
+}
+
+TEST(FutureTaskPoolTest, thenSeesException)
+{
+    FutureTaskPool pool(2);
+    auto result = pool.submit([]() -> int { throw std::runtime_error("fail"); })
+                      .then([](const std::shared_future<int>& value) {
+                          try {
+                              value.get();
+                          } catch (const std::runtime_error&) {
+                              return true;
+                          }
+                          return false;
+                      });
+    EXPECT_TRUE(result.get());
+}
+
+TEST(FutureTaskPoolTest, cancel)
+{
+    FutureTaskPool pool(1);
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    auto blocker = pool.submit([opened]() { opened.wait(); });
+
+    CancellationToken token = makeCancellationToken();
+    std::atomic<bool> isRun(false);
+    auto cancelled = pool.submit([&isRun]() { isRun = true; }, TaskPriority::Normal, token);
+    token.cancel();
+    gate.set_value();
+
+    EXPECT_THROW(cancelled.get(), TaskCancelled);
+    EXPECT_FALSE(isRun);
+    blocker.get();
+}
+
+TEST(FutureTaskPoolTest, defaultTokenIsNotCancellable)
+{
+    CancellationToken token;
+    token.cancel();
+    EXPECT_FALSE(token.isCancelled());
+}
+
+TEST(FutureTaskPoolTest, priority)
+{
+    FutureTaskPool pool(1);
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    auto blocker = pool.submit([opened]() { opened.wait(); });
+
+    std::mutex mutex;
+    std::vector<int> order;
+    auto push = [&](int value) {
+        return [&, value]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(value);
+        };
+    };
+    auto low = pool.submit(push(3), TaskPriority::Low);
+    auto normal = pool.submit(push(2), TaskPriority::Normal);
+    auto high = pool.submit(push(1), TaskPriority::High);
+    gate.set_value();
+    low.get();
+    normal.get();
+    high.get();
+    blocker.get();
+
+    ASSERT_EQ(3u, order.size());
+    EXPECT_EQ(1, order[0]);
+    EXPECT_EQ(2, order[1]);
+    EXPECT_EQ(3, order[2]);
+}
+
+TEST(FutureTaskPoolTest, nestedSubmit)
+{
+    FutureTaskPool pool(4);
+    auto result = pool.submit([&pool]() {
+        std::vector<TaskFuture<int>> parts;
+        for (int i = 1; i <= 10; i++) {
+            parts.push_back(pool.submit([i]() { return i; }, TaskPriority::High));
+        }
+        int sum = 0;
+        for (const TaskFuture<int>& part : parts) {
+            sum += part.get();
+        }
+        return sum;
+    });
+    EXPECT_EQ(55, result.get());
+}
+
+TEST(FutureTaskPoolTest, stopBreaksPending)
+{
+    TaskFuture<int> pending;
+    {
+        FutureTaskPool pool(1);
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        pool.submit([opened]() { opened.wait(); });
+        pending = pool.submit([]() { return 1; });
+        std::thread opener([&gate]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            gate.set_value();
+        });
+        pool.stop();
+        opener.join();
+    }
+    EXPECT_THROW(pending.get(), std::future_error);
+}
@@ -0,0 +1,368 @@
+#include "mcc/core/db/TmArchive.h"
+#include "mcc/core/db/TmChunk.h"
+#include "mcc/core/db/TmHistory.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+using namespace mcc::messages;
+using mcc::misc::NetVariant;
+using mcc::misc::NetVariantType;
+using mcc::misc::Timestamp;
+using mcc::core::db::TmArchive;
+using mcc::core::db::TmChunkReader;
+using mcc::core::db::TmChunkWriter;
+using mcc::core::db::TmHistoryBuilder;
+
+static const Timestamp ms = 1000 * 1000;
+static const char* archivePath = "tmarchive-test.tm";
+
+static std::uint64_t fileSize(const char* path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return (std::uint64_t)file.tellg();
+}
+
+static TmParams makeFrame(int i)
+{
+    TmParams params;
+    params.emplace_back("nav", "lat", NetVariant(55.75 + i * 0.0001));
+    params.emplace_back("nav", "mode", NetVariant(i < 50 ? "manual" : "auto"));
+    params.emplace_back("power", "cycles", NetVariant(std::uint64_t(i / 10)));
+    return params;
+}
+
+TEST(TmChunk, roundTripsNumbers)
+{
+    TmChunkWriter writer(NetVariantType::Double);
+    Timestamp time = 1500000000ll * 1000 * ms;
+    std::vector<Timestamp> times;
+    std::vector<double> values;
+    for (int i = 0; i < 1000; i++)
+    {
+        //20 мс с небольшим дрожанием
+        time += 20 * ms + (i % 7) * 13000;
+        times.push_back(time);
+        //медленно меняющийся датчик с шагом квантования
+        values.push_back(100 + (i / 20) * 0.25);
+        writer.append(time, NetVariant(values.back()));
+    }
+    EXPECT_EQ(1000u, writer.count());
+    EXPECT_EQ(times.front(), writer.minTime());
+    EXPECT_EQ(times.back(), writer.maxTime());
+    EXPECT_LT(writer.data().size(), 1000u * 16 / 2);
+
+    TmChunkReader reader(NetVariantType::Double, writer.data().data(), writer.data().size(), writer.count());
+    Timestamp t;
+    NetVariant value;
+    for (std::size_t i = 0; i < times.size(); i++)
+    {
+        ASSERT_TRUE(reader.next(&t, &value));
+        EXPECT_EQ(times[i], t);
+        EXPECT_EQ(values[i], value.asDouble());
+    }
+    EXPECT_FALSE(reader.next(&t, &value));
+    EXPECT_FALSE(reader.isCorrupted());
+}
+
+TEST(TmChunk, roundTripsStringsAndIrregularTime)
+{
+    TmChunkWriter writer(NetVariantType::QString);
+    EXPECT_EQ(NetVariantType::String, writer.type());
+    Timestamp times[] = {5000, 5000, 4000, 1ll << 50, -7};
+    const char* values[] = {"a", "a", "long value that does not fit inline", "", "a"};
+    for (std::size_t i = 0; i < 5; i++)
+        writer.append(times[i], NetVariant(values[i]));
+    EXPECT_EQ(-7, writer.minTime());
+    EXPECT_EQ(1ll << 50, writer.maxTime());
+
+    TmChunkReader reader(NetVariantType::String, writer.data().data(), writer.data().size(), writer.count());
+    Timestamp t;
+    NetVariant value;
+    for (std::size_t i = 0; i < 5; i++)
+    {
+        ASSERT_TRUE(reader.next(&t, &value));
+        EXPECT_EQ(times[i], t);
+        EXPECT_EQ(values[i], value.asString());
+    }
+
+    TmChunkReader truncated(NetVariantType::String, writer.data().data(), writer.data().size() - 2, writer.count());
+    while (truncated.next(&t, &value))
+        ;
+    EXPECT_TRUE(truncated.isCorrupted());
+}
+
+TEST(TmArchive, queriesByTimeRange)
+{
+    std::remove(archivePath);
+    TmArchive::Options options;
+    options.chunkPoints = 16;
+    TmArchive archive;
+    ASSERT_TRUE(archive.open(archivePath, options));
+
+    Timestamp start = 1000 * ms;
+    for (int i = 0; i < 100; i++)
+        archive.append("uav1", makeFrame(i), start + i * 20 * ms);
+    EXPECT_EQ(3u, archive.seriesCount());
+    //6 полных кусков по 16 точек на ряд, остаток ещё в памяти
+    EXPECT_EQ(18u, archive.chunkCount());
+
+    TmParamNames names = archive.params("uav1");
+    ASSERT_EQ(3u, names.size());
+    EXPECT_EQ("lat", names[0].status);
+    EXPECT_EQ("mode", names[1].status);
+    EXPECT_EQ("power", names[2].trait);
+    EXPECT_TRUE(archive.params("uav2").empty());
+
+    std::vector<TmArchive::Point> points;
+    archive.query("uav1", "nav", "lat", start + 10 * 20 * ms, start + 20 * 20 * ms, &points);
+    ASSERT_EQ(11u, points.size());
+    EXPECT_EQ(start + 10 * 20 * ms, points[0].time);
+    EXPECT_EQ(55.75 + 10 * 0.0001, points[0].value.asDouble());
+
+    //захватывает и незапечатанный кусок
+    points.clear();
+    archive.query("uav1", "nav", "mode", start + 45 * 20 * ms, start + 1000 * 20 * ms, &points);
+    ASSERT_EQ(55u, points.size());
+    EXPECT_EQ("manual", points[0].value.asString());
+    EXPECT_EQ("auto", points.back().value.asString());
+
+    points.clear();
+    archive.query("uav1", "nav", "unknown", 0, start * 2, &points);
+    archive.query("uav2", "nav", "lat", 0, start * 2, &points);
+    EXPECT_TRUE(points.empty());
+
+    archive.close();
+    std::remove(archivePath);
+}
+
+TEST(TmArchive, reopenKeepsDataAndTypeChanges)
+{
+    std::remove(archivePath);
+    {
+        TmArchive archive;
+        ASSERT_TRUE(archive.open(archivePath));
+        for (int i = 0; i < 10; i++)
+            archive.append("uav1", makeFrame(i), i * ms);
+        TmParams changed;
+        changed.emplace_back("power", "cycles", NetVariant(-1.5));
+        archive.append("uav1", changed, 10 * ms);
+    }
+
+    TmArchive archive;
+    ASSERT_TRUE(archive.open(archivePath));
+    EXPECT_EQ(3u, archive.seriesCount());
+    //cycles разбит на два куска при смене типа
+    EXPECT_EQ(4u, archive.chunkCount());
+
+    std::vector<TmArchive::Point> points;
+    archive.query("uav1", "power", "cycles", 0, 100 * ms, &points);
+    ASSERT_EQ(11u, points.size());
+    EXPECT_EQ(0u, points[0].value.asUint());
+    EXPECT_EQ(-1.5, points[10].value.asDouble());
+
+    archive.append("uav1", makeFrame(20), 20 * ms);
+    points.clear();
+    archive.query("uav1", "nav", "lat", 0, 100 * ms, &points);
+    EXPECT_EQ(11u, points.size());
+
+    archive.close();
+    std::remove(archivePath);
+}
+
+TEST(TmArchive, recoversFromTruncatedTail)
+{
+    std::remove(archivePath);
+    std::uint64_t goodSize;
+    {
+        TmArchive archive;
+        ASSERT_TRUE(archive.open(archivePath));
+        archive.append("uav1", makeFrame(1), 1 * ms);
+        archive.flush();
+        goodSize = archive.fileSize();
+        archive.append("uav1", makeFrame(2), 2 * ms);
+    }
+
+    //обрезаем файл посередине первой записи после flush()
+    std::string data;
+    {
+        std::ifstream file(archivePath, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    ASSERT_GT(data.size(), goodSize + 10);
+    data.resize(goodSize + 10);
+    {
+        std::ofstream file(archivePath, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+    }
+
+    TmArchive archive;
+    ASSERT_TRUE(archive.open(archivePath));
+    EXPECT_EQ(goodSize, archive.fileSize());
+    EXPECT_EQ(goodSize, fileSize(archivePath));
+    std::vector<TmArchive::Point> points;
+    archive.query("uav1", "nav", "lat", 0, 100 * ms, &points);
+    ASSERT_EQ(1u, points.size());
+    EXPECT_EQ(1 * ms, points[0].time);
+
+    //запись продолжается с последней целой записи
+    archive.append("uav1", makeFrame(3), 3 * ms);
+    archive.close();
+    ASSERT_TRUE(archive.open(archivePath));
+    points.clear();
+    archive.query("uav1", "nav", "lat", 0, 100 * ms, &points);
+    ASSERT_EQ(2u, points.size());
+    EXPECT_EQ(3 * ms, points[1].time);
+
+    archive.close();
+    std::remove(archivePath);
+}
+
+TEST(TmArchive, dropsEverythingAfterCorruptedRecord)
+{
+    std::remove(archivePath);
+    std::uint64_t goodSize;
+    {
+        TmArchive archive;
+        ASSERT_TRUE(archive.open(archivePath));
+        archive.append("uav1", makeFrame(1), 1 * ms);
+        archive.flush();
+        goodSize = archive.fileSize();
+        archive.append("uav1", makeFrame(2), 2 * ms);
+        archive.flush();
+        archive.append("uav1", makeFrame(3), 3 * ms);
+    }
+
+    //портим данные первой записи после flush(), за ней в файле ещё целые записи
+    std::string data;
+    {
+        std::ifstream file(archivePath, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    ASSERT_GT(data.size(), goodSize + 40);
+    data[goodSize + 9 + 4] ^= 0x55;
+    {
+        std::ofstream file(archivePath, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+    }
+
+    TmArchive archive;
+    ASSERT_TRUE(archive.open(archivePath));
+    EXPECT_EQ(goodSize, archive.fileSize());
+    EXPECT_EQ(goodSize, fileSize(archivePath));
+    std::vector<TmArchive::Point> points;
+    archive.query("uav1", "nav", "lat", 0, 100 * ms, &points);
+    ASSERT_EQ(1u, points.size());
+    EXPECT_EQ(1 * ms, points[0].time);
+
+    archive.close();
+    std::remove(archivePath);
+}
+
+TEST(TmHistoryBuilder, downsamplesIntoBuckets)
+{
+    std::vector<TmHistoryPoints> parts;
+    TmHistoryBuilder builder(1000, 10, 2, [&parts](TmHistoryPoints&& points) { parts.push_back(std::move(points)); });
+    for (int i = 0; i < 25; i++)
+        builder.add(1000 + i, NetVariant(std::int64_t(i)));
+    builder.finish();
+
+    ASSERT_EQ(2u, parts.size());
+    ASSERT_EQ(2u, parts[0].size());
+    ASSERT_EQ(1u, parts[1].size());
+    EXPECT_EQ(1000, parts[0][0].time);
+    EXPECT_EQ(4.5, parts[0][0].value.asDouble());
+    EXPECT_EQ(0, parts[0][0].min);
+    EXPECT_EQ(9, parts[0][0].max);
+    EXPECT_EQ(10u, parts[0][0].count);
+    EXPECT_EQ(1010, parts[0][1].time);
+    //неполная последняя корзина
+    EXPECT_EQ(1020, parts[1][0].time);
+    EXPECT_EQ(22, parts[1][0].value.asDouble());
+    EXPECT_EQ(5u, parts[1][0].count);
+}
+
+TEST(TmHistoryBuilder, passesRawPointsAndStrings)
+{
+    std::vector<TmHistoryPoints> parts;
+    TmHistoryBuilder raw(0, 0, 3, [&parts](TmHistoryPoints&& points) { parts.push_back(std::move(points)); });
+    for (int i = 0; i < 6; i++)
+        raw.add(i, NetVariant(i * 0.5));
+    raw.finish();
+    ASSERT_EQ(2u, parts.size());
+    EXPECT_EQ(3u, parts[1].size());
+    EXPECT_EQ(2.5, parts[1][2].value.asDouble());
+    EXPECT_EQ(0u, parts[1][2].count);
+
+    parts.clear();
+    TmHistoryBuilder strings(0, 100, 10, [&parts](TmHistoryPoints&& points) { parts.push_back(std::move(points)); });
+    strings.add(1, NetVariant("manual"));
+    strings.add(2, NetVariant("auto"));
+    strings.finish();
+    ASSERT_EQ(1u, parts.size());
+    ASSERT_EQ(1u, parts[0].size());
+    EXPECT_EQ("auto", parts[0][0].value.asString());
+    EXPECT_EQ(2u, parts[0][0].count);
+}
+
+TEST(TmHistoryCursor, readsInStepsWhileArchiveGrows)
+{
+    std::remove(archivePath);
+    TmArchive::Options options;
+    options.chunkPoints = 16;
+    TmArchive archive;
+    ASSERT_TRUE(archive.open(archivePath, options));
+    for (int i = 0; i < 100; i++)
+        archive.append("uav1", makeFrame(i), i * ms);
+
+    TmHistory_Request request("uav1", TmParamNames{TmParamName("nav", "lat")}, 0, 1000 * ms, 0, 40);
+    mcc::core::db::TmHistoryCursor cursor(&archive, request);
+    std::vector<std::uint32_t> parts;
+    std::size_t count = 0;
+    bool isLast = false;
+    auto sink = [&](const TmParamName& param, TmHistoryPoints&& points, std::uint32_t part, bool last)
+    {
+        EXPECT_EQ("lat", param.status);
+        EXPECT_FALSE(isLast);
+        parts.push_back(part);
+        count += points.size();
+        isLast = last;
+    };
+
+    //по куску за шаг: 6 запечатанных кусков, последний шаг дочитывает и остаток в памяти
+    std::size_t steps = 1;
+    while (cursor.step(1, sink))
+    {
+        //дописанное во время чтения тоже попадает в ответ
+        if (steps++ == 1)
+            archive.append("uav1", makeFrame(100), 100 * ms);
+    }
+    EXPECT_EQ(6u, steps);
+    EXPECT_TRUE(cursor.isDone());
+    EXPECT_TRUE(isLast);
+    EXPECT_EQ(101u, count);
+    ASSERT_EQ(3u, parts.size());
+    EXPECT_EQ(2u, parts.back());
+    EXPECT_FALSE(cursor.step(1, sink));
+
+    //нет точек - одна пустая последняя часть
+    TmHistory_Request empty("uav2", TmParamNames(), 0, 1000 * ms);
+    mcc::core::db::TmHistoryCursor emptyCursor(&archive, empty);
+    parts.clear();
+    count = 0;
+    isLast = false;
+    EXPECT_FALSE(emptyCursor.step(1, [&](const TmParamName&, TmHistoryPoints&& points, std::uint32_t part, bool last)
+    {
+        parts.push_back(part);
+        count += points.size();
+        isLast = last;
+    }));
+    ASSERT_EQ(1u, parts.size());
+    EXPECT_EQ(0u, count);
+    EXPECT_TRUE(isLast);
+
+    archive.close();
+    std::remove(archivePath);
+}
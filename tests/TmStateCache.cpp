@@ -0,0 +1,88 @@
+#include "mcc/core/tm/StateCache.h"
+
+#include <gtest/gtest.h>
+
+using namespace mcc::messages;
+using mcc::core::tm::StateCache;
+
+static TmParams makeParams(int lat, int voltage)
+{
+    TmParams params;
+    params.emplace_back("nav", "lat", mcc::misc::NetVariant(lat));
+    params.emplace_back("power", "voltage", mcc::misc::NetVariant(voltage));
+    return params;
+}
+
+TEST(TmStateCache, keepsLatestValues)
+{
+    StateCache cache;
+    EXPECT_EQ(0u, cache.sequence());
+    cache.update("uav1", makeParams(1, 12), 100);
+    cache.update("uav2", makeParams(2, 11), 150);
+    cache.update("uav1", makeParams(3, 12), 200);
+    EXPECT_EQ(4u, cache.size());
+    EXPECT_EQ(6u, cache.sequence());
+
+    TmParamStates states;
+    cache.snapshot("uav1", "nav", "lat", &states);
+    ASSERT_EQ(1u, states.size());
+    EXPECT_EQ("uav1", states[0].device());
+    EXPECT_EQ(3, states[0].param().value().toInt());
+    EXPECT_EQ(200, states[0].time());
+    EXPECT_EQ(2u, states[0].updates());
+
+    states.clear();
+    cache.snapshot("uav1", "", "", &states);
+    EXPECT_EQ(2u, states.size());
+
+    states.clear();
+    cache.snapshot("", "power", "", &states);
+    ASSERT_EQ(2u, states.size());
+    EXPECT_EQ("voltage", states[0].param().status());
+
+    states.clear();
+    cache.snapshot("uav3", "", "", &states);
+    EXPECT_TRUE(states.empty());
+
+    //запоздавший кадр не затирает более новое значение
+    cache.update("uav1", makeParams(4, 12), 150);
+    states.clear();
+    cache.snapshot("uav1", "nav", "lat", &states);
+    ASSERT_EQ(1u, states.size());
+    EXPECT_EQ(3, states[0].param().value().toInt());
+    EXPECT_EQ(200, states[0].time());
+    EXPECT_EQ(6u, cache.sequence());
+}
+
+TEST(TmStateCache, changedSinceReturnsOnlyNewerInOrder)
+{
+    StateCache cache;
+    cache.update("uav1", makeParams(1, 12), 100);
+    cache.update("uav2", makeParams(2, 11), 100);
+    auto seen = cache.sequence();
+
+    TmParamStates states;
+    cache.changedSince(seen, "", "", "", &states);
+    EXPECT_TRUE(states.empty());
+
+    TmParams lat;
+    lat.emplace_back("nav", "lat", mcc::misc::NetVariant(5));
+    cache.update("uav2", lat, 200);
+    cache.update("uav1", lat, 300);
+    cache.update("uav2", lat, 400);
+
+    cache.changedSince(seen, "", "", "", &states);
+    ASSERT_EQ(2u, states.size());
+    EXPECT_EQ("uav1", states[0].device());
+    EXPECT_EQ("uav2", states[1].device());
+    EXPECT_EQ(400, states[1].time());
+
+    states.clear();
+    cache.changedSince(seen, "uav1", "", "", &states);
+    ASSERT_EQ(1u, states.size());
+    EXPECT_EQ(300, states[0].time());
+
+    states.clear();
+    cache.changedSince(0, "", "power", "", &states);
+    EXPECT_EQ(2u, states.size());
+}
@@ -0,0 +1,153 @@
+#include "mcc/core/tm/Subscriptions.h"
+
+#include <gtest/gtest.h>
+
+using namespace mcc::messages;
+using mcc::core::tm::Subscriptions;
+
+static TmParamsPtr makeParams()
+{
+    TmParams params;
+    params.emplace_back("nav", "lat", mcc::misc::NetVariant(1));
+    params.emplace_back("nav", "lon", mcc::misc::NetVariant(2));
+    params.emplace_back("power", "voltage", mcc::misc::NetVariant(3));
+    return std::make_shared<const TmParams>(std::move(params));
+}
+
+static const Subscriptions::Delivery* find(const std::vector<Subscriptions::Delivery>& deliveries, mcc::misc::NameId subscriber)
+{
+    for (const auto& i : deliveries)
+    {
+        if (i.subscriber == subscriber)
+            return &i;
+    }
+    return nullptr;
+}
+
+TEST(TmSubscriptions, routesByDeviceTraitAndStatus)
+{
+    Subscriptions subscriptions;
+    EXPECT_TRUE(subscriptions.add(1, "uav1", "", ""));
+    EXPECT_TRUE(subscriptions.add(2, "uav1", "nav", ""));
+    EXPECT_TRUE(subscriptions.add(3, "uav1", "power", "voltage"));
+    EXPECT_TRUE(subscriptions.add(4, "uav2", "", ""));
+    EXPECT_FALSE(subscriptions.add(3, "uav1", "power", "voltage"));
+
+    auto params = makeParams();
+    std::vector<Subscriptions::Delivery> out;
+    subscriptions.route("uav1", params, 0, &out);
+    ASSERT_EQ(3u, out.size());
+
+    //подписка на всё устройство разделяет список с исходным сообщением
+    ASSERT_NE(nullptr, find(out, 1));
+    EXPECT_EQ(params, find(out, 1)->params);
+
+    ASSERT_NE(nullptr, find(out, 2));
+    ASSERT_EQ(2u, find(out, 2)->params->size());
+    EXPECT_EQ("lat", (*find(out, 2)->params)[0].status());
+    EXPECT_EQ("lon", (*find(out, 2)->params)[1].status());
+
+    ASSERT_NE(nullptr, find(out, 3));
+    ASSERT_EQ(1u, find(out, 3)->params->size());
+    EXPECT_EQ("voltage", (*find(out, 3)->params)[0].status());
+
+    EXPECT_EQ(nullptr, find(out, 4));
+}
+
+TEST(TmSubscriptions, overlappingSubscriptionsDeliverOnce)
+{
+    Subscriptions subscriptions;
+    subscriptions.add(1, "uav1", "nav", "");
+    subscriptions.add(1, "uav1", "nav", "lat");
+    subscriptions.add(1, "", "nav", "lat");
+    subscriptions.add(2, "", "power", "");
+
+    std::vector<Subscriptions::Delivery> out;
+    subscriptions.route("uav1", makeParams(), 0, &out);
+    ASSERT_EQ(2u, out.size());
+    ASSERT_NE(nullptr, find(out, 1));
+    EXPECT_EQ(2u, find(out, 1)->params->size());
+    ASSERT_NE(nullptr, find(out, 2));
+    EXPECT_EQ(1u, find(out, 2)->params->size());
+}
+
+TEST(TmSubscriptions, unsubscribe)
+{
+    Subscriptions subscriptions;
+    subscriptions.add(1, "uav1", "nav", "lat");
+    subscriptions.add(1, "uav1", "power", "");
+    EXPECT_FALSE(subscriptions.remove(1, "uav1", "nav", ""));
+    EXPECT_FALSE(subscriptions.remove(2, "uav1", "nav", "lat"));
+    EXPECT_TRUE(subscriptions.remove(1, "uav1", "nav", "lat"));
+
+    std::vector<Subscriptions::Delivery> out;
+    subscriptions.route("uav1", makeParams(), 0, &out);
+    ASSERT_EQ(1u, out.size());
+    ASSERT_EQ(1u, out[0].params->size());
+    EXPECT_EQ("power", (*out[0].params)[0].trait());
+
+    EXPECT_TRUE(subscriptions.remove(1, "uav1", "power", ""));
+    EXPECT_TRUE(subscriptions.empty());
+    subscriptions.route("uav1", makeParams(), 0, &out);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(TmSubscriptions, rateLimitedSubscriberGetsLatestValue)
+{
+    const mcc::misc::Timestamp ms = 1000 * 1000;
+    Subscriptions subscriptions;
+    subscriptions.add(1, "uav1", "nav", "", 200 * ms);
+    subscriptions.add(2, "uav1", "", "");
+
+    auto frame = [](int lat) {
+        TmParams params;
+        params.emplace_back("nav", "lat", mcc::misc::NetVariant(lat));
+        params.emplace_back("power", "voltage", mcc::misc::NetVariant(12));
+        return std::make_shared<const TmParams>(std::move(params));
+    };
+
+    std::vector<Subscriptions::Delivery> out;
+    subscriptions.route("uav1", frame(1), 1000 * ms, &out);
+    ASSERT_EQ(2u, out.size());
+    ASSERT_NE(nullptr, find(out, 1));
+    EXPECT_EQ(1, (*find(out, 1)->params)[0].value().toInt());
+
+    //в пределах периода ограниченный подписчик ничего не получает, остальные - каждый кадр
+    subscriptions.route("uav1", frame(2), 1050 * ms, &out);
+    subscriptions.route("uav1", frame(3), 1100 * ms, &out);
+    ASSERT_EQ(1u, out.size());
+    EXPECT_EQ(2u, out[0].subscriber);
+    EXPECT_EQ(1200 * ms, subscriptions.nextFlush());
+
+    subscriptions.flush(1150 * ms, &out);
+    EXPECT_TRUE(out.empty());
+    subscriptions.flush(1200 * ms, &out);
+    ASSERT_EQ(1u, out.size());
+    EXPECT_EQ(1u, out[0].subscriber);
+    EXPECT_EQ("uav1", out[0].device);
+    ASSERT_EQ(1u, out[0].params->size());
+    EXPECT_EQ(3, (*out[0].params)[0].value().toInt());
+    EXPECT_EQ(0, subscriptions.nextFlush());
+
+    subscriptions.route("uav1", frame(4), 1400 * ms, &out);
+    ASSERT_NE(nullptr, find(out, 1));
+    EXPECT_EQ(4, (*find(out, 1)->params)[0].value().toInt());
+}
+
+TEST(TmSubscriptions, unsubscribeDropsHeldValues)
+{
+    const mcc::misc::Timestamp ms = 1000 * 1000;
+    Subscriptions subscriptions;
+    subscriptions.add(1, "uav1", "", "", 100 * ms);
+
+    std::vector<Subscriptions::Delivery> out;
+    subscriptions.route("uav1", makeParams(), 1000 * ms, &out);
+    ASSERT_EQ(1u, out.size());
+    EXPECT_EQ(3u, out[0].params->size());
+    subscriptions.route("uav1", makeParams(), 1010 * ms, &out);
+    EXPECT_TRUE(out.empty());
+
+    EXPECT_TRUE(subscriptions.remove(1, "uav1", "", ""));
+    subscriptions.flush(2000 * ms, &out);
+    EXPECT_TRUE(out.empty());
+}